@@ -0,0 +1,203 @@
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "hamarc/HamArchiver.hpp"
+
+static const std::filesystem::path BenchDir = std::filesystem::temp_directory_path() / "hamarc_bench";
+
+// Распределения размеров файлов в наборе данных
+enum Distribution {
+    kFewLarge,   // 4 файла по 1 МиБ
+    kManySmall,  // 256 файлов по 4 КиБ
+    kMixed       // 64 файла от 1 КиБ до 1 МиБ
+};
+
+static size_t GetFilesCount(Distribution distribution) {
+    switch (distribution) {
+        case kFewLarge:
+            return 4;
+        case kManySmall:
+            return 256;
+        default:
+            return 64;
+    }
+}
+
+static size_t GetFileSize(Distribution distribution, size_t index) {
+    switch (distribution) {
+        case kFewLarge:
+            return 1 << 20;
+        case kManySmall:
+            return 4 << 10;
+        default:
+            return static_cast<size_t>(1024) << (index % 11);
+    }
+}
+
+static std::string GetDistributionName(Distribution distribution) {
+    switch (distribution) {
+        case kFewLarge:
+            return "few_large";
+        case kManySmall:
+            return "many_small";
+        default:
+            return "mixed";
+    }
+}
+
+/**
+ * \brief Создаёт (один раз) файлы набора данных в BenchDir/<распределение>
+ * \return Файлы набора с данным размером блока; пути абсолютные
+*/
+static std::vector<HamArchiver::FileMetadata> PrepareDataset(Distribution distribution, 
+    size_t block_size, size_t& total_size) {
+
+    std::filesystem::path dir = BenchDir / GetDistributionName(distribution);
+    std::filesystem::create_directories(dir);
+    std::vector<HamArchiver::FileMetadata> files;
+    total_size = 0;
+    srand(distribution);
+    for (size_t i = 0; i < GetFilesCount(distribution); ++i) {
+        std::filesystem::path file = dir / ("file_" + std::to_string(i) + ".bin");
+        size_t size = GetFileSize(distribution, i);
+        if (!std::filesystem::exists(file) || std::filesystem::file_size(file) != size) {
+            std::string content(size, '\0');
+            for (size_t j = 0; j < size; ++j) {
+                content[j] = static_cast<char>(rand() % 256);
+            }
+            std::ofstream writer(file, std::ios::binary | std::ios::trunc);
+            writer.write(content.data(), size);
+        }
+        files.push_back(HamArchiver::FileMetadata{file, 0, block_size});
+        total_size += size;
+    }
+
+    return files;
+}
+
+static void CreateArchive(std::filesystem::path arcfile, 
+    const std::vector<HamArchiver::FileMetadata>& files) {
+
+    std::filesystem::remove(arcfile);
+    HamArchiver harchiver(BenchDir);
+    harchiver.Create(arcfile.string(), files);
+}
+
+static void SetDatasetCounters(benchmark::State& state, Distribution distribution, 
+    size_t total_size) {
+
+    state.SetBytesProcessed(state.iterations() * total_size);
+    state.SetLabel(GetDistributionName(distribution));
+}
+
+static void BM_Create(benchmark::State& state) {
+    Distribution distribution = static_cast<Distribution>(state.range(1));
+    size_t total_size;
+    std::vector<HamArchiver::FileMetadata> files = PrepareDataset(distribution, state.range(0), total_size);
+    std::filesystem::path arcfile = BenchDir / "create.haf";
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::filesystem::remove(arcfile);
+        state.ResumeTiming();
+        HamArchiver harchiver(BenchDir);
+        harchiver.Create(arcfile.string(), files);
+    }
+    std::filesystem::remove(arcfile);
+    SetDatasetCounters(state, distribution, total_size);
+}
+
+static void BM_GetFileList(benchmark::State& state) {
+    Distribution distribution = static_cast<Distribution>(state.range(1));
+    size_t total_size;
+    std::filesystem::path arcfile = BenchDir / "list.haf";
+    CreateArchive(arcfile, PrepareDataset(distribution, state.range(0), total_size));
+    HamArchiver harchiver(BenchDir);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(harchiver.GetFileList(arcfile));
+    }
+    std::filesystem::remove(arcfile);
+    state.SetLabel(GetDistributionName(distribution));
+}
+
+static void BM_ExtractFiles(benchmark::State& state) {
+    Distribution distribution = static_cast<Distribution>(state.range(1));
+    size_t total_size;
+    std::filesystem::path arcfile = BenchDir / "extract.haf";
+    CreateArchive(arcfile, PrepareDataset(distribution, state.range(0), total_size));
+    HamArchiver harchiver(BenchDir / "out");
+    harchiver.SetDir(BenchDir / "out");
+    for (auto _ : state) {
+        harchiver.ExtractFiles(arcfile);
+    }
+    std::filesystem::remove_all(BenchDir / "out");
+    std::filesystem::remove(arcfile);
+    SetDatasetCounters(state, distribution, total_size);
+}
+
+static void BM_DeleteFiles(benchmark::State& state) {
+    Distribution distribution = static_cast<Distribution>(state.range(1));
+    size_t total_size;
+    std::vector<HamArchiver::FileMetadata> files = PrepareDataset(distribution, state.range(0), total_size);
+    std::filesystem::path source = BenchDir / "delete_source.haf";
+    std::filesystem::path arcfile = BenchDir / "delete.haf";
+    CreateArchive(source, files);
+    // Удаляется каждый второй файл
+    std::vector<std::string> filenames;
+    for (size_t i = 0; i < files.size(); i += 2) {
+        filenames.push_back(files[i].path.filename().string());
+    }
+    HamArchiver harchiver(BenchDir);
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::filesystem::copy_file(source, arcfile, std::filesystem::copy_options::overwrite_existing);
+        state.ResumeTiming();
+        harchiver.DeleteFiles(arcfile, filenames);
+    }
+    std::filesystem::remove(source);
+    std::filesystem::remove(arcfile);
+    state.SetItemsProcessed(state.iterations() * filenames.size());
+    state.SetLabel(GetDistributionName(distribution));
+}
+
+static void BM_Merge(benchmark::State& state) {
+    Distribution distribution = static_cast<Distribution>(state.range(1));
+    size_t total_size;
+    std::vector<HamArchiver::FileMetadata> files = PrepareDataset(distribution, state.range(0), total_size);
+    std::vector<HamArchiver::FileMetadata> first_half(files.begin(), files.begin() + files.size() / 2);
+    std::vector<HamArchiver::FileMetadata> second_half(files.begin() + files.size() / 2, files.end());
+    std::vector<std::string> arcfiles{
+        (BenchDir / "merge_1.haf").string(), 
+        (BenchDir / "merge_2.haf").string()
+    };
+    CreateArchive(arcfiles[0], first_half);
+    CreateArchive(arcfiles[1], second_half);
+    std::filesystem::path arcfile = BenchDir / "merged.haf";
+    HamArchiver harchiver(BenchDir);
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::filesystem::remove(arcfile);
+        state.ResumeTiming();
+        harchiver.Merge(arcfile.string(), arcfiles);
+    }
+    std::filesystem::remove(arcfile);
+    std::filesystem::remove(arcfiles[0]);
+    std::filesystem::remove(arcfiles[1]);
+    SetDatasetCounters(state, distribution, total_size);
+}
+
+// Размеры блока кодирования и распределения размеров файлов
+#define HAMARC_DATASET_ARGS \
+    ArgsProduct({{256, 4096, 65536}, {kFewLarge, kManySmall, kMixed}}) \
+    ->ArgNames({"block", "dataset"}) \
+    ->Unit(benchmark::kMillisecond)
+
+BENCHMARK(BM_Create)->HAMARC_DATASET_ARGS;
+BENCHMARK(BM_GetFileList)->HAMARC_DATASET_ARGS;
+BENCHMARK(BM_ExtractFiles)->HAMARC_DATASET_ARGS;
+BENCHMARK(BM_DeleteFiles)->HAMARC_DATASET_ARGS;
+BENCHMARK(BM_Merge)->HAMARC_DATASET_ARGS;
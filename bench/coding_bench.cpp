@@ -0,0 +1,92 @@
+#include <cstdlib>
+#include <sstream>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "hamarc/BitOperator.hpp"
+#include "hamarc/Copydata.hpp"
+#include "hamarc/Decoder.hpp"
+#include "hamarc/Encoder.hpp"
+
+static std::vector<uint8_t> MakeRandomData(size_t size) {
+    std::vector<uint8_t> data(size);
+    srand(size);
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = rand() % 256;
+    }
+
+    return data;
+}
+
+// Блок с кодом, в который внесено errors_count ошибок в разных байтах
+static std::vector<uint8_t> MakeEncodedBlock(size_t block_size, size_t errors_count) {
+    std::vector<uint8_t> block = MakeRandomData(block_size);
+    size_t code_size = Encoder::GetCodeBitSize(block_size * 8) / 8 + 1;
+    block.resize(block_size + code_size);
+    Encoder::GetCode(block.data(), block_size, block.data() + block_size);
+    for (size_t i = 0; i < errors_count; ++i) {
+        BitOperator::FlipBit(block[(i * block_size / 2) % block_size + i], 3);
+    }
+
+    return block;
+}
+
+static void BM_GetCode(benchmark::State& state) {
+    size_t block_size = state.range(0);
+    std::vector<uint8_t> block = MakeRandomData(block_size);
+    uint8_t code[Encoder::kMaxCodeSize];
+    for (auto _ : state) {
+        Encoder::GetCode(block.data(), block_size, code);
+        benchmark::DoNotOptimize(code);
+    }
+    state.SetBytesProcessed(state.iterations() * block_size);
+}
+BENCHMARK(BM_GetCode)->RangeMultiplier(4)->Range(64, 1 << 20);
+
+static void BM_Validate(benchmark::State& state) {
+    size_t block_size = state.range(0);
+    size_t errors_count = state.range(1);
+    std::vector<uint8_t> block = MakeEncodedBlock(block_size, errors_count);
+    size_t error_bit;
+    for (auto _ : state) {
+        Decoder::ValidationResult res = Decoder::Validate(const_cast<const uint8_t*>(block.data()), 
+            block_size, block.data() + block_size, error_bit);
+        benchmark::DoNotOptimize(res);
+    }
+    state.SetBytesProcessed(state.iterations() * block_size);
+    state.SetLabel(errors_count == 0 ? "clean" : errors_count == 1 ? "single error" : "double error");
+}
+BENCHMARK(BM_Validate)
+    ->ArgsProduct({benchmark::CreateRange(64, 1 << 20, 16), {0, 1, 2}})
+    ->ArgNames({"block", "errors"});
+
+static void BM_CopyData(benchmark::State& state) {
+    size_t data_size = state.range(0);
+    std::vector<uint8_t> data = MakeRandomData(data_size);
+    std::string source(data.begin(), data.end());
+    for (auto _ : state) {
+        std::istringstream reader(source);
+        std::ostringstream writer;
+        Copydata::CopyData(reader, writer, data_size);
+        benchmark::DoNotOptimize(writer);
+    }
+    state.SetBytesProcessed(state.iterations() * data_size);
+}
+BENCHMARK(BM_CopyData)->RangeMultiplier(16)->Range(4096, 16 << 20);
+
+static void BM_BitOperator(benchmark::State& state) {
+    std::vector<uint8_t> data = MakeRandomData(4096);
+    for (auto _ : state) {
+        size_t bits_set = 0;
+        for (size_t i = 0; i < data.size(); ++i) {
+            uint8_t byte = BitOperator::Reflect(data[i]);
+            BitOperator::FlipBit(byte, i % 8);
+            BitOperator::SetBit(byte, (i + 3) % 8);
+            bits_set += BitOperator::GetBit(byte, (i + 5) % 8);
+        }
+        benchmark::DoNotOptimize(bits_set);
+    }
+    state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_BitOperator);
@@ -0,0 +1,33 @@
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+// Если файл результатов не указан явно, они сохраняются в hamarc_bench.json: 
+// JSON-отчёты разных версий сравниваются скриптом tools/compare.py из Google Benchmark
+int main(int argc, char** argv) {
+    std::vector<char*> args(argv, argv + argc);
+    bool out_specified = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], "--benchmark_out=", 16) == 0) {
+            out_specified = true;
+        }
+    }
+    std::string out_arg = "--benchmark_out=hamarc_bench.json";
+    std::string format_arg = "--benchmark_out_format=json";
+    if (!out_specified) {
+        args.push_back(out_arg.data());
+        args.push_back(format_arg.data());
+    }
+    int args_count = static_cast<int>(args.size());
+
+    benchmark::Initialize(&args_count, args.data());
+    if (benchmark::ReportUnrecognizedArguments(args_count, args.data())) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    return 0;
+}
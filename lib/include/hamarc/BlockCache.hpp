@@ -0,0 +1,110 @@
+#ifndef BLOCKCACHE_HPP
+#define BLOCKCACHE_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/**
+ * \brief Кэш проверенных и декодированных блоков архивов с вытеснением
+ * давно не использованных (LRU).
+ * Блок определяется идентификатором архива и смещением закодированного блока в нём.
+ * Кэш разделён на сегменты с собственными блокировками, поэтому может
+ * использоваться из нескольких потоков.
+ * \note По умолчанию ёмкость равна 0 и кэш выключен
+*/
+class BlockCache {
+public:
+    BlockCache();
+    ~BlockCache();
+    BlockCache(const BlockCache&) = delete;
+    BlockCache& operator=(const BlockCache&) = delete;
+
+/**
+ * \brief Задаёт ёмкость кэша (в байтах данных блоков) и очищает его; 0 - выключает кэш
+ * \attention Не должна вызываться одновременно с другими операциями
+*/
+    void SetCapacity(size_t capacity);
+    size_t GetCapacity() const;
+    bool IsEnabled() const;
+
+/**
+ * \brief Возвращает идентификатор состояния архива
+ * \param path Абсолютный путь к архиву
+ * \param size, write_time Размер и время изменения архива
+ * \note Если размер или время изменения отличаются от известных, архиву
+ * выдаётся новый идентификатор: блоки прежнего состояния больше не находятся
+ * и вытесняются со временем. Идентификаторы начинаются с 1
+*/
+    uint64_t GetArchiveId(const std::filesystem::path& path, size_t size,
+        std::filesystem::file_time_type write_time);
+
+/**
+ * \brief Делает недействительными блоки архива, изменённого без смены
+ * размера и времени изменения (например, в пределах точности времени файловой системы)
+*/
+    void Invalidate(const std::filesystem::path& path);
+
+/**
+ * \brief Копирует блок в data
+ * \return false, если блока нет в кэше
+*/
+    bool Get(uint64_t archive_id, size_t block_offset, uint8_t* data, size_t size);
+
+/**
+ * \brief Помещает блок в кэш, вытесняя давно не использованные блоки сегмента
+ * \note Блоки больше ёмкости сегмента не кэшируются
+*/
+    void Put(uint64_t archive_id, size_t block_offset, const uint8_t* data, size_t size);
+
+    void Clear();
+
+private:
+    static constexpr size_t kShardsCount = 16;
+
+    struct Key {
+        uint64_t archive_id;
+        size_t block_offset;
+
+        bool operator==(const Key& other) const {
+            return archive_id == other.archive_id && block_offset == other.block_offset;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const;
+    };
+
+    struct Block {
+        Key key;
+        uint8_t* data;
+        size_t size;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::list<Block> blocks;  // от недавно использованных к давно использованным
+        std::unordered_map<Key, std::list<Block>::iterator, KeyHash> positions;
+        size_t size = 0;
+    };
+
+    struct ArchiveState {
+        uint64_t id;
+        size_t size;
+        std::filesystem::file_time_type write_time;
+    };
+
+    Shard& GetShard(const Key& key);
+    void ClearShard(Shard& shard);
+
+    size_t capacity_;
+    Shard shards_[kShardsCount];
+    std::mutex archives_mutex_;
+    std::unordered_map<std::string, ArchiveState> archives_;
+    uint64_t next_id_;
+};
+
+#endif  // BLOCKCACHE_HPP
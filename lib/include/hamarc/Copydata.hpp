@@ -1,6 +1,7 @@
 #ifndef COPYDATA_HPP
 #define COPYDATA_HPP
 
+#include <filesystem>
 #include <fstream>
 
 class Copydata {
@@ -12,9 +13,31 @@ public:
     };
 
     static CopyingResult CopyData(std::istream& read_from, std::ostream& write_to, size_t data_size);
+
+/**
+ * \brief Копирует участок одного файла в другой, не изменяя остальных данных
+ * \param src Исходный файл
+ * \param src_offset Начало участка в исходном файле
+ * \param dst Файл назначения; должен существовать
+ * \param dst_offset Начало участка в файле назначения
+ * \param data_size Размер участка (в байтах)
+ * \note Сначала пробуется клонирование блоков файловой системы (FICLONERANGE),
+ * затем copy_file_range, затем pread/pwrite через выровненный буфер. Файлы 
+ * открываются заново, поэтому участки можно копировать из нескольких потоков
+*/
+    static CopyingResult CopyRange(const std::filesystem::path& src, size_t src_offset, 
+        const std::filesystem::path& dst, size_t dst_offset, size_t data_size);
     
 private:
     static const size_t kMaxBufferSize;
+    static const size_t kRangeBufferSize;
+
+    static bool CloneRange(int src_fd, size_t src_offset, int dst_fd, size_t dst_offset, 
+        size_t data_size);
+    static size_t CopyFileRange(int src_fd, size_t src_offset, int dst_fd, size_t dst_offset, 
+        size_t data_size);
+    static size_t CopyBuffered(int src_fd, size_t src_offset, int dst_fd, size_t dst_offset, 
+        size_t data_size);
 };
 
 #endif  // COPYDATA_HPP
@@ -4,6 +4,8 @@
 #include <fstream>
 #include <cstdint>
 
+#include "DecoderContext.hpp"
+
 /**
  * \brief Декодировщик.
  * Обнаруживает ошибки в сообщении, закодированном расширенным кодом Хэмминга. 
@@ -27,12 +29,40 @@ public:
  * \attention Для входных данных должны выполняться гарантии:
  * сообщение не пусто, код сообщения идёт после него и имеет корректный размер
  * \note По завершении позиция потока перемещается в начало сообщения. В случае
- * исправления ошибки буфер потока очищается.
+ * исправления ошибки сообщение и его код перезаписываются, буфер потока очищается.
 */
     static ValidationResult Validate(std::fstream& msg, size_t raw_msg_size);
 
-private:
-    static void FixBit(std::fstream& msg, std::streamoff error_bit_pos);
+/**
+ * \brief Проверяет и исправляет сообщение в потоке, считывая его в буфер контекста
+ * (в установившемся режиме память не выделяется)
+*/
+    static ValidationResult Validate(std::fstream& msg, size_t raw_msg_size, DecoderContext& context);
+
+/**
+ * \brief Проверяет наличие и исправляет ошибки в сообщении, 
+ * закодированном с помощью расширенного кода Хэмминга.
+ * Синдром и общая чётность вычисляются за один проход по сообщению.
+ * \param block Информационная часть сообщения. Единичная ошибка в ней 
+ * исправляется на месте
+ * \param raw_msg_size Размер информационной части сообщения (в байтах)
+ * \param code Код сообщения
+ * \note Единичная ошибка в самом коде не требует изменения сообщения: 
+ * возвращается kSingleErrorFixed, код не изменяется
+*/
+    static ValidationResult Validate(uint8_t* block, size_t raw_msg_size, const uint8_t* code);
+
+/**
+ * \brief Проверяет сообщение, не изменяя его. Подходит для данных, 
+ * доступных только для чтения
+ * \param error_bit Номер ошибочного бита информационной части 
+ * (считая от старшего бита первого байта), либо kNoDataError, если 
+ * исправлять информационную часть не требуется
+*/
+    static ValidationResult Validate(const uint8_t* block, size_t raw_msg_size, 
+        const uint8_t* code, size_t& error_bit);
+
+    static const size_t kNoDataError;
 };
 
 #endif  // DECODER_HPP
@@ -0,0 +1,50 @@
+#ifndef DECODERCONTEXT_HPP
+#define DECODERCONTEXT_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * \brief Рабочая память декодировщика, переиспользуемая между вызовами.
+ * Содержит выровненные буферы для закодированного блока (блок и его код) 
+ * и для исправленной копии блока, поэтому проверка очередного блока 
+ * не требует выделения памяти.
+ * \attention Контекст не должен использоваться несколькими потоками одновременно
+*/
+class DecoderContext {
+public:
+    static const size_t kAlignment;
+
+    DecoderContext();
+    DecoderContext(size_t max_block_size);
+    ~DecoderContext();
+    DecoderContext(const DecoderContext&) = delete;
+    DecoderContext& operator=(const DecoderContext&) = delete;
+
+/**
+ * \brief Гарантирует, что буферы вмещают блок размера max_block_size и его код
+ * \note Буферы только увеличиваются; содержимое при увеличении не сохраняется
+*/
+    void Reserve(size_t max_block_size);
+
+/**
+ * \brief Буфер закодированного блока: блок размера n и его код, начиная с позиции n
+*/
+    uint8_t* GetEncodedBuffer();
+
+/**
+ * \brief Буфер для исправленной копии блока
+*/
+    uint8_t* GetFixBuffer();
+
+    size_t GetMaxBlockSize() const;
+
+private:
+    void Release();
+
+    uint8_t* encoded_buffer_;
+    uint8_t* fix_buffer_;
+    size_t max_block_size_;
+};
+
+#endif  // DECODERCONTEXT_HPP
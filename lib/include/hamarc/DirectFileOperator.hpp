@@ -0,0 +1,35 @@
+#ifndef DIRECTFILEOPERATOR_HPP
+#define DIRECTFILEOPERATOR_HPP
+
+#include "DiskFileOperator.hpp"
+
+/**
+ * \brief Файлы на диске, читаемые и записываемые в обход кэша страниц (O_DIRECT),
+ * чтобы обработка очень больших архивов не вытесняла из памяти данные других программ.
+ * Обращения выравниваются по kDirectAlignment через выровненные буферы: 
+ * неполные первый и последний блоки записи дочитываются с диска 
+ * (последний записанный блок хранится в памяти), а файл после записи 
+ * обрезается до настоящего размера. Дескрипторы одного файла выполняют 
+ * записи по очереди и хранят последний блок общим, чтобы параллельные 
+ * записи соседних участков не затирали общие блоки
+ * \note Если система или файловая система не поддерживает O_DIRECT (например, tmpfs), 
+ * файл открывается как у FdFileOperator. Файлы не отображаются в память, 
+ * а участки копируются через те же выровненные буферы
+*/
+class DirectFileOperator : public FdFileOperator {
+public:
+    using FdFileOperator::FdFileOperator;
+
+    // Логический блок большинства дисков - 512 байт или 4 КиБ
+    static constexpr size_t kDirectAlignment = 4096;
+
+    bool OpenMapped(std::filesystem::path file, MappedFile& mapping) override;
+    bool CopyRange(std::filesystem::path src, size_t src_offset, 
+        std::filesystem::path dst, size_t dst_offset, size_t size) override;
+
+protected:
+    std::unique_ptr<RandomAccessFile> OpenFile(const std::filesystem::path& file, 
+        bool writable, bool create, bool truncate) override;
+};
+
+#endif  // DIRECTFILEOPERATOR_HPP
@@ -0,0 +1,85 @@
+#ifndef DISKFILEOPERATOR_HPP
+#define DISKFILEOPERATOR_HPP
+
+#include "FileOperator.hpp"
+
+/**
+ * \brief Хранилище файлов на диске: общие операции над файлами и директориями
+ * выполняются через std::filesystem, без открытия файлов
+*/
+class DiskFileOperator : public FileOperator {
+public:
+    using FileOperator::FileOperator;
+
+/**
+ * \brief Создаёт хранилище на диске, наиболее подходящее для системы:
+ * FdFileOperator в POSIX-системах, StreamFileOperator в остальных
+*/
+    static std::shared_ptr<FileOperator> CreateDefault(std::filesystem::path init_dir);
+
+    void SetDir(std::filesystem::path new_dir) override;
+
+    bool FileExists(std::filesystem::path filename) override;
+    size_t GetFileSize(std::filesystem::path filename) override;
+    std::filesystem::file_time_type GetLastWriteTime(std::filesystem::path filename) override;
+    std::filesystem::path GetPath(std::filesystem::path filename) override;
+
+    bool CreateDir(std::filesystem::path name) override;
+    bool DeleteFile(std::filesystem::path filename) override;
+    size_t DeleteDir(std::filesystem::path name) override;
+    void RenameFile(std::filesystem::path old_name, 
+        std::filesystem::path new_name) override;
+    void ResizeFile(std::filesystem::path filename, size_t new_size) override;
+    bool SyncDir(std::filesystem::path name) override;
+
+    bool OpenMapped(std::filesystem::path file, MappedFile& mapping) override;
+
+/**
+ * \brief Копирует участок через Copydata::CopyRange (клонирование блоков, 
+ * copy_file_range или pread/pwrite)
+*/
+    bool CopyRange(std::filesystem::path src, size_t src_offset, 
+        std::filesystem::path dst, size_t dst_offset, size_t size) override;
+};
+
+/**
+ * \brief Файлы на диске, открываемые через std::fstream. Работает в любой системе
+*/
+class StreamFileOperator : public DiskFileOperator {
+public:
+    using DiskFileOperator::DiskFileOperator;
+
+protected:
+    std::unique_ptr<RandomAccessFile> OpenFile(const std::filesystem::path& file, 
+        bool writable, bool create, bool truncate) override;
+};
+
+/**
+ * \brief Файлы на диске, открываемые как дескрипторы POSIX: чтение и запись 
+ * выполняются через pread и pwrite
+ * \note В системах без POSIX файлы не открываются
+*/
+class FdFileOperator : public DiskFileOperator {
+public:
+    using DiskFileOperator::DiskFileOperator;
+
+protected:
+    std::unique_ptr<RandomAccessFile> OpenFile(const std::filesystem::path& file, 
+        bool writable, bool create, bool truncate) override;
+};
+
+/**
+ * \brief Файлы на диске, открываемые только для чтения, отображаются в память
+ * и читаются без копирования в буфер потока; остальные открываются как у FdFileOperator
+ * \attention Файл не должен уменьшаться, пока открыт для чтения
+*/
+class MappedFileOperator : public FdFileOperator {
+public:
+    using FdFileOperator::FdFileOperator;
+
+protected:
+    std::unique_ptr<RandomAccessFile> OpenFile(const std::filesystem::path& file, 
+        bool writable, bool create, bool truncate) override;
+};
+
+#endif  // DISKFILEOPERATOR_HPP
@@ -3,6 +3,7 @@
 
 #include <fstream>
 #include "BitOperator.hpp"
+#include "EncoderContext.hpp"
 
 
 /**
@@ -18,6 +19,21 @@ public:
         kReaderCorrupted
     };
 
+/**
+ * \brief Синдром сообщения: XOR номеров позиций (при вставке контрольных бит в 
+ * сообщение, нумерация с 1) всех единичных информационных бит и их общая чётность
+*/
+    struct Syndrome {
+        size_t positions;
+        bool parity;
+    };
+
+/**
+ * \brief Наибольший размер кода сообщения в байтах: 
+ * синдром занимает не более 64 бит, и ещё один байт - бит чётности
+*/
+    static constexpr size_t kMaxCodeSize = 9;
+
 /**
  * \brief Вычисляет количество контрольных бит для кодирования сообщения данного размера в коде Хэмминга
  * \attention Вычисляется размер классического, а не расширенного кода Хэмминга (без бита чётности)
@@ -41,6 +57,15 @@ public:
 */
     static bool GetMsgParityBit(const uint8_t* msg, size_t raw_msg_size);
 
+/**
+ * \brief Вычисляет синдром сообщения, обрабатывая его машинными словами
+ * \param msg Сообщение
+ * \param raw_msg_size Размер сообщения в байтах
+ * \note Биты синдрома с номерами 0..GetCodeBitSize(raw_msg_size * 8) - 1 
+ * совпадают с контрольными битами классического кода Хэмминга
+*/
+    static Syndrome GetSyndrome(const uint8_t* msg, size_t raw_msg_size);
+
 /**
  * \brief Вычисляет расширенный код Хэмминга для сообщения
  * \param reader Поток ввода сообщения. Чтение начинается с исходной позиции.
@@ -61,6 +86,14 @@ public:
 */
     static uint8_t* GetCode(const uint8_t* msg, size_t raw_msg_size);
 
+/**
+ * \brief Вычисляет расширенный код Хэмминга для сообщения без выделения памяти
+ * \param msg Сообщение
+ * \param raw_msg_size Размер кодируемого сообщения в байтах
+ * \param control_bytes Буфер для кода размером GetCodeBitSize(raw_msg_size * 8) / 8 + 1 байт
+*/
+    static void GetCode(const uint8_t* msg, size_t raw_msg_size, uint8_t* control_bytes);
+
 /**
  * \brief Вычисляет расширенный код Хэмминга для сообщения и записывает его
  * \param reader Поток ввода сообщения. Чтение начинается с исходной позиции
@@ -73,6 +106,13 @@ public:
     static EncodingResult EncodeAndWrite(
         std::istream& reader, std::ostream& writer, size_t raw_msg_size);
 
+/**
+ * \brief Вычисляет расширенный код Хэмминга для сообщения и записывает его, 
+ * считывая сообщение в буфер контекста
+*/
+    static EncodingResult EncodeAndWrite(
+        std::istream& reader, std::ostream& writer, size_t raw_msg_size, EncoderContext& context);
+
 /**
  * \brief Вычисляет расширенный код Хэмминга для сообщения и записывает его
  * \param msg Сообщение
@@ -82,14 +122,56 @@ public:
     static EncodingResult EncodeAndWrite(
         const uint8_t* msg, std::ostream& writer, size_t raw_msg_size);
 
+/**
+ * \brief Кодирует данные поблочно и записывает каждый блок вместе с его кодом
+ * \param reader Поток ввода данных. Каждый байт считывается ровно один раз, 
+ * перемещение позиции не требуется
+ * \param writer Поток вывода последовательности <блок><код блока>
+ * \param data_size Размер кодируемых данных в байтах
+ * \param block_size Размер блока кодирования в байтах
+ * \note Если поток ввода закончился раньше, кодируется считанная часть данных,
+ * а результат - kReaderEOFReached
+ */
+    static EncodingResult EncodeBlocks(std::istream& reader, std::ostream& writer, 
+        size_t data_size, size_t block_size);
+
+/**
+ * \brief Кодирует данные поблочно, используя буфер контекста 
+ * (в установившемся режиме память не выделяется)
+*/
+    static EncodingResult EncodeBlocks(std::istream& reader, std::ostream& writer, 
+        size_t data_size, size_t block_size, EncoderContext& context);
+
 private:
     static const size_t kMaxBufferSize;
 
-    static void ShiftAndRead(
-        std::istream& reader, std::streamoff offset, 
-        size_t data_size, char* buf);
-        
     static bool GetByteParityBit(uint8_t byte, size_t number_of_bits);
+
+    static bool GetWordParityBit(uint64_t word);
+
+/**
+ * \brief Считывает 8 байт сообщения, начиная с байта word_index * 8, 
+ * в машинное слово (старший бит слова - первый бит сообщения)
+ * \note Байты за пределами сообщения считаются нулевыми
+*/
+    static uint64_t LoadWord(const uint8_t* msg, size_t raw_msg_size, size_t word_index);
+
+/**
+ * \brief Учитывает слово участка сообщения в XOR слов участка и XOR номеров окон
+ * \param window Номер окна позиций, в которое попадают младшие (по маске low_mask) биты слова
+*/
+    static void AccumulateWord(uint64_t word, size_t window, uint64_t low_mask,
+        uint64_t& run_word, size_t& window_xor);
+
+/**
+ * \brief Вычисляет вклад в синдром слов одного участка сообщения, 
+ * в пределах которого позиции бит смещены на одну и ту же величину
+ * \param word XOR всех слов участка
+ * \param window_xor XOR номеров 64-битных окон позиций, содержащих нечётное 
+ * число единичных бит участка
+ * \param offset Смещение позиции бита относительно его номера в сообщении
+*/
+    static size_t GetRunSyndrome(uint64_t word, size_t window_xor, size_t offset);
 };
 
 #endif  // ENCODER_HPP
@@ -0,0 +1,41 @@
+#ifndef ENCODERCONTEXT_HPP
+#define ENCODERCONTEXT_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * \brief Рабочая память кодировщика, переиспользуемая между вызовами.
+ * Содержит выровненный буфер для блока и его кода, поэтому кодирование 
+ * очередного блока не требует выделения памяти.
+ * \attention Контекст не должен использоваться несколькими потоками одновременно
+*/
+class EncoderContext {
+public:
+    static const size_t kAlignment;
+
+    EncoderContext();
+    EncoderContext(size_t max_block_size);
+    ~EncoderContext();
+    EncoderContext(const EncoderContext&) = delete;
+    EncoderContext& operator=(const EncoderContext&) = delete;
+
+/**
+ * \brief Гарантирует, что буфер вмещает блок размера max_block_size и его код
+ * \note Буфер только увеличивается; содержимое при увеличении не сохраняется
+*/
+    void Reserve(size_t max_block_size);
+
+/**
+ * \brief Буфер блока. Код блока размера n можно записать, начиная с GetBuffer() + n
+*/
+    uint8_t* GetBuffer();
+
+    size_t GetMaxBlockSize() const;
+
+private:
+    uint8_t* buffer_;
+    size_t max_block_size_;
+};
+
+#endif  // ENCODERCONTEXT_HPP
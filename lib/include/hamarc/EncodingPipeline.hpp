@@ -0,0 +1,79 @@
+#ifndef ENCODINGPIPELINE_HPP
+#define ENCODINGPIPELINE_HPP
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#include "Encoder.hpp"
+
+/**
+ * \brief Многопоточный конвейер кодирования.
+ * Поток чтения загружает пакеты блоков, пул потоков вычисляет их коды,
+ * а вызывающий поток записывает блоки в исходном порядке в формате <блок><контроль>.
+ * Результат совпадает с последовательным кодированием байт в байт.
+*/
+class EncodingPipeline {
+public:
+/**
+ * \param threads_count Количество потоков, вычисляющих коды
+ * \param max_inflight_size Ограничение суммарного размера пакетов, одновременно
+ * находящихся в памяти (в байтах). Пакет содержит не менее одного блока.
+*/
+    EncodingPipeline(size_t threads_count, size_t max_inflight_size);
+
+/**
+ * \brief Кодирует данные блоками и записывает их вместе с кодами
+ * \param reader Поток ввода данных. Чтение начинается с исходной позиции
+ * \param writer Поток вывода закодированных данных
+ * \param data_size Размер данных (в байтах)
+ * \param block_size Размер кодируемого блока (в байтах)
+ * \note Если данные закончились раньше, недостающие байты кодируются как нулевые,
+ * а результат - kReaderEOFReached
+*/
+    Encoder::EncodingResult Run(std::istream& reader, std::ostream& writer,
+        size_t data_size, size_t block_size);
+
+private:
+    static const size_t kBatchesCount;
+
+    enum class BatchState {
+        kFree,
+        kFilled,
+        kEncoded
+    };
+
+    struct Batch {
+        BatchState state;
+        size_t sequence;
+        size_t first_block;
+        size_t blocks_count;
+        size_t next_block;      // первый блок пакета, не взятый на кодирование
+        size_t encoded_blocks;
+        uint8_t* data;
+        uint8_t* codes;
+    };
+
+    size_t threads_count;
+    size_t max_inflight_size;
+
+    std::mutex mutex;
+    std::condition_variable state_changed;
+    std::vector<Batch> batches;
+    size_t data_size;
+    size_t block_size;
+    size_t code_size;
+    size_t blocks_total;
+    size_t batch_blocks;
+    size_t blocks_claimed;
+    bool reader_eof_reached;
+
+    void ReadBatches(std::istream& reader);
+    void EncodeBlocks();
+    void WriteBatches(std::ostream& writer);
+
+    size_t GetBlockSize(size_t block) const;
+    Batch* FindClaimableBatch();
+};
+
+#endif  // ENCODINGPIPELINE_HPP
@@ -3,33 +3,95 @@
 
 #include <filesystem>
 #include <fstream>
+#include <memory>
 
+#include "FileStream.hpp"
+#include "MappedFile.hpp"
+
+/**
+ * \brief Хранилище файлов архиватора. Пути отсчитываются от рабочей директории.
+ * Реализации: файлы на диске (см. DiskFileOperator) и файловая система 
+ * в памяти (см. MemoryFileOperator)
+ * \note Методы могут вызываться из нескольких потоков одновременно
+*/
 class FileOperator {
 public:
     FileOperator();
     FileOperator(std::filesystem::path init_dir);
-    void SetDir(std::filesystem::path new_dir);
+    virtual ~FileOperator() = default;
+    FileOperator(const FileOperator&) = delete;
+    FileOperator& operator=(const FileOperator&) = delete;
+
+    virtual void SetDir(std::filesystem::path new_dir);
+
+    virtual bool FileExists(std::filesystem::path filename) = 0;
+    virtual size_t GetFileSize(std::filesystem::path filename) = 0;
+    virtual std::filesystem::file_time_type GetLastWriteTime(std::filesystem::path filename) = 0;
 
-    bool FileExists(std::filesystem::path filename);
-    size_t GetFileSize(std::filesystem::path filename);
+/**
+ * \brief Возвращает абсолютный путь к файлу рабочей директории
+*/
+    virtual std::filesystem::path GetPath(std::filesystem::path filename);
 
+/**
+ * \brief Создаёт новый, либо очищает уже существующий файл
+*/
     bool CreateFile(std::filesystem::path filename);
-    bool CreateDir(std::filesystem::path name);
-    bool DeleteFile(std::filesystem::path filename);
-    size_t DeleteDir(std::filesystem::path name);
-    void RenameFile(std::filesystem::path old_name, 
-        std::filesystem::path new_name);
-
-    bool OpenForReading(std::filesystem::path file, std::ifstream& stream, 
-        std::ifstream::openmode openmode);
-    bool OpenForWriting(std::filesystem::path file, std::ofstream& stream, 
-        std::ofstream::openmode openmode);
-    bool Open(std::filesystem::path file, std::fstream& stream, 
-        std::fstream::openmode openmode);
-    
+    virtual bool CreateDir(std::filesystem::path name) = 0;
+    virtual bool DeleteFile(std::filesystem::path filename) = 0;
+    virtual size_t DeleteDir(std::filesystem::path name) = 0;
+    virtual void RenameFile(std::filesystem::path old_name, 
+        std::filesystem::path new_name) = 0;
+    virtual void ResizeFile(std::filesystem::path filename, size_t new_size) = 0;
+
+/**
+ * \brief Сохраняет на устройстве содержимое директории (например, после 
+ * переименования файла в ней)
+ * \note По умолчанию ничего не делает
+*/
+    virtual bool SyncDir(std::filesystem::path name);
+
+/**
+ * \brief Открывают файл так же, как одноимённые потоки std::ifstream, 
+ * std::ofstream и std::fstream с данным режимом
+ * \return false, если файл не удалось открыть
+*/
+    bool OpenForReading(std::filesystem::path file, FileStream& stream, 
+        std::ios::openmode openmode);
+    bool OpenForWriting(std::filesystem::path file, FileStream& stream, 
+        std::ios::openmode openmode);
+    bool Open(std::filesystem::path file, FileStream& stream, 
+        std::ios::openmode openmode);
+
+/**
+ * \brief Отображает файл в память только для чтения
+ * \return false, если хранилище не поддерживает отображение
+*/
+    virtual bool OpenMapped(std::filesystem::path file, MappedFile& mapping);
+
+/**
+ * \brief Копирует участок файла src в существующий файл dst
+ * \return false, если участок скопирован не полностью
+ * \note По умолчанию копирует через буфер, открывая файлы заново
+*/
+    virtual bool CopyRange(std::filesystem::path src, size_t src_offset, 
+        std::filesystem::path dst, size_t dst_offset, size_t size);
+
+protected:
+/**
+ * \brief Открывает файл хранилища
+ * \param writable Файл открывается для записи
+ * \param create Отсутствующий файл создаётся
+ * \param truncate Содержимое файла удаляется
+ * \return nullptr, если файл не удалось открыть
+*/
+    virtual std::unique_ptr<RandomAccessFile> OpenFile(const std::filesystem::path& file, 
+        bool writable, bool create, bool truncate) = 0;
 
-private:
     std::filesystem::path dir_;
+
+private:
+    static const size_t kCopyBufferSize;
 };
 
 #endif  // FILEOPERATOR_HPP
@@ -0,0 +1,128 @@
+#ifndef FILESTREAM_HPP
+#define FILESTREAM_HPP
+
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <streambuf>
+
+/**
+ * \brief Открытый файл хранилища с чтением и записью по смещению (см. FileOperator).
+ * \note Обращения не меняют общей позиции, поэтому один файл можно открыть 
+ * несколько раз и читать из разных потоков
+*/
+class RandomAccessFile {
+public:
+    virtual ~RandomAccessFile() = default;
+
+/**
+ * \return Количество прочитанных байт: меньше size только в конце файла или при ошибке
+*/
+    virtual size_t ReadAt(size_t offset, uint8_t* data, size_t size) = 0;
+
+/**
+ * \brief Записывает данные, при необходимости увеличивая файл
+ * \return false, если данные записаны не полностью
+*/
+    virtual bool WriteAt(size_t offset, const uint8_t* data, size_t size) = 0;
+
+    virtual size_t GetSize() = 0;
+
+/**
+ * \brief Возвращает содержимое файла, если оно целиком доступно 
+ * без копирования (например, отображено в память) и не меняется
+ * \return nullptr, если данные читаются только через ReadAt
+*/
+    virtual const uint8_t* GetData() {
+        return nullptr;
+    }
+
+/**
+ * \brief Дожидается завершения отложенных (асинхронных) записей
+ * \return false, если какая-либо из них не удалась
+*/
+    virtual bool Sync() {
+        return true;
+    }
+
+/**
+ * \brief Дожидается записей и сохраняет данные на устройстве (как fsync), 
+ * чтобы они пережили сбой системы
+*/
+    virtual bool SyncToDevice() {
+        return Sync();
+    }
+};
+
+/**
+ * \brief Поток чтения и записи файла хранилища, буферизующий обращения к RandomAccessFile.
+ * Позиция чтения и записи общая, как у std::fstream; большие чтения и записи 
+ * выполняются в обход буфера, а данные отображённого файла читаются без копирования
+*/
+class FileStream : public std::iostream {
+public:
+    FileStream();
+
+/**
+ * \param append Запись всегда выполняется в конец файла (как std::ios::app)
+*/
+    void Open(std::unique_ptr<RandomAccessFile> file, bool append);
+    bool IsOpen() const;
+
+/**
+ * \brief Записывает буфер и закрывает файл; при ошибке записи выставляет failbit
+*/
+    void Close();
+
+/**
+ * \brief Записывает буфер и сохраняет данные файла на устройстве 
+ * (см. RandomAccessFile::SyncToDevice); при ошибке выставляет failbit
+*/
+    bool SyncToDevice();
+
+private:
+    class FileBuf : public std::streambuf {
+    public:
+        FileBuf();
+        ~FileBuf();
+        FileBuf(const FileBuf&) = delete;
+        FileBuf& operator=(const FileBuf&) = delete;
+
+        void Open(std::unique_ptr<RandomAccessFile> file, bool append);
+        bool IsOpen() const;
+        bool Close();
+        bool SyncToDevice();
+
+    protected:
+        int_type underflow() override;
+        std::streamsize xsgetn(char* s, std::streamsize count) override;
+        int_type overflow(int_type ch) override;
+        std::streamsize xsputn(const char* s, std::streamsize count) override;
+        pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override;
+        pos_type seekpos(pos_type pos, std::ios_base::openmode which) override;
+        int sync() override;
+
+    private:
+        static const size_t kBufferSize;
+
+        size_t GetPosition() const;
+
+/**
+ * \brief Сбрасывает области чтения и записи, устанавливая позицию
+*/
+        void Reset(size_t pos);
+        void StartWriting();
+        bool StopWriting();
+        bool FlushWrites();
+
+        std::unique_ptr<RandomAccessFile> file_;
+        const uint8_t* data_;   // содержимое файла, доступное без копирования
+        char* buf_;
+        size_t pos_;            // смещение в файле начала области чтения или записи
+        bool append_;
+    };
+
+    FileBuf buf_;
+};
+
+#endif  // FILESTREAM_HPP
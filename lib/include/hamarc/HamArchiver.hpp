@@ -4,9 +4,25 @@
 - Для каждого файла хранятся метаданные:
     <размер названия (байты)><размер содержимого (байты)>
     <размер кодируемого блока (байты)><контроль><название><контроль>
-    Размеры указываются в байтах и занимают соответственно 4, 8 и 8 байт
+    Размеры указываются в байтах и занимают соответственно 4, 8 и 8 байт.
+    Старший бит размера названия - признак удалённого файла: удаление лишь
+    выставляет его, а место освобождается уплотнением архива.
+    Следующий бит - признак файла, записанного из потока неизвестной длины:
+    размер содержимого в его метаданных равен 0
 - Файлы храняться друг за другом непрерывно в формате:
     <метаданные, контроль><содержимое><контроль содержимого>
+- Содержимое файла из потока разбито на порции:
+    <размер порции (8 байт)><контроль><содержимое порции><контроль содержимого>
+    Все порции, кроме последней, содержат по kStreamChunkSize байт, округлённых
+    вниз до размера блока (но не меньше блока). Завершает файл порция размера 0
+- В конце архива может располагаться оглавление:
+    <записи оглавления, закодированные блоками по 4096 байт>
+    <"HAFINDEX"><смещение оглавления><размер записей><контроль>
+    Запись оглавления: <смещение метаданных файла><размер содержимого>
+    <размер кодируемого блока><размер названия><название>
+    Числа занимают соответственно 8, 8, 8 и 4 байта; признаки удаления и записи
+    из потока хранятся так же, как в метаданных, а размер содержимого - полный. При отсутствии или
+    повреждении оглавления файлы находятся последовательным просмотром архива
 */
 
 #ifndef HAMARCHIVER_HPP
@@ -14,15 +30,84 @@
 
 #include "Encoder.hpp"
 #include "Decoder.hpp"
-#include "FileOperator.hpp"
+#include "EncoderContext.hpp"
+#include "DecoderContext.hpp"
+#include "DiskFileOperator.hpp"
+#include "HammingKernel.hpp"
+#include "MemoryStream.hpp"
+#include "Metrics.hpp"
+#include "BlockCache.hpp"
+#include <atomic>
+#include <functional>
+#include <mutex>
 #include <vector>
 
 class HamArchiver{
 public:
     HamArchiver();
     HamArchiver(std::filesystem::path working_dir);
+
+/**
+ * \brief Создаёт архиватор, работающий с файлами данного хранилища 
+ * (например, MemoryFileOperator); рабочая директория задаётся хранилищем
+ * \note По умолчанию используется хранилище DiskFileOperator::CreateDefault
+*/
+    HamArchiver(std::shared_ptr<FileOperator> storage);
     void SetDir(std::filesystem::path new_dir);
 
+/**
+ * \brief Заменяет хранилище (например, на UringFileOperator); рабочая директория
+ * задаётся новым хранилищем
+ * \attention Не должна вызываться одновременно с другими операциями
+*/
+    void SetStorage(std::shared_ptr<FileOperator> storage);
+
+/**
+ * \brief Принудительно задаёт вариант вычислительных ядер кодирования и проверки
+ * \note Настройка действует на весь процесс
+ * \return false, если вариант не поддерживается процессором
+*/
+    bool SetKernel(HammingKernel::Type type);
+
+/**
+ * \brief Включает или отключает запись оглавления в конец создаваемых и изменяемых архивов
+ * \note По умолчанию оглавление записывается
+*/
+    void SetWriteIndex(bool enabled);
+
+/**
+ * \brief Задаёт количество потоков, кодирующих файлы при добавлении в архив
+ * и декодирующих их при извлечении
+ * \param count Количество потоков; 0 - по числу ядер процессора
+ * \note По умолчанию используется один поток. Архив не зависит от числа потоков
+*/
+    void SetThreads(size_t count);
+
+/**
+ * \brief Ограничивает объём памяти под блоки, одновременно находящиеся в обработке
+ * при многопоточном кодировании (в байтах)
+*/
+    void SetMaxInflightMemory(size_t size);
+
+/**
+ * \brief Включает или отключает сбор метрик операций (см. Metrics)
+ * \note По умолчанию метрики не собираются. Значения накапливаются 
+ * между операциями до вызова GetMetrics().Reset()
+*/
+    void SetMetricsEnabled(bool enabled);
+
+    Metrics& GetMetrics();
+
+/**
+ * \brief Задаёт объём кэша проверенных блоков (в байтах); 0 - кэш не используется
+ * \note Кэш используется при извлечении и чтении участков файлов: повторно 
+ * читаемые блоки не проверяются заново. Блоки архива, изменённого этим 
+ * архиватором или вне его, в кэше не находятся. По умолчанию кэш не используется
+*/
+    void SetBlockCacheSize(size_t size);
+
+    const BlockCache& GetBlockCache() const;
+
     struct FileMetadata {
         std::filesystem::path path;
         size_t size;
@@ -34,7 +119,8 @@ public:
         kArcAlreadyExists,
         kEmptyFileList,
         kFileNotFound,
-        kFileNotAccessible
+        kFileNotAccessible,
+        kWriteError
     };
 
     enum class ExtractionResult {
@@ -43,7 +129,8 @@ public:
         kArcCorrupted,
         kEmptyFileList,
         kFileNotFound,
-        kFileCorrupted
+        kFileCorrupted,
+        kWriteError
     };
 
 
@@ -52,90 +139,647 @@ public:
         kArcNotFound,
         kEmptyFileList,
         kFileNotFound,
-        kFileNotAccessible
+        kFileNotAccessible,
+        kWriteError
     };
 
     enum class ConcatenationResult {
         kSuccess,
         kArcAlreadyExists,
         kEmptyFileList,
-        kFileNotFound
+        kFileNotFound,
+        kWriteError
+    };
+
+    enum class VacuumResult {
+        kSuccess,
+        kArcNotFound,
+        kArcCorrupted,
+        kBelowThreshold,
+        kWriteError
+    };
+
+    enum class VerificationResult {
+        kSuccess,           // все блоки целы, либо исправимы
+        kArcNotFound,
+        kArcCorrupted,      // повреждены оглавление или структура архива
+        kFileCorrupted      // в файлах есть необратимо повреждённые блоки
+    };
+
+/**
+ * \brief Количество проверенных блоков по состоянию
+*/
+    struct BlockCounts {
+        size_t clean = 0;
+        size_t corrected = 0;   // с исправимой (единичной) ошибкой
+        size_t corrupted = 0;   // с необратимой ошибкой, либо недочитанные
+    };
+
+    struct EntryVerification {
+        FileMetadata metadata;
+        BlockCounts blocks;     // блоки метаданных, заголовков порций и содержимого
+    };
+
+    struct VerificationReport {
+        std::vector<EntryVerification> entries;  // не удалённые файлы в порядке архива
+        BlockCounts index;      // блоки оглавления и концевик; нули, если оглавления нет
+    };
+
+    enum class ScrubResult {
+        kSuccess,           // все найденные ошибки исправлены на месте
+        kArcNotFound,
+        kArcCorrupted,      // структура архива повреждена, либо архив обрезан
+        kFileCorrupted,     // остались необратимо повреждённые блоки
+        kWriteError         // исправления не удалось записать
+    };
+
+/**
+ * \brief Параметры фоновой проверки с исправлением (см. Scrub)
+*/
+    struct ScrubOptions {
+        size_t max_rate = 0;            // предел скорости чтения и записи, байт/с; 0 - без предела
+        bool idle_priority = false;     // приоритет ввода-вывода idle (см. IdleIoPriority)
+    };
+
+    struct ScrubReport {
+        BlockCounts blocks;             // все проверенные блоки архива
+        size_t resumed_offset = 0;      // смещение, с которого продолжена проверка; 0 - с начала
+        size_t bytes_read = 0;
+        size_t bytes_written = 0;       // байты исправлений, записанных в архив
+        size_t writes = 0;              // операции записи исправлений
     };
 
     std::vector<CreationResult> Create(std::string_view arcname, 
         const std::vector<FileMetadata>& files);
 
+/**
+ * \brief Записывает архив из данных файлов в поток вывода
+ * \param writer Поток, в который архив записывается строго последовательно 
+ * (например, stdout или канал): перемещение по нему и его позиция не используются
+ * \return Результаты добавления файлов, либо единственный результат kWriteError, 
+ * если запись в поток не удалась, и kEmptyFileList
+ * \note Не добавленные файлы в поток не попадают. Если не добавлен ни один файл,
+ * поток остаётся пустым
+*/
+    std::vector<CreationResult> Create(std::ostream& writer, 
+        const std::vector<FileMetadata>& files);
+
     std::vector<FileMetadata> GetFileList(std::filesystem::path arcfile);
 
+/**
+ * \brief Извлекает файлы из архива в рабочую директорию
+ * \note Архив открывается только для чтения и не изменяется
+*/
     std::vector<ExtractionResult> ExtractFiles(std::filesystem::path arcfile, 
         const std::vector<std::string>& filenames);
     
     std::vector<ExtractionResult> ExtractFiles(std::filesystem::path arcfile);
 
+/**
+ * \brief Получатель извлекаемых данных: вызывается для очередного 
+ * восстановленного участка файла по порядку
+ * \return false, чтобы прервать извлечение (например, при ошибке записи)
+*/
+    using ByteSink = std::function<bool(const uint8_t* data, size_t size)>;
+
+/**
+ * \brief Извлекает файл архива в поток вывода, не создавая файлов
+ * \param filename Название файла в архиве; при повторах извлекается последний
+ * \note Данные передаются по мере проверки блоков. Если файл повреждён 
+ * необратимо, вывод обрывается на первом таком блоке, а результат - kFileCorrupted.
+ * kArcCorrupted означает, что файл не найден в повреждённом архиве
+*/
+    ExtractionResult ExtractTo(std::filesystem::path arcfile, const std::string& filename, 
+        std::ostream& writer);
+
+    ExtractionResult ExtractTo(std::filesystem::path arcfile, const std::string& filename, 
+        const ByteSink& sink);
+
+/**
+ * \brief Извлекает файлы архива подряд в поток вывода, загружая оглавление один раз
+ * \return Результаты по порядку файлов. Извлечение прекращается на первом 
+ * необратимо повреждённом файле: результатов тогда меньше, чем файлов
+*/
+    std::vector<ExtractionResult> ExtractTo(std::filesystem::path arcfile, 
+        const std::vector<std::string>& filenames, std::ostream& writer);
+
+    std::vector<ExtractionResult> ExtractTo(std::filesystem::path arcfile, 
+        const std::vector<std::string>& filenames, const ByteSink& sink);
+
+/**
+ * \brief Читает участок файла архива, проверяя и декодируя только покрывающие его блоки
+ * \param offset Смещение участка от начала файла (в байтах)
+ * \param length Длина участка (в байтах)
+ * \param buffer Буфер, вмещающий не менее length байт
+ * \param read_size Количество прочитанных байт: меньше length, если участок 
+ * выходит за конец файла
+ * \note Архив не изменяется. Если блок участка повреждён необратимо, 
+ * результат - kFileCorrupted, а read_size - объём данных до этого блока
+*/
+    ExtractionResult ReadRange(std::filesystem::path arcfile, const std::string& filename, 
+        size_t offset, size_t length, uint8_t* buffer, size_t& read_size);
+
+/**
+ * \brief Передаёт участок файла архива получателю по блокам, не выделяя буфер под весь участок
+ * \note Оглавление загружается один раз, поэтому длина участка не ограничена памятью. 
+ * Если получатель вернул false, результат - kFileCorrupted
+*/
+    ExtractionResult ReadRange(std::filesystem::path arcfile, const std::string& filename, 
+        size_t offset, size_t length, const ByteSink& sink);
+
+/**
+ * \brief Помечает файлы архива как удалённые
+ * \note Перезаписываются только числовые метаданные файлов и затронутые
+ * блоки оглавления; занятое файлами место освобождает Vacuum
+*/
     std::vector<ExtractionResult> DeleteFiles(std::filesystem::path arcfile, 
         const std::vector<std::string>& filenames);
 
+/**
+ * \brief Уплотняет архив на месте, вырезая удалённые файлы
+ * \param arcfile Путь к архивному файлу
+ * \param threshold Минимальная доля удалённых данных в архиве, при которой 
+ * выполняется уплотнение
+ * \note Используется буфер ограниченного размера. Ход уплотнения сохраняется 
+ * в файле <архив>.vacuum: прерванное уплотнение продолжается при следующем 
+ * вызове независимо от порога. Если в архиве не осталось файлов, он удаляется
+*/
+    VacuumResult Vacuum(std::filesystem::path arcfile, double threshold);
+
+/**
+ * \brief Проверяет все блоки метаданных, оглавления и содержимого архива, 
+ * ничего не записывая
+ * \param report Количество целых, исправимых и повреждённых блоков каждого файла
+ * \note Содержимое файлов делится на части по kExtractionChunkSize байт, 
+ * которые проверяются в несколько потоков (см. SetThreads). Ошибки не исправляются:
+ * архив открывается только для чтения
+*/
+    VerificationResult Verify(std::filesystem::path arcfile, VerificationReport& report);
+
+/**
+ * \brief Проверяет все блоки архива и записывает исправления единичных ошибок на место
+ * \param report Количество проверенных и исправленных блоков, объём ввода-вывода
+ * \note Архив читается последовательно участками по kExtractionChunkSize байт;
+ * исправления участка объединяются в записи соседних байт (см. kScrubWriteGap)
+ * и сбрасываются на диск один раз. Ход проверки сохраняется в файле <архив>.scrub
+ * не реже, чем через kScrubCheckpointInterval байт: прерванная проверка
+ * продолжается с контрольной точки, если размер архива не изменился
+*/
+    ScrubResult Scrub(std::filesystem::path arcfile, const ScrubOptions& options, 
+        ScrubReport& report);
+
+/**
+ * \brief Последовательно проверяет с исправлением несколько архивов
+ * \return Результаты и отчёты в порядке списка архивов
+*/
+    std::vector<ScrubResult> Scrub(const std::vector<std::filesystem::path>& arcfiles, 
+        const ScrubOptions& options, std::vector<ScrubReport>& reports);
+
     std::vector<AdditionResult> AppendFiles(std::filesystem::path arcfile, 
         const std::vector<FileMetadata>& files);
+
+/**
+ * \brief Дописывает в архив данные из потока неизвестной длины
+ * \param file Название файла в архиве и длина кодируемого блока (больше 0). 
+ * Размер не используется
+ * \param reader Поток, читаемый до конца; перемещение по нему не требуется
+ * \note Данные кодируются порциями, поэтому память не зависит от длины потока
+*/
+    AdditionResult AppendStream(std::filesystem::path arcfile, FileMetadata file, 
+        std::istream& reader);
+
+/**
+ * \brief Создаёт архив из одного файла, данные которого читаются из потока
+ * \note См. AppendStream
+*/
+    CreationResult CreateFromStream(std::string_view arcname, FileMetadata file, 
+        std::istream& reader);
+
+/**
+ * \brief Записывает в поток вывода архив из одного файла, данные которого читаются из потока
+ * \note Оба потока используются строго последовательно (см. Create, AppendStream)
+*/
+    CreationResult CreateFromStream(std::ostream& writer, FileMetadata file, 
+        std::istream& reader);
     
     std::vector<ConcatenationResult> Merge(std::string_view arcname,
         const std::vector<std::string>& arcfiles);
 
 private:
     static const size_t kNumericMetadataSize;
+    static const size_t kIndexRecordHeaderSize;
+    static const size_t kIndexNameSizeOffset;
+    static const size_t kNameSizeFieldSize;
+    static const size_t kIndexBlockSize;
+    static const size_t kIndexTrailerSize;
+    static const uint8_t kIndexMagic[8];
+    static const size_t kDefaultMaxInflightSize;
+    static const size_t kExtractionChunkSize;
+    static const size_t kDeletedFlag;
+    static const size_t kStreamedFlag;
+    static const size_t kStreamChunkSize;
+    static const size_t kChunkHeaderSize;
+    static const size_t kVacuumBufferSize;
+    static const size_t kScrubWriteGap;
+    static const size_t kScrubCheckpointInterval;
+
+/**
+ * \brief Положение файла в архиве
+*/
+    struct IndexEntry {
+        FileMetadata metadata;
+        size_t offset;          // первый байт метаданных
+        size_t content_offset;  // первый байт закодированного содержимого
+        bool deleted = false;
+        bool streamed = false;  // содержимое разбито на порции
+    };
 
-    FileOperator file_operator;
+/**
+ * \brief Ход уплотнения архива
+*/
+    struct VacuumCheckpoint {
+        size_t entries_end;     // конец данных файлов до уплотнения
+        size_t src;             // данные до src перенесены
+        size_t dst;             // на место до dst
+        size_t pending_size;    // размер сохранённой в контрольной точке порции, 
+                                // ещё не записанной на место dst
+    };
 
 /**
- * \brief Перезаписывает архивный файл, исключая набор файлов
- * \param arcfile Путь к архивному файлу
- * \param skip_list Названия файлов в архиве, которые будут пропущены при перезаписи
- * \param extract Флаг извлечения пропускаемых файлов
- * \attention Требуется, чтобы архивный файл существовал в рабочей директории
- * \note Файлы с корректными числовыми метаданными, идентификация которых невозможна (имя файла повреждено), 
- * остаются в архиве
+ * \brief Закодированный участок архива, проверяемый при Scrub
+*/
+    struct ScrubRegion {
+        size_t offset;          // первый байт первого блока
+        size_t size;            // размер исходных данных
+        size_t block_size;
+    };
+
+/**
+ * \brief Часть содержимого файла, извлекаемая одним потоком
+*/
+    struct ExtractionTask {
+        size_t entry;           // номер файла в списке извлекаемых
+        size_t first_block;
+        size_t blocks_count;
+    };
+
+/**
+ * \brief Участок содержимого файла, проверяемый одним потоком. 
+ * Участок начинается с блока и не выходит за пределы порции
+*/
+    struct VerificationTask {
+        size_t entry;
+        size_t begin;           // смещение от начала файла (в байтах)
+        size_t size;
+    };
+
+/**
+ * \brief Состояние файла, части которого извлекаются параллельно
+*/
+    struct ExtractionState {
+        IndexEntry entry;
+        std::once_flag created;
+        std::atomic<size_t> chunks_left;
+        std::atomic<bool> corrupted;
+        uint64_t archive_id;  // идентификатор архива в кэше блоков, 0 - без кэша
+    };
+
+    std::shared_ptr<FileOperator> file_operator;
+    bool write_index;
+    size_t threads_count;
+    size_t max_inflight_size;
+    // Рабочая память последовательного кодирования и проверки; 
+    // потоки извлечения используют собственные буферы
+    EncoderContext encoder_context;
+    DecoderContext decoder_context;
+    Metrics metrics;
+    BlockCache block_cache;
+
+/**
+ * \brief Получает список файлов архива из оглавления, либо, при его отсутствии 
+ * или повреждении, последовательным просмотром архива
+ * \param stream Поток чтения архива
+ * \param arc_size Размер архива
+ * \param entries_end Первый байт после данных последнего файла (начало оглавления)
+ * \param complete Флаг успешного получения полного списка. Сбрасывается, если
+ * просмотр остановлен на повреждённых метаданных
 */
-    std::vector<ExtractionResult> RebuildArc(std::filesystem::path arcfile,
-    const std::vector<std::string>& skip_list, bool extract);
+    std::vector<IndexEntry> LoadEntries(std::istream& stream, size_t arc_size, 
+        size_t& entries_end, bool& complete);
+
+/**
+ * \brief Последовательно просматривает метаданные файлов архива
+ * \return false, если просмотр остановлен на повреждённых метаданных
+*/
+    bool ScanEntries(std::istream& stream, size_t entries_end, std::vector<IndexEntry>& entries);
+
+/**
+ * \brief Считывает и проверяет завершающую запись оглавления
+ * \return false, если архив не содержит оглавления
+*/
+    bool ReadIndexTrailer(std::istream& stream, size_t arc_size, 
+        size_t& index_offset, size_t& body_size);
+
+/**
+ * \brief Считывает и проверяет записи оглавления
+ * \return false, если оглавление необратимо повреждено
+*/
+    bool ReadIndexBody(std::istream& stream, size_t index_offset, 
+        size_t body_size, std::vector<IndexEntry>& entries);
+
+/**
+ * \brief Записывает оглавление архива
+ * \param entries Файлы архива
+ * \param writer Поток записи, установленный на конец данных последнего файла
+ * \param index_offset Смещение начала оглавления в архиве
+ * \note Оглавление не записывается, если список пуст или содержит файлы с повреждёнными названиями
+*/
+    void WriteIndex(const std::vector<IndexEntry>& entries, std::ostream& writer, size_t index_offset);
+
+/**
+ * \brief Формирует записи оглавления
+ * \param record_offsets Смещения записей в оглавлении (заполняется)
+ * \return false, если список содержит файлы с повреждёнными названиями
+*/
+    bool BuildIndexBody(const std::vector<IndexEntry>& entries, std::string& body, 
+        std::vector<size_t>& record_offsets);
+
+/**
+ * \brief Перезаписывает числовые метаданные файла, выставляя признак удаления
+ * \note Метаданные восстанавливаются по entry, поэтому повреждение 
+ * их копии в архиве не мешает удалению
+*/
+    void WriteDeletedMetadata(const IndexEntry& entry, std::ostream& writer);
+
+/**
+ * \brief Переносит данные файлов на место удалённых, начиная с позиции контрольной точки
+ * \param entries Файлы архива до уплотнения
+ * \param buf Буфер размера kVacuumBufferSize; содержит порцию из контрольной 
+ * точки, если её запись была прервана
+ * \param entries_end Конец данных файлов после уплотнения
+ * \return false при ошибке чтения или записи; контрольная точка тогда 
+ * остаётся на последней сохранённой на устройстве порции
+*/
+    bool CompactEntries(std::filesystem::path arcfile, std::filesystem::path checkpoint_file, 
+        const std::vector<IndexEntry>& entries, VacuumCheckpoint checkpoint, uint8_t* buf, 
+        size_t& entries_end);
+
+    bool ReadVacuumCheckpoint(std::filesystem::path checkpoint_file, VacuumCheckpoint& checkpoint, 
+        uint8_t* pending);
+
+/**
+ * \brief Атомарно (через переименование) сохраняет контрольную точку уплотнения
+ * \param pending Порция данных, которая будет записана на место checkpoint.dst
+*/
+    bool WriteVacuumCheckpoint(std::filesystem::path checkpoint_file, 
+        const VacuumCheckpoint& checkpoint, const uint8_t* pending);
 
 /**
  * \brief Восстанавливает декодированный файл из архива
  * \param metadata Предварительно извлечённые метаданные файла
- * \param stream Поток чтения и записи архива
+ * \param stream Поток чтения архива
  * \param forced Флаг извлечения файла при необратимом повреждении
  * \attention Требуется, чтобы 
  * 1) Было возможно создать файл с данным названием в рабочей директории
  * 2) Метаданные файла были извлечены и проверены заранее.
  * 3) Начальная позиция потока была установлена на начало первого блока
  * закодированного содержимого файла.
- * \note По завершении перемещает позицию потока на первый байт после конца данных файла
+ * \note По завершении перемещает позицию потока на первый байт после конца данных файла.
+ * Архив читается за один проход: ошибки исправляются в памяти, архив не изменяется.
+ * Файл записывается под временным названием (см. GetPartialPath) и заменяет 
+ * существующий только после успешного извлечения (или при forced): иначе 
+ * частично записанный файл удаляется, а существующий файл не изменяется
+*/
+    ExtractionResult ExtractFile(const IndexEntry& entry, std::istream& stream, bool forced, 
+        uint64_t archive_id);
+
+/**
+ * \brief Проверяет блоки содержимого файла и передаёт восстановленные данные получателю
+ * \attention Начальная позиция потока - начало первого блока содержимого файла
+ * \param archive_id Идентификатор архива в кэше блоков (см. GetCacheId)
+ * \note Без forced передача прекращается на первом необратимо повреждённом блоке
 */
-    ExtractionResult ExtractFile(FileMetadata metadata, std::fstream& stream, bool forced);
+    ExtractionResult DecodeEntry(const IndexEntry& entry, std::istream& stream, 
+        bool forced, const ByteSink& sink, uint64_t archive_id);
+
+/**
+ * \brief Проверяет size байт содержимого, закодированного блоками block_size,
+ * и передаёт их получателю
+*/
+    ExtractionResult DecodeContent(size_t size, size_t block_size, std::istream& stream, 
+        bool forced, const ByteSink& sink, uint64_t archive_id);
+
+/**
+ * \brief Проходит порции файла, записанного из потока, проверяя их заголовки
+ * \param data_size Суммарный размер порций
+ * \attention Начальная позиция потока - заголовок первой порции
+ * \return false, если заголовок повреждён или порции не соответствуют формату
+*/
+    bool ScanStreamChunks(std::istream& stream, size_t block_size, size_t& data_size);
+
+/**
+ * \brief Находит последний не удалённый файл с данным названием
+ * \return nullptr, если файла нет
+*/
+    const IndexEntry* FindLastEntry(const std::vector<IndexEntry>& entries, 
+        const std::string& filename);
+
+/**
+ * \brief Находит блок содержимого, в который попадает байт pos файла
+ * \param encoded_offset Смещение закодированного блока в архиве
+ * \param block_begin Смещение первого байта блока от начала файла
+ * \param block_size Размер блока (последний блок файла или порции может быть меньше)
+*/
+    void LocateBlock(const IndexEntry& entry, size_t pos, size_t& encoded_offset, 
+        size_t& block_begin, size_t& block_size);
+
+/**
+ * \brief Извлекает файлы в несколько потоков
+ * \param arcfile Путь к архивному файлу
+ * \param entries Извлекаемые файлы с различными названиями
+ * \return Результаты извлечения в порядке entries
+ * \note Большие файлы делятся на части по kExtractionChunkSize байт содержимого.
+ * Каждый поток читает архив через собственный поток ввода и берёт части из
+ * очереди с перехватом работы. Необратимо повреждённые файлы удаляются
+ * после обработки всех их частей
+*/
+    std::vector<ExtractionResult> ExtractEntries(std::filesystem::path arcfile, 
+        const std::vector<IndexEntry>& entries, const MappedFile& mapping, uint64_t archive_id);
+
+/**
+ * \brief Возвращает временное название извлекаемого файла в той же директории
+*/
+    static std::filesystem::path GetPartialPath(const std::filesystem::path& filename);
+
+/**
+ * \brief Проверяет и записывает часть файла
+ * \param buf Буфер для закодированных блоков части (не используется при чтении из памяти)
+ * \param fix_buf Буфер для исправляемого блока
+*/
+    void ExtractChunk(const ExtractionTask& task, ExtractionState& state, 
+        std::istream& stream, uint8_t* buf, uint8_t* fix_buf);
+
+/**
+ * \brief Проверяет блок, не изменяя его, и учитывает его состояние
+*/
+    void VerifyBlock(const uint8_t* encoded, size_t block_size, BlockCounts& counts);
+
+/**
+ * \brief Проверяет блоки метаданных файла и, для файла из потока, заголовки порций
+*/
+    void VerifyEntryMetadata(std::istream& stream, const IndexEntry& entry, BlockCounts& counts);
+
+/**
+ * \brief Проверяет блоки оглавления и концевик, если оглавление есть
+*/
+    void VerifyIndex(std::istream& stream, size_t arc_size, BlockCounts& counts);
+
+/**
+ * \brief Проверяет блоки участка содержимого файла
+ * \param buf Буфер для закодированного участка (не используется при чтении из памяти)
+*/
+    void VerifyRange(const IndexEntry& entry, const VerificationTask& task, 
+        std::istream& stream, uint8_t* buf, BlockCounts& counts);
+
+/**
+ * \brief Собирает закодированные участки архива: метаданные и содержимое всех 
+ * записей (для удалённых - только метаданные), заголовки порций и оглавление
+*/
+    std::vector<ScrubRegion> GetScrubRegions(std::istream& stream, size_t arc_size, 
+        const std::vector<IndexEntry>& entries);
+
+/**
+ * \brief Проверяет блоки, начинающиеся со смещения offset, и записывает исправления
+ * \param size Размер исходных данных проверяемых блоков
+ * \param buf Буфер для закодированных блоков
+*/
+    ScrubResult ScrubBlocks(FileStream& stream, size_t offset, size_t size, 
+        size_t block_size, uint8_t* buf, ScrubReport& report);
+
+    bool ReadScrubCheckpoint(std::filesystem::path checkpoint_file, size_t& arc_size, 
+        size_t& offset);
+
+    bool WriteScrubCheckpoint(std::filesystem::path checkpoint_file, size_t arc_size, 
+        size_t offset);
+
+/**
+ * \brief Возвращает идентификатор текущего состояния архива в кэше блоков
+ * \return 0, если кэш не используется
+*/
+    uint64_t GetCacheId(std::filesystem::path arcfile);
+
+/**
+ * \brief Исключает из кэша блоки изменяемого архива
+*/
+    void InvalidateCache(std::filesystem::path arcfile);
+
+/**
+ * \brief Копирует в fix_buf блок из кэша
+ * \return fix_buf, либо nullptr, если блока нет в кэше или кэш не используется
+*/
+    const uint8_t* GetCachedBlock(uint64_t archive_id, size_t block_offset, 
+        size_t block_size, uint8_t* fix_buf);
+
+/**
+ * \brief Помещает в кэш блок, если он проверен успешно
+*/
+    void CacheBlock(uint64_t archive_id, size_t block_offset, const uint8_t* block, 
+        size_t block_size, Decoder::ValidationResult result);
+
+/**
+ * \brief Открывает архив для чтения: отображает его в память, либо, 
+ * если это невозможно, открывает файловый поток
+ * \return Поток чтения архива - memory_reader или file_reader
+*/
+    std::istream& OpenArchive(std::filesystem::path arcfile, MappedFile& mapping, 
+        MemoryStream& memory_reader, FileStream& file_reader);
+
+/**
+ * \brief Получает очередные size байт потока. При чтении из памяти 
+ * данные не копируются, иначе считываются в buf
+ * \return nullptr, если данные закончились раньше
+*/
+    const uint8_t* ReadBytes(std::istream& stream, size_t size, uint8_t* buf);
+
+/**
+ * \brief Проверяет закодированный блок, не изменяя его
+ * \param encoded Блок и его код
+ * \param fix_buf Буфер, в который копируется блок при исправлении ошибки
+ * \return Исправленная информационная часть блока: encoded, либо fix_buf
+*/
+    const uint8_t* DecodeBlock(const uint8_t* encoded, size_t block_size, 
+        uint8_t* fix_buf, Decoder::ValidationResult& result);
+
+/**
+ * \brief Учитывает в метриках чтение из потока архива
+*/
+    void CountRead(std::istream& stream);
+
+/**
+ * \brief Учитывает результат проверки блока в метриках
+*/
+    void CountValidation(Decoder::ValidationResult result);
+
+/**
+ * \brief Учитывает в метриках закодированное содержимое файла
+*/
+    void CountEncodedFile(const FileMetadata& file);
 
 /**
  * \brief Записывает закодированные метаданные в поток вывода
  * \param file Информация о файле: путь, размер, длина кодируемого блока
  * \param writer Поток записи метаданных
 */
-    void WriteEncodedMetadata(FileMetadata file, std::ostream& writer/*, std::istream& reader*/);
+    void WriteEncodedMetadata(FileMetadata file, std::ostream& writer, bool streamed);
 
 /**
  * \brief Открывает файл (либо сообщает о невозможности это сделать), 
  * кодирует его с данной длиной блока и выводит в поток
- * \param file Информация о файле: путь, ожидаемая длина кодируемого блока
+ * \param file Информация о файле: путь, ожидаемая длина кодируемого блока. 
+ * По завершении содержит записанные в архив размер файла и длину блока
  * \param writer Поток записи закодированного файла
 */
-    AdditionResult WriteEncodedFile(FileMetadata file, std::ostream& writer/*, std::istream& reader*/);
+    AdditionResult WriteEncodedFile(FileMetadata& file, std::ostream& writer/*, std::istream& reader*/);
+
+/**
+ * \brief Кодирует данные потока порциями и выводит их в архив
+ * \param file По завершении содержит размер записанных данных
+*/
+    AdditionResult WriteEncodedStream(FileMetadata& file, std::istream& reader, std::ostream& writer);
+
+    void WriteChunkHeader(size_t chunk_size, std::ostream& writer);
+
+/**
+ * \brief Кодирует файлы и выводит их в поток архива
+ * \param entries Дополняется записями добавленных файлов
+ * \param offset Смещение в архиве первого записываемого файла; 
+ * по завершении - конец последнего добавленного файла
+*/
+    std::vector<AdditionResult> WriteEntries(const std::vector<FileMetadata>& files, 
+        std::ostream& writer, std::vector<IndexEntry>& entries, size_t& offset);
+
+    static CreationResult ToCreationResult(AdditionResult result);
+
+/**
+ * \brief Читает оглавление архива, либо находит файлы просмотром архива, 
+ * и отрезает оглавление перед дозаписью
+ * \param entries_end Конец последнего файла архива
+ * \return true, если список файлов полон и после дозаписи можно записать оглавление
+*/
+    bool PrepareAppend(std::filesystem::path arcfile, std::vector<IndexEntry>& entries, 
+        size_t& entries_end);
 
 /**
  * \brief Получает метаданные файла из потока и проводит их валидацию
- * \param stream Поток чтения и записи
+ * \param stream Поток чтения архива
+ * \param deleted Признак удалённого файла
+ * \param streamed Признак файла, записанного из потока
  * \attention В случае невалидности числовых метаданных, размер файла и кодирующего блока выставляются равными -1.
  * В случае невалидности имени файла, его считывание не производится.
  * \note По завершении позиция потока чтения устанавливается на первый байт после
- * контроля метаданных (первый байт содержимого файла)
+ * контроля метаданных (первый байт содержимого файла). Ошибки исправляются в памяти
 */
-    FileMetadata GetMetadata(std::fstream& stream);
+    FileMetadata GetMetadata(std::istream& stream, bool& deleted, bool& streamed);
 
 /**
  * \brief Вычисляет размер сообщения, закодированного блоками 
@@ -158,6 +802,32 @@ private:
  * \param raw_msg_size Размер незакодированного сообщения (в байтах)
 */
     size_t GetMsgCodeSize(size_t raw_msg_size);
+
+/**
+ * \brief Вычисляет размер закодированных метаданных файла
+ * \param filename_size Длина названия файла (в байтах)
+*/
+    size_t GetEncodedMetadataSize(size_t filename_size);
+
+/**
+ * \brief Вычисляет размер файла в архиве (метаданные и закодированное содержимое)
+*/
+    size_t GetEntrySize(const IndexEntry& entry);
+
+/**
+ * \brief Вычисляет размер закодированного содержимого файла (с заголовками порций)
+*/
+    size_t GetEncodedContentSize(const IndexEntry& entry);
+
+    size_t GetStreamChunkSize(size_t block_size);
+
+/**
+ * \brief Собирает поле размера названия вместе с признаками файла
+*/
+    size_t GetNameSizeField(const IndexEntry& entry);
+
+    static void StoreNumber(uint8_t* buf, size_t value, size_t bytes_count);
+    static size_t LoadNumber(const uint8_t* buf, size_t bytes_count);
 };
 
 #endif  // HAMARCHIVER_HPP
@@ -0,0 +1,99 @@
+#ifndef HAMMINGKERNEL_HPP
+#define HAMMINGKERNEL_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * \brief Вычислительные ядра кодировщика.
+ * Реализует накопление синдрома и чётности по машинным словам сообщения
+ * в нескольких вариантах (скалярный, SSE4.2, AVX2, AVX-512). Вариант
+ * выбирается по CPUID при первом обращении; переменная окружения HAMARC_KERNEL
+ * (scalar, sse4.2, avx2, avx512) позволяет задать его принудительно.
+*/
+class HammingKernel {
+public:
+    enum class Type {
+        kAuto,
+        kScalar,
+        kSSE42,
+        kAVX2,
+        kAVX512
+    };
+
+/**
+ * \brief Устанавливает используемый вариант ядер для всего процесса
+ * \param type Вариант ядер; kAuto - наилучший из поддерживаемых процессором
+ * \return false, если вариант не поддерживается (текущий вариант не меняется)
+*/
+    static bool Select(Type type);
+
+    static Type GetActive();
+    static bool IsSupported(Type type);
+    static const char* GetName(Type type);
+
+/**
+ * \brief Накопление синдрома по полным словам участка сообщения с постоянным
+ * смещением позиций
+ * \param words Начало первого слова (8 байт, старший бит - первый бит сообщения)
+ * \param count Количество слов
+ * \param first_window Номер окна позиций, в которое попадают младшие
+ * (по маске low_mask) биты первого слова; старшие биты попадают в следующее окно
+ * \param low_mask Маска бит слова, попадающих в окно с тем же номером
+ * \param run_word XOR всех слов (накапливается)
+ * \param window_xor XOR номеров окон с нечётным числом единичных бит (накапливается)
+*/
+    static void AccumulateRun(const uint8_t* words, size_t count, size_t first_window,
+        uint64_t low_mask, uint64_t& run_word, size_t& window_xor);
+
+/**
+ * \brief Вычисляет XOR всех байт данных
+*/
+    static uint8_t XorBytes(const uint8_t* data, size_t size);
+
+private:
+    using AccumulateRunFn = void (*)(const uint8_t*, size_t, size_t, uint64_t, uint64_t&, size_t&);
+    using XorBytesFn = uint8_t (*)(const uint8_t*, size_t);
+
+    struct Kernels {
+        Type type;
+        AccumulateRunFn accumulate_run;
+        XorBytesFn xor_bytes;
+    };
+
+    static const Kernels& GetKernels();
+
+/**
+ * \brief Указатель на используемый набор ядер: Select заменяет его атомарно,
+ * не меняя сами наборы, поэтому ядра можно вызывать из нескольких потоков
+*/
+    static std::atomic<const Kernels*>& GetActiveKernels();
+    static const Kernels& GetKernelSet(Type type);
+    static Type GetDefaultType();
+    static Type GetBestSupported();
+    static Kernels MakeKernels(Type type);
+
+    static uint64_t LoadWord(const uint8_t* bytes);
+    static bool GetWordParityBit(uint64_t word);
+
+    static void AccumulateRunScalar(const uint8_t* words, size_t count, size_t first_window,
+        uint64_t low_mask, uint64_t& run_word, size_t& window_xor);
+    static uint8_t XorBytesScalar(const uint8_t* data, size_t size);
+
+#if defined(__GNUC__) && defined(__x86_64__)
+    static void AccumulateRunSSE42(const uint8_t* words, size_t count, size_t first_window,
+        uint64_t low_mask, uint64_t& run_word, size_t& window_xor);
+    static uint8_t XorBytesSSE42(const uint8_t* data, size_t size);
+
+    static void AccumulateRunAVX2(const uint8_t* words, size_t count, size_t first_window,
+        uint64_t low_mask, uint64_t& run_word, size_t& window_xor);
+    static uint8_t XorBytesAVX2(const uint8_t* data, size_t size);
+
+    static void AccumulateRunAVX512(const uint8_t* words, size_t count, size_t first_window,
+        uint64_t low_mask, uint64_t& run_word, size_t& window_xor);
+    static uint8_t XorBytesAVX512(const uint8_t* data, size_t size);
+#endif
+};
+
+#endif  // HAMMINGKERNEL_HPP
@@ -0,0 +1,27 @@
+#ifndef IOPRIORITY_HPP
+#define IOPRIORITY_HPP
+
+/**
+ * \brief Понижает приоритет ввода-вывода вызывающего потока до класса idle
+ * на время своего существования: запросы потока обслуживаются диском только
+ * при отсутствии других запросов.
+ * \note Поддерживается в Linux (ioprio_set); в остальных системах ничего не делает
+*/
+class IdleIoPriority {
+public:
+    IdleIoPriority();
+    ~IdleIoPriority();
+    IdleIoPriority(const IdleIoPriority&) = delete;
+    IdleIoPriority& operator=(const IdleIoPriority&) = delete;
+
+/**
+ * \return false, если приоритет не удалось изменить
+*/
+    bool IsApplied() const;
+
+private:
+    int previous_;
+    bool applied_;
+};
+
+#endif  // IOPRIORITY_HPP
@@ -0,0 +1,88 @@
+#ifndef IOURING_HPP
+#define IOURING_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * \brief Кольцо асинхронного ввода-вывода io_uring (Linux), управляемое системными
+ * вызовами напрямую. Подготовленные запросы чтения и записи отправляются ядру 
+ * одним вызовом Submit.
+ * \note В остальных системах, а также если ядро не поддерживает io_uring 
+ * или запрещает его, Init завершается неудачей
+*/
+class IoUring {
+public:
+    IoUring();
+    ~IoUring();
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+/**
+ * \brief Проверяет (один раз за время работы процесса), можно ли создать кольцо
+*/
+    static bool IsSupported();
+
+/**
+ * \param entries Наибольшее количество запросов, одновременно находящихся в обработке
+*/
+    bool Init(unsigned entries);
+    bool IsOpen() const;
+
+/**
+ * \brief Регистрирует буферы, чтобы ядро не закрепляло их страницы при каждом запросе
+ * \return false, если регистрация не удалась (например, из-за RLIMIT_MEMLOCK):
+ * запросы тогда используют обычные буферы
+*/
+    bool RegisterBuffers(uint8_t* const* buffers, size_t count, size_t size);
+
+/**
+ * \brief Подготавливают запрос чтения или записи по смещению
+ * \param buffer_index Номер зарегистрированного буфера, содержащего data; 
+ * не используется, если буферы не зарегистрированы
+ * \param user_data Значение, возвращаемое вместе с результатом запроса
+ * \return false, если очередь отправки заполнена
+*/
+    bool PrepareRead(int fd, uint8_t* data, size_t size, size_t offset, 
+        unsigned buffer_index, uint64_t user_data);
+    bool PrepareWrite(int fd, const uint8_t* data, size_t size, size_t offset, 
+        unsigned buffer_index, uint64_t user_data);
+
+/**
+ * \brief Отправляет подготовленные запросы и ждёт завершения не менее wait_count запросов
+*/
+    bool Submit(unsigned wait_count);
+
+/**
+ * \brief Забирает результат очередного завершённого запроса, не ожидая
+ * \param result Количество прочитанных или записанных байт, либо -errno
+ * \return false, если завершённых запросов нет
+*/
+    bool PopCompletion(uint64_t& user_data, int& result);
+
+private:
+    bool Prepare(uint8_t opcode, int fd, const uint8_t* data, size_t size, size_t offset, 
+        unsigned buffer_index, uint64_t user_data);
+    void Close();
+
+    int ring_fd_;
+    unsigned prepared_;             // подготовленные, но не отправленные запросы
+    bool buffers_registered_;
+    void* sq_ring_;
+    size_t sq_ring_size_;
+    void* cq_ring_;
+    size_t cq_ring_size_;
+    void* sqes_;
+    size_t sqes_size_;
+    unsigned* sq_head_;
+    unsigned* sq_tail_;
+    unsigned* sq_mask_;
+    unsigned* sq_array_;
+    unsigned sq_entries_;
+    unsigned* cq_head_;
+    unsigned* cq_tail_;
+    unsigned* cq_mask_;
+    void* cqes_;
+};
+
+#endif  // IOURING_HPP
@@ -0,0 +1,49 @@
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+/**
+ * \brief Файл, отображённый в память только для чтения.
+ * \note Отображение поддерживается в POSIX-системах; в остальных Open
+ * всегда завершается неудачей, и чтение выполняется через потоки
+*/
+class MappedFile {
+public:
+    enum class AccessPattern {
+        kNormal,
+        kSequential,
+        kRandom,
+        kWillNeed
+    };
+
+    MappedFile();
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+/**
+ * \brief Отображает файл в память
+ * \return false, если файл не существует, пуст или не может быть отображён
+*/
+    bool Open(const std::filesystem::path& file);
+    void Close();
+
+    bool IsOpen() const;
+    const uint8_t* GetData() const;
+    size_t GetSize() const;
+
+/**
+ * \brief Сообщает системе, как будет читаться часть файла
+ * \note Подсказка не влияет на корректность: ошибки игнорируются
+*/
+    void Advise(size_t offset, size_t length, AccessPattern pattern) const;
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+};
+
+#endif  // MAPPEDFILE_HPP
@@ -0,0 +1,68 @@
+#ifndef MEMORYFILEOPERATOR_HPP
+#define MEMORYFILEOPERATOR_HPP
+
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "FileOperator.hpp"
+
+/**
+ * \brief Файловая система в памяти: архивы создаются, изменяются и извлекаются
+ * без обращения к диску. Директории не хранятся: файл определяется полным путём.
+ * \note Открытый файл остаётся доступным после удаления или переименования, 
+ * как в POSIX. Отображение в память не поддерживается
+*/
+class MemoryFileOperator : public FileOperator {
+public:
+    using FileOperator::FileOperator;
+
+/**
+ * \brief Создаёт или перезаписывает файл с данным содержимым
+*/
+    void WriteFile(std::filesystem::path filename, std::string_view data);
+
+/**
+ * \return Содержимое файла; пустая строка, если файла нет
+*/
+    std::string ReadFile(std::filesystem::path filename);
+
+    bool FileExists(std::filesystem::path filename) override;
+    size_t GetFileSize(std::filesystem::path filename) override;
+    std::filesystem::file_time_type GetLastWriteTime(std::filesystem::path filename) override;
+
+    bool CreateDir(std::filesystem::path name) override;
+    bool DeleteFile(std::filesystem::path filename) override;
+
+/**
+ * \brief Удаляет все файлы, путь которых начинается с name
+ * \return Количество удалённых файлов
+*/
+    size_t DeleteDir(std::filesystem::path name) override;
+    void RenameFile(std::filesystem::path old_name, 
+        std::filesystem::path new_name) override;
+    void ResizeFile(std::filesystem::path filename, size_t new_size) override;
+
+protected:
+    std::unique_ptr<RandomAccessFile> OpenFile(const std::filesystem::path& file, 
+        bool writable, bool create, bool truncate) override;
+
+private:
+    struct Node {
+        std::mutex mutex;
+        std::vector<uint8_t> data;
+        std::filesystem::file_time_type write_time;
+    };
+
+    class MemoryFile;
+
+    std::string GetKey(const std::filesystem::path& filename) const;
+    std::shared_ptr<Node> FindNode(const std::filesystem::path& filename);
+
+    std::mutex mutex_;
+    std::unordered_map<std::string, std::shared_ptr<Node>> files_;
+};
+
+#endif  // MEMORYFILEOPERATOR_HPP
@@ -0,0 +1,42 @@
+#ifndef MEMORYSTREAM_HPP
+#define MEMORYSTREAM_HPP
+
+#include <cstdint>
+#include <istream>
+#include <streambuf>
+
+/**
+ * \brief Поток чтения из области памяти (например, отображённого файла).
+ * Чтение и перемещение позиции не требуют системных вызовов.
+ * \attention Область памяти должна существовать, пока используется поток
+*/
+class MemoryStream : public std::istream {
+public:
+    MemoryStream();
+    MemoryStream(const uint8_t* data, size_t size);
+
+    void SetData(const uint8_t* data, size_t size);
+
+/**
+ * \brief Возвращает указатель на очередные size байт без копирования
+ * и перемещает позицию потока за них
+ * \return nullptr, если до конца области осталось меньше size байт
+ * (позиция потока не меняется)
+*/
+    const uint8_t* ReadSpan(size_t size);
+
+private:
+    class MemoryBuf : public std::streambuf {
+    public:
+        void SetData(const uint8_t* data, size_t size);
+        const uint8_t* ReadSpan(size_t size);
+
+    protected:
+        pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override;
+        pos_type seekpos(pos_type pos, std::ios_base::openmode which) override;
+    };
+
+    MemoryBuf buf_;
+};
+
+#endif  // MEMORYSTREAM_HPP
@@ -0,0 +1,113 @@
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <cstdint>
+#include <string>
+
+/**
+ * \brief Счётчики и таймеры этапов операций архиватора.
+ * Значения накапливаются атомарно (без упорядочивания), поэтому могут 
+ * обновляться из нескольких потоков.
+ * \note По умолчанию сбор выключен: каждое обновление сводится к проверке флага
+*/
+class Metrics {
+public:
+    enum class Counter {
+        kRawBytes,           // Байты исходных данных файлов (закодированные или восстановленные)
+        kEncodedBytes,       // Байты закодированных данных файлов (записанные или прочитанные)
+        kBlocksEncoded,
+        kBlocksValidated,
+        kSingleErrorsFixed,
+        kDoubleErrors,
+        kSeeks,              // Перемещения позиции в архиве
+        kReads,              // Операции чтения архива через файловый поток
+        kBytesCopied,        // Байты, скопированные без декодирования (объединение, уплотнение)
+        kCacheHits,          // Блоки, взятые из кэша без проверки
+        kCacheMisses,
+        kCount
+    };
+
+    enum class Phase {
+        kLoadEntries,        // Чтение оглавления или просмотр архива
+        kEncoding,
+        kExtraction,
+        kDeletion,
+        kVacuum,
+        kMerge,
+        kVerification,
+        kScrub,
+        kCount
+    };
+
+/**
+ * \brief Суммарное время этапа
+ * \param wall_ns Астрономическое время, нс
+ * \param cpu_ns Процессорное время процесса (всех потоков), нс
+*/
+    struct PhaseTime {
+        uint64_t wall_ns;
+        uint64_t cpu_ns;
+        uint64_t calls;
+    };
+
+/**
+ * \brief Измеряет время этапа от создания до уничтожения объекта
+ * \note Если сбор метрик выключен, время не измеряется
+*/
+    class PhaseTimer {
+    public:
+        PhaseTimer(Metrics& metrics, Phase phase);
+        ~PhaseTimer();
+        PhaseTimer(const PhaseTimer&) = delete;
+        PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+    private:
+        Metrics& metrics_;
+        Phase phase_;
+        bool active_;
+        std::chrono::steady_clock::time_point wall_start_;
+        std::clock_t cpu_start_;
+    };
+
+    Metrics();
+
+    void SetEnabled(bool enabled);
+    bool IsEnabled() const;
+
+    void Add(Counter counter, uint64_t value) {
+        if (enabled_.load(std::memory_order_relaxed)) {
+            counters_[static_cast<size_t>(counter)].fetch_add(value, std::memory_order_relaxed);
+        }
+    }
+
+    uint64_t Get(Counter counter) const;
+    PhaseTime GetPhaseTime(Phase phase) const;
+    void Reset();
+
+/**
+ * \brief Сериализует значения в JSON: {"counters": {...}, "phases": {<этап>: 
+ * {"wall_ms", "cpu_ms", "calls"}}}
+*/
+    std::string ToJson() const;
+
+    static const char* GetName(Counter counter);
+    static const char* GetName(Phase phase);
+
+private:
+    static constexpr size_t kCountersCount = static_cast<size_t>(Counter::kCount);
+    static constexpr size_t kPhasesCount = static_cast<size_t>(Phase::kCount);
+
+    void AddPhaseTime(Phase phase, uint64_t wall_ns, uint64_t cpu_ns);
+
+    std::atomic<bool> enabled_;
+    std::array<std::atomic<uint64_t>, kCountersCount> counters_;
+    std::array<std::atomic<uint64_t>, kPhasesCount> wall_ns_;
+    std::array<std::atomic<uint64_t>, kPhasesCount> cpu_ns_;
+    std::array<std::atomic<uint64_t>, kPhasesCount> calls_;
+};
+
+#endif  // METRICS_HPP
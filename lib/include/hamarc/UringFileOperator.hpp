@@ -0,0 +1,27 @@
+#ifndef URINGFILEOPERATOR_HPP
+#define URINGFILEOPERATOR_HPP
+
+#include "DiskFileOperator.hpp"
+
+/**
+ * \brief Файлы на диске, читаемые и записываемые через io_uring (см. IoUring):
+ * у каждого открытого файла несколько запросов находятся в обработке одновременно.
+ * Последовательное чтение опережает запрошенные данные, а запись возвращает 
+ * управление, скопировав данные в буфер, и завершается асинхронно
+ * (дожидается её RandomAccessFile::Sync)
+ * \note Если ядро не поддерживает io_uring, файлы читаются и записываются 
+ * синхронно, как у FdFileOperator. Файлы не отображаются в память: архивы 
+ * также читаются через кольцо
+*/
+class UringFileOperator : public FdFileOperator {
+public:
+    using FdFileOperator::FdFileOperator;
+
+    bool OpenMapped(std::filesystem::path file, MappedFile& mapping) override;
+
+protected:
+    std::unique_ptr<RandomAccessFile> OpenFile(const std::filesystem::path& file, 
+        bool writable, bool create, bool truncate) override;
+};
+
+#endif  // URINGFILEOPERATOR_HPP
@@ -0,0 +1,59 @@
+#ifndef WORKSTEALINGQUEUE_HPP
+#define WORKSTEALINGQUEUE_HPP
+
+#include <deque>
+#include <mutex>
+#include <vector>
+
+/**
+ * \brief Очередь задач с перехватом работы.
+ * У каждого потока своя очередь: поток берёт задачи из её начала, а когда она
+ * опустеет - забирает задачи из конца очередей других потоков.
+ * \note Рассчитана на случай, когда все задачи добавлены до запуска потоков
+*/
+template <typename Task>
+class WorkStealingQueue {
+public:
+    explicit WorkStealingQueue(size_t workers_count) : queues(workers_count) {}
+
+    void Push(size_t worker, Task task) {
+        std::lock_guard<std::mutex> lock(queues[worker].mutex);
+        queues[worker].tasks.push_back(std::move(task));
+    }
+
+/**
+ * \brief Извлекает задачу для потока
+ * \return false, если задач не осталось ни в одной очереди
+*/
+    bool Pop(size_t worker, Task& task) {
+        {
+            std::lock_guard<std::mutex> lock(queues[worker].mutex);
+            if (!queues[worker].tasks.empty()) {
+                task = std::move(queues[worker].tasks.front());
+                queues[worker].tasks.pop_front();
+                return true;
+            }
+        }
+        for (size_t i = 1; i < queues.size(); ++i) {
+            WorkerQueue& victim = queues[(worker + i) % queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                task = std::move(victim.tasks.back());
+                victim.tasks.pop_back();
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<WorkerQueue> queues;
+};
+
+#endif  // WORKSTEALINGQUEUE_HPP
@@ -258,11 +258,8 @@ bool ArgParser::Parse(const std::vector<std::string>& args) {
             // std::cerr << "Error: empty arg\n";
             return false;
         }
-        if (cur_arg[0] == '-') {
-            if (cur_arg.size() == 1) {
-                // std::cerr << "Error: \'-\' arg\n";
-                return false;
-            }
+        // Одиночный '-' - позиционный аргумент (обычно обозначает stdin)
+        if (cur_arg[0] == '-' && cur_arg.size() > 1) {
             if (cur_arg[1] != '-') {
                 if (!ParseShortArg(cur_arg.substr(1))) {
                     // std::cerr << "Error: invalid short arg\n";
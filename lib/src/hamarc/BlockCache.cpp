@@ -0,0 +1,111 @@
+#include <cstring>
+
+#include "BlockCache.hpp"
+
+size_t BlockCache::KeyHash::operator()(const Key& key) const {
+    // Смещения соседних блоков отличаются на размер блока, поэтому перемешиваются
+    uint64_t hash = key.archive_id * 0x9E3779B97F4A7C15ull ^ key.block_offset;
+    hash ^= hash >> 31;
+    hash *= 0xBF58476D1CE4E5B9ull;
+    hash ^= hash >> 29;
+
+    return static_cast<size_t>(hash);
+}
+
+BlockCache::BlockCache() : capacity_(0), next_id_(1) {}
+
+BlockCache::~BlockCache() {
+    Clear();
+}
+
+void BlockCache::SetCapacity(size_t capacity) {
+    Clear();
+    capacity_ = capacity;
+}
+
+size_t BlockCache::GetCapacity() const {
+    return capacity_;
+}
+
+bool BlockCache::IsEnabled() const {
+    return capacity_ != 0;
+}
+
+uint64_t BlockCache::GetArchiveId(const std::filesystem::path& path, size_t size,
+    std::filesystem::file_time_type write_time) {
+
+    std::lock_guard<std::mutex> lock(archives_mutex_);
+    auto it = archives_.find(path.string());
+    if (it != archives_.end() && it->second.size == size && it->second.write_time == write_time) {
+        return it->second.id;
+    }
+    archives_[path.string()] = ArchiveState{next_id_, size, write_time};
+
+    return next_id_++;
+}
+
+void BlockCache::Invalidate(const std::filesystem::path& path) {
+    std::lock_guard<std::mutex> lock(archives_mutex_);
+    archives_.erase(path.string());
+}
+
+bool BlockCache::Get(uint64_t archive_id, size_t block_offset, uint8_t* data, size_t size) {
+    Key key{archive_id, block_offset};
+    Shard& shard = GetShard(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.positions.find(key);
+    if (it == shard.positions.end() || it->second->size != size) {
+        return false;
+    }
+    shard.blocks.splice(shard.blocks.begin(), shard.blocks, it->second);
+    std::memcpy(data, it->second->data, size);
+
+    return true;
+}
+
+void BlockCache::Put(uint64_t archive_id, size_t block_offset, const uint8_t* data, size_t size) {
+    size_t shard_capacity = capacity_ / kShardsCount;
+    if (size > shard_capacity) {
+        return;
+    }
+    Key key{archive_id, block_offset};
+    Shard& shard = GetShard(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (shard.positions.find(key) != shard.positions.end()) {
+        return;
+    }
+    while (shard.size + size > shard_capacity) {
+        Block& evicted = shard.blocks.back();
+        shard.size -= evicted.size;
+        shard.positions.erase(evicted.key);
+        delete [] evicted.data;
+        shard.blocks.pop_back();
+    }
+    uint8_t* block_data = new uint8_t[size];
+    std::memcpy(block_data, data, size);
+    shard.blocks.push_front(Block{key, block_data, size});
+    shard.positions[key] = shard.blocks.begin();
+    shard.size += size;
+}
+
+void BlockCache::Clear() {
+    for (size_t i = 0; i < kShardsCount; ++i) {
+        std::lock_guard<std::mutex> lock(shards_[i].mutex);
+        ClearShard(shards_[i]);
+    }
+    std::lock_guard<std::mutex> lock(archives_mutex_);
+    archives_.clear();
+}
+
+BlockCache::Shard& BlockCache::GetShard(const Key& key) {
+    return shards_[KeyHash{}(key) % kShardsCount];
+}
+
+void BlockCache::ClearShard(Shard& shard) {
+    for (Block& block : shard.blocks) {
+        delete [] block.data;
+    }
+    shard.blocks.clear();
+    shard.positions.clear();
+    shard.size = 0;
+}
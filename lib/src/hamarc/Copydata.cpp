@@ -1,6 +1,20 @@
+#include <cstdlib>
+
 #include "Copydata.hpp"
 
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define HAMARC_HAS_POSIX_IO
+#endif
+#ifdef __linux__
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#endif
+
 const size_t Copydata::kMaxBufferSize = 8192;
+const size_t Copydata::kRangeBufferSize = 1024 * 1024;
 
 
 Copydata::CopyingResult Copydata::CopyData(std::istream& reader, std::ostream& writer, 
@@ -33,3 +47,127 @@ Copydata::CopyingResult Copydata::CopyData(std::istream& reader, std::ostream& w
 
     return cur_state;
 }
+
+Copydata::CopyingResult Copydata::CopyRange(const std::filesystem::path& src, size_t src_offset, 
+    const std::filesystem::path& dst, size_t dst_offset, size_t data_size) {
+
+#ifdef HAMARC_HAS_POSIX_IO
+    int src_fd = open(src.c_str(), O_RDONLY);
+    if (src_fd == -1) {
+        return CopyingResult::kReaderCorrupted;
+    }
+    int dst_fd = open(dst.c_str(), O_WRONLY);
+    if (dst_fd == -1) {
+        close(src_fd);
+        return CopyingResult::kReaderCorrupted;
+    }
+
+    size_t copied = 0;
+    if (CloneRange(src_fd, src_offset, dst_fd, dst_offset, data_size)) {
+        copied = data_size;
+    }
+    if (copied < data_size) {
+        copied += CopyFileRange(src_fd, src_offset + copied, dst_fd, dst_offset + copied, 
+            data_size - copied);
+    }
+    if (copied < data_size) {
+        copied += CopyBuffered(src_fd, src_offset + copied, dst_fd, dst_offset + copied, 
+            data_size - copied);
+    }
+    close(src_fd);
+    close(dst_fd);
+
+    return copied == data_size ? CopyingResult::kSuccess : CopyingResult::kReaderEOFReached;
+#else
+    std::ifstream reader(src, std::ifstream::binary);
+    std::fstream writer(dst, std::fstream::in | std::fstream::out | std::fstream::binary);
+    if (!reader.is_open() || !writer.is_open()) {
+        return CopyingResult::kReaderCorrupted;
+    }
+    reader.seekg(src_offset, std::ifstream::beg);
+    writer.seekp(dst_offset, std::fstream::beg);
+
+    return CopyData(reader, writer, data_size);
+#endif
+}
+
+bool Copydata::CloneRange(int src_fd, size_t src_offset, int dst_fd, size_t dst_offset, 
+    size_t data_size) {
+
+#if defined(__linux__) && defined(FICLONERANGE)
+    // Клонировать можно только участки, выровненные по блокам файловой системы
+    struct stat dst_stat;
+    if (data_size == 0 || fstat(dst_fd, &dst_stat) != 0) {
+        return false;
+    }
+    size_t fs_block_size = dst_stat.st_blksize;
+    if (src_offset % fs_block_size != 0 || dst_offset % fs_block_size != 0 
+        || data_size % fs_block_size != 0) {
+
+        return false;
+    }
+    struct file_clone_range range;
+    range.src_fd = src_fd;
+    range.src_offset = src_offset;
+    range.src_length = data_size;
+    range.dest_offset = dst_offset;
+
+    return ioctl(dst_fd, FICLONERANGE, &range) == 0;
+#else
+    return false;
+#endif
+}
+
+size_t Copydata::CopyFileRange(int src_fd, size_t src_offset, int dst_fd, size_t dst_offset, 
+    size_t data_size) {
+
+    size_t copied = 0;
+#ifdef __linux__
+    loff_t src_pos = src_offset;
+    loff_t dst_pos = dst_offset;
+    while (copied < data_size) {
+        ssize_t res = copy_file_range(src_fd, &src_pos, dst_fd, &dst_pos, data_size - copied, 0);
+        // Ошибка (например, файлы на разных файловых системах) или конец 
+        // исходного файла: остаток копируется через буфер
+        if (res <= 0) {
+            break;
+        }
+        copied += res;
+    }
+#endif
+    return copied;
+}
+
+size_t Copydata::CopyBuffered(int src_fd, size_t src_offset, int dst_fd, size_t dst_offset, 
+    size_t data_size) {
+
+    size_t copied = 0;
+#ifdef HAMARC_HAS_POSIX_IO
+    void* buffer;
+    if (posix_memalign(&buffer, 4096, kRangeBufferSize) != 0) {
+        return 0;
+    }
+    while (copied < data_size) {
+        size_t to_read = std::min(kRangeBufferSize, data_size - copied);
+        ssize_t read_size = pread(src_fd, buffer, to_read, src_offset + copied);
+        if (read_size <= 0) {
+            break;
+        }
+        ssize_t written = 0;
+        while (written < read_size) {
+            ssize_t res = pwrite(dst_fd, static_cast<char*>(buffer) + written, 
+                read_size - written, dst_offset + copied + written);
+            if (res <= 0) {
+                break;
+            }
+            written += res;
+        }
+        copied += written;
+        if (written < read_size) {
+            break;
+        }
+    }
+    free(buffer);
+#endif
+    return copied;
+}
@@ -0,0 +1,54 @@
+#include <algorithm>
+#include <new>
+
+#include "DecoderContext.hpp"
+#include "Encoder.hpp"
+
+const size_t DecoderContext::kAlignment = 64;
+
+DecoderContext::DecoderContext() 
+    : encoded_buffer_(nullptr), fix_buffer_(nullptr), max_block_size_(0) {}
+
+DecoderContext::DecoderContext(size_t max_block_size) : DecoderContext() {
+    Reserve(max_block_size);
+}
+
+DecoderContext::~DecoderContext() {
+    Release();
+}
+
+void DecoderContext::Reserve(size_t max_block_size) {
+    if (encoded_buffer_ != nullptr && max_block_size <= max_block_size_) {
+        return;
+    }
+    Release();
+    size_t encoded_size = max_block_size + Encoder::GetCodeBitSize(max_block_size * 8) / 8 + 1;
+    encoded_buffer_ = static_cast<uint8_t*>(
+        ::operator new[](encoded_size, std::align_val_t{kAlignment}));
+    // Буфер исправленного блока не бывает пустым, чтобы указатель был действительным
+    fix_buffer_ = static_cast<uint8_t*>(
+        ::operator new[](std::max(max_block_size, static_cast<size_t>(1)), std::align_val_t{kAlignment}));
+    max_block_size_ = max_block_size;
+}
+
+uint8_t* DecoderContext::GetEncodedBuffer() {
+    return encoded_buffer_;
+}
+
+uint8_t* DecoderContext::GetFixBuffer() {
+    return fix_buffer_;
+}
+
+size_t DecoderContext::GetMaxBlockSize() const {
+    return max_block_size_;
+}
+
+void DecoderContext::Release() {
+    if (encoded_buffer_ != nullptr) {
+        ::operator delete[](encoded_buffer_, std::align_val_t{kAlignment});
+        ::operator delete[](fix_buffer_, std::align_val_t{kAlignment});
+    }
+    encoded_buffer_ = nullptr;
+    fix_buffer_ = nullptr;
+    max_block_size_ = 0;
+}
@@ -0,0 +1,320 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "DirectFileOperator.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define HAMARC_HAS_POSIX_IO
+#endif
+
+#if defined(HAMARC_HAS_POSIX_IO) && defined(O_DIRECT)
+namespace {
+
+/**
+ * \brief Выровненные по DirectFileOperator::kDirectAlignment буферы, 
+ * повторно используемые открываемыми файлами
+*/
+class AlignedBufferPool {
+public:
+    static constexpr size_t kBufferSize = 1024 * 1024;
+
+    static uint8_t* Acquire() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (free_.buffers.empty()) {
+            return static_cast<uint8_t*>(std::aligned_alloc(DirectFileOperator::kDirectAlignment, kBufferSize));
+        }
+        uint8_t* buffer = free_.buffers.back();
+        free_.buffers.pop_back();
+
+        return buffer;
+    }
+
+    static void Release(uint8_t* buffer) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_.buffers.push_back(buffer);
+    }
+
+private:
+    // Свободные буферы освобождаются при завершении программы; 
+    // они получены от std::aligned_alloc, поэтому освобождаются std::free
+    struct FreeList {
+        std::vector<uint8_t*> buffers;
+
+        ~FreeList() {
+            for (uint8_t* buffer : buffers) {
+                std::free(buffer);
+            }
+        }
+    };
+
+    static inline std::mutex mutex_;
+    static inline FreeList free_;
+};
+
+/**
+ * \brief Общее состояние всех открытых дескрипторов одного файла. Запись 
+ * дописывает неполные крайние блоки, прочитав их с диска, поэтому записи 
+ * разных дескрипторов (например, соседних частей при параллельном извлечении) 
+ * выполняются по очереди, а последний неполный блок хранится один на файл
+*/
+struct SharedFileState {
+    static constexpr size_t kNoBlock = static_cast<size_t>(-1);
+
+    SharedFileState() : tail(AlignedBufferPool::Acquire()), tail_offset(kNoBlock), size(0) {}
+
+    ~SharedFileState() {
+        AlignedBufferPool::Release(tail);
+    }
+
+    std::mutex mutex;
+    uint8_t* tail;              // последний неполный записанный блок
+    size_t tail_offset;
+    size_t size;                // размер файла
+};
+
+/**
+ * \brief Возвращает общее состояние файла по его устройству и номеру inode
+*/
+std::shared_ptr<SharedFileState> GetSharedFileState(const struct stat& file_stat) {
+    static std::mutex registry_mutex;
+    static std::map<std::pair<dev_t, ino_t>, std::weak_ptr<SharedFileState>> registry;
+
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    std::pair<dev_t, ino_t> key{file_stat.st_dev, file_stat.st_ino};
+    auto found = registry.find(key);
+    std::shared_ptr<SharedFileState> state = found != registry.end() ? found->second.lock() : nullptr;
+    if (state != nullptr) {
+        return state;
+    }
+    // Состояния закрытых файлов удаляются при открытии новых
+    for (auto it = registry.begin(); it != registry.end();) {
+        it = it->second.expired() ? registry.erase(it) : std::next(it);
+    }
+    state = std::make_shared<SharedFileState>();
+    registry[key] = state;
+
+    return state;
+}
+
+size_t AlignDown(size_t offset) {
+    return offset & ~(DirectFileOperator::kDirectAlignment - 1);
+}
+
+size_t AlignUp(size_t offset) {
+    return AlignDown(offset + DirectFileOperator::kDirectAlignment - 1);
+}
+
+class DirectFile : public RandomAccessFile {
+public:
+    DirectFile(int fd, const struct stat& file_stat, bool truncated) : fd_(fd), 
+        buffer_(AlignedBufferPool::Acquire()), state_(GetSharedFileState(file_stat)) {
+
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        state_->size = static_cast<size_t>(file_stat.st_size);
+        if (truncated) {
+            state_->tail_offset = kNoBlock;
+        }
+    }
+
+    ~DirectFile() {
+        AlignedBufferPool::Release(buffer_);
+        close(fd_);
+    }
+
+    size_t ReadAt(size_t offset, uint8_t* data, size_t size) override {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        size_t done = 0;
+        while (done < size) {
+            size_t position = offset + done;
+            size_t rest = size - done;
+            // Выровненная часть читается сразу в data
+            if (position % kAlignment == 0 && rest >= kAlignment
+                && reinterpret_cast<uintptr_t>(data + done) % kAlignment == 0) {
+
+                size_t length = AlignDown(rest);
+                size_t read = ReadAligned(position, data + done, length);
+                done += read;
+                if (read < length) {
+                    break;
+                }
+                continue;
+            }
+            size_t begin = AlignDown(position);
+            size_t length = std::min(AlignUp(position + rest) - begin, AlignedBufferPool::kBufferSize);
+            size_t read = ReadAligned(begin, buffer_, length);
+            if (read <= position - begin) {
+                break;
+            }
+            size_t part = std::min(read - (position - begin), rest);
+            std::memcpy(data + done, buffer_ + (position - begin), part);
+            done += part;
+            if (read < length) {
+                break;
+            }
+        }
+
+        return done;
+    }
+
+    bool WriteAt(size_t offset, const uint8_t* data, size_t size) override {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        for (size_t done = 0; done < size;) {
+            size_t position = offset + done;
+            size_t begin = AlignDown(position);
+            size_t length = std::min(AlignUp(position + size - done) - begin, AlignedBufferPool::kBufferSize);
+            size_t part = std::min(size - done, length - (position - begin));
+            size_t end = position + part;
+            size_t last_block = AlignDown(end);
+            if (position != begin) {
+                LoadBlock(begin, buffer_);
+            }
+            if (end != last_block && (last_block != begin || position == begin)) {
+                LoadBlock(last_block, buffer_ + (last_block - begin));
+            }
+            std::memcpy(buffer_ + (position - begin), data + done, part);
+            length = AlignUp(end) - begin;
+            if (!WriteAligned(begin, buffer_, length)) {
+                state_->tail_offset = kNoBlock;
+                return false;
+            }
+            if (end != last_block) {
+                state_->tail_offset = last_block;
+            }
+            size_t tail_offset = state_->tail_offset;
+            if (tail_offset != kNoBlock && tail_offset >= begin && tail_offset < begin + length) {
+                std::memcpy(state_->tail, buffer_ + (tail_offset - begin), kAlignment);
+            }
+            // Дополнение последнего блока нулями не должно увеличивать файл
+            size_t new_size = std::max(state_->size, end);
+            if (begin + length > new_size && ftruncate(fd_, new_size) != 0) {
+                return false;
+            }
+            state_->size = new_size;
+            done += part;
+        }
+
+        return true;
+    }
+
+    size_t GetSize() override {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        struct stat file_stat;
+        if (fstat(fd_, &file_stat) == 0) {
+            state_->size = static_cast<size_t>(file_stat.st_size);
+        }
+
+        return state_->size;
+    }
+
+    // O_DIRECT не сохраняет метаданные файла (например, его размер)
+    bool SyncToDevice() override {
+        return fsync(fd_) == 0;
+    }
+
+private:
+    static constexpr size_t kNoBlock = SharedFileState::kNoBlock;
+    static constexpr size_t kAlignment = DirectFileOperator::kDirectAlignment;
+
+/**
+ * \brief Загружает в dst блок файла по выровненному смещению; 
+ * часть блока за концом файла заполняется нулями
+*/
+    void LoadBlock(size_t block_offset, uint8_t* dst) {
+        if (block_offset == state_->tail_offset) {
+            std::memcpy(dst, state_->tail, kAlignment);
+            return;
+        }
+        size_t read = block_offset < state_->size ? ReadAligned(block_offset, dst, kAlignment) : 0;
+        std::memset(dst + read, 0, kAlignment - read);
+    }
+
+/**
+ * \brief Читает по выровненным смещению, адресу и длине
+ * \return Количество прочитанных байт: меньше length в конце файла или при ошибке
+*/
+    size_t ReadAligned(size_t offset, uint8_t* data, size_t length) {
+        size_t done = 0;
+        while (done < length) {
+            ssize_t read = pread(fd_, data + done, length - done, offset + done);
+            if (read == -1 && errno == EINTR) {
+                continue;
+            }
+            if (read <= 0) {
+                break;
+            }
+            done += read;
+            // Невыровненный остаток означает конец файла
+            if (read % kAlignment != 0) {
+                break;
+            }
+        }
+
+        return done;
+    }
+
+    bool WriteAligned(size_t offset, const uint8_t* data, size_t length) {
+        size_t done = 0;
+        while (done < length) {
+            ssize_t written = pwrite(fd_, data + done, length - done, offset + done);
+            if (written == -1 && errno == EINTR) {
+                continue;
+            }
+            if (written <= 0 || written % kAlignment != 0) {
+                return false;
+            }
+            done += written;
+        }
+
+        return true;
+    }
+
+    int fd_;
+    uint8_t* buffer_;
+    std::shared_ptr<SharedFileState> state_;
+};
+
+}  // namespace
+#endif
+
+bool DirectFileOperator::OpenMapped(std::filesystem::path, MappedFile&) {
+    return false;
+}
+
+bool DirectFileOperator::CopyRange(std::filesystem::path src, size_t src_offset, 
+    std::filesystem::path dst, size_t dst_offset, size_t size) {
+
+    // Копирование средствами ядра проходит через кэш страниц
+    return FileOperator::CopyRange(src, src_offset, dst, dst_offset, size);
+}
+
+std::unique_ptr<RandomAccessFile> DirectFileOperator::OpenFile(const std::filesystem::path& file, 
+    bool writable, bool create, bool truncate) {
+
+#if defined(HAMARC_HAS_POSIX_IO) && defined(O_DIRECT)
+    int flags = (writable ? O_RDWR : O_RDONLY) | (create ? O_CREAT : 0) | (truncate ? O_TRUNC : 0);
+    int fd = open((dir_ / file).c_str(), flags | O_DIRECT, 0644);
+    struct stat file_stat;
+    if (fd != -1 && fstat(fd, &file_stat) == 0) {
+        return std::make_unique<DirectFile>(fd, file_stat, truncate);
+    }
+    if (fd != -1) {
+        close(fd);
+        return nullptr;
+    }
+    if (errno != EINVAL) {
+        return nullptr;
+    }
+#endif
+
+    return FdFileOperator::OpenFile(file, writable, create, truncate);
+}
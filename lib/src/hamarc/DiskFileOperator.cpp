@@ -0,0 +1,285 @@
+#include <cstring>
+#include <mutex>
+
+#include "DiskFileOperator.hpp"
+#include "Copydata.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define HAMARC_HAS_POSIX_IO
+#endif
+
+namespace {
+
+class StreamFile : public RandomAccessFile {
+public:
+    StreamFile(std::fstream&& stream) : stream_(std::move(stream)) {}
+
+    size_t ReadAt(size_t offset, uint8_t* data, size_t size) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stream_.clear();
+        stream_.seekg(offset, std::fstream::beg);
+        stream_.read(reinterpret_cast<char*>(data), size);
+        size_t read = static_cast<size_t>(stream_.gcount());
+        stream_.clear();
+
+        return read;
+    }
+
+    bool WriteAt(size_t offset, const uint8_t* data, size_t size) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stream_.clear();
+        stream_.seekp(offset, std::fstream::beg);
+        stream_.write(reinterpret_cast<const char*>(data), size);
+
+        return stream_.good();
+    }
+
+    // Поток не даёт доступа к дескриптору: данные передаются только системе
+    bool SyncToDevice() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stream_.flush();
+
+        return stream_.good();
+    }
+
+    size_t GetSize() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stream_.clear();
+        stream_.seekg(0, std::fstream::end);
+
+        return static_cast<size_t>(stream_.tellg());
+    }
+
+private:
+    std::mutex mutex_;
+    std::fstream stream_;
+};
+
+#ifdef HAMARC_HAS_POSIX_IO
+class FdFile : public RandomAccessFile {
+public:
+    FdFile(int fd) : fd_(fd) {}
+
+    ~FdFile() {
+        close(fd_);
+    }
+
+    size_t ReadAt(size_t offset, uint8_t* data, size_t size) override {
+        size_t done = 0;
+        while (done < size) {
+            ssize_t read = pread(fd_, data + done, size - done, offset + done);
+            if (read == -1 && errno == EINTR) {
+                continue;
+            }
+            if (read <= 0) {
+                break;
+            }
+            done += read;
+        }
+
+        return done;
+    }
+
+    bool WriteAt(size_t offset, const uint8_t* data, size_t size) override {
+        size_t done = 0;
+        while (done < size) {
+            ssize_t written = pwrite(fd_, data + done, size - done, offset + done);
+            if (written == -1 && errno == EINTR) {
+                continue;
+            }
+            if (written <= 0) {
+                return false;
+            }
+            done += written;
+        }
+
+        return true;
+    }
+
+    bool SyncToDevice() override {
+        return fsync(fd_) == 0;
+    }
+
+    size_t GetSize() override {
+        struct stat file_stat;
+        return fstat(fd_, &file_stat) == 0 ? static_cast<size_t>(file_stat.st_size) : 0;
+    }
+
+private:
+    int fd_;
+};
+#endif
+
+class MappedReadFile : public RandomAccessFile {
+public:
+    MappedFile& GetMapping() {
+        return mapping_;
+    }
+
+    size_t ReadAt(size_t offset, uint8_t* data, size_t size) override {
+        if (offset >= mapping_.GetSize()) {
+            return 0;
+        }
+        size = std::min(size, mapping_.GetSize() - offset);
+        std::memcpy(data, mapping_.GetData() + offset, size);
+
+        return size;
+    }
+
+    bool WriteAt(size_t, const uint8_t*, size_t) override {
+        return false;
+    }
+
+    size_t GetSize() override {
+        return mapping_.GetSize();
+    }
+
+    const uint8_t* GetData() override {
+        return mapping_.GetData();
+    }
+
+private:
+    MappedFile mapping_;
+};
+
+}  // namespace
+
+std::shared_ptr<FileOperator> DiskFileOperator::CreateDefault(std::filesystem::path init_dir) {
+#ifdef HAMARC_HAS_POSIX_IO
+    return std::make_shared<FdFileOperator>(init_dir);
+#else
+    return std::make_shared<StreamFileOperator>(init_dir);
+#endif
+}
+
+void DiskFileOperator::SetDir(std::filesystem::path new_dir) {
+    FileOperator::SetDir(new_dir);
+    std::filesystem::create_directories(new_dir);
+}
+
+bool DiskFileOperator::FileExists(std::filesystem::path filename) {
+    std::error_code error;
+    std::filesystem::file_status status = std::filesystem::status(dir_ / filename, error);
+    return std::filesystem::exists(status) && !std::filesystem::is_directory(status);
+}
+
+size_t DiskFileOperator::GetFileSize(std::filesystem::path filename) {
+    std::error_code error;
+    size_t size = std::filesystem::file_size(dir_ / filename, error);
+    return error ? 0 : size;
+}
+
+std::filesystem::file_time_type DiskFileOperator::GetLastWriteTime(std::filesystem::path filename) {
+    std::error_code error;
+    return std::filesystem::last_write_time(dir_ / filename, error);
+}
+
+std::filesystem::path DiskFileOperator::GetPath(std::filesystem::path filename) {
+    std::error_code error;
+    std::filesystem::path path = std::filesystem::absolute(dir_ / filename, error);
+    return error ? dir_ / filename : path.lexically_normal();
+}
+
+bool DiskFileOperator::CreateDir(std::filesystem::path name) {
+    return std::filesystem::create_directories(dir_ / name);
+}
+
+bool DiskFileOperator::DeleteFile(std::filesystem::path filename) {
+    return std::filesystem::remove(dir_ / filename);
+}
+
+size_t DiskFileOperator::DeleteDir(std::filesystem::path name) {
+    return std::filesystem::remove_all(dir_ / name);
+}
+
+void DiskFileOperator::RenameFile(std::filesystem::path old_name, 
+        std::filesystem::path new_name) {
+    
+    std::filesystem::rename(dir_ / old_name, dir_ / new_name);
+}
+
+void DiskFileOperator::ResizeFile(std::filesystem::path filename, size_t new_size) {
+    std::filesystem::resize_file(dir_ / filename, new_size);
+}
+
+bool DiskFileOperator::SyncDir(std::filesystem::path name) {
+#ifdef HAMARC_HAS_POSIX_IO
+    int fd = open((dir_ / name).c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd == -1) {
+        return false;
+    }
+    bool synced = fsync(fd) == 0;
+    close(fd);
+
+    return synced;
+#else
+    return true;
+#endif
+}
+
+bool DiskFileOperator::OpenMapped(std::filesystem::path file, MappedFile& mapping) {
+    return mapping.Open(dir_ / file);
+}
+
+bool DiskFileOperator::CopyRange(std::filesystem::path src, size_t src_offset, 
+    std::filesystem::path dst, size_t dst_offset, size_t size) {
+
+    return Copydata::CopyRange(dir_ / src, src_offset, dir_ / dst, dst_offset, size) 
+        == Copydata::CopyingResult::kSuccess;
+}
+
+std::unique_ptr<RandomAccessFile> StreamFileOperator::OpenFile(const std::filesystem::path& file, 
+    bool writable, bool create, bool truncate) {
+
+    std::filesystem::path path = dir_ / file;
+    if (create && !truncate && !std::filesystem::exists(path)) {
+        std::ofstream creator(path, std::fstream::binary);
+    }
+    std::fstream::openmode openmode = std::fstream::in | std::fstream::binary;
+    if (writable) {
+        openmode |= std::fstream::out;
+    }
+    if (truncate) {
+        openmode |= std::fstream::trunc;
+    }
+    std::fstream stream(path, openmode);
+    if (!stream.is_open()) {
+        return nullptr;
+    }
+
+    return std::make_unique<StreamFile>(std::move(stream));
+}
+
+std::unique_ptr<RandomAccessFile> FdFileOperator::OpenFile(const std::filesystem::path& file, 
+    bool writable, bool create, bool truncate) {
+
+#ifdef HAMARC_HAS_POSIX_IO
+    int flags = (writable ? O_RDWR : O_RDONLY) | (create ? O_CREAT : 0) | (truncate ? O_TRUNC : 0);
+    int fd = open((dir_ / file).c_str(), flags, 0644);
+    if (fd == -1) {
+        return nullptr;
+    }
+
+    return std::make_unique<FdFile>(fd);
+#else
+    return nullptr;
+#endif
+}
+
+std::unique_ptr<RandomAccessFile> MappedFileOperator::OpenFile(const std::filesystem::path& file, 
+    bool writable, bool create, bool truncate) {
+
+    if (!writable) {
+        std::unique_ptr<MappedReadFile> mapped = std::make_unique<MappedReadFile>();
+        // Пустые файлы не отображаются и читаются через дескриптор
+        if (mapped->GetMapping().Open(dir_ / file)) {
+            return mapped;
+        }
+    }
+
+    return FdFileOperator::OpenFile(file, writable, create, truncate);
+}
@@ -1,16 +1,8 @@
 #include "Encoder.hpp"
+#include "HammingKernel.hpp"
 
 const size_t Encoder::kMaxBufferSize = 8192;
 
-void Encoder::ShiftAndRead(
-    std::istream& reader, std::streamoff offset, 
-    size_t data_size, char* buf) {
-
-    reader.seekg(offset, std::ios::cur);
-    reader.read(buf, data_size);
-    reader.seekg(-(offset + data_size), std::ios::cur);
-}
-
 bool Encoder::GetByteParityBit(uint8_t byte, size_t number_of_bits) {
     bool res = false;
     for (size_t i = 0; i < number_of_bits; ++i) {
@@ -20,6 +12,66 @@ bool Encoder::GetByteParityBit(uint8_t byte, size_t number_of_bits) {
     return res;
 }
 
+bool Encoder::GetWordParityBit(uint64_t word) {
+    word ^= word >> 32;
+    word ^= word >> 16;
+    word ^= word >> 8;
+    word ^= word >> 4;
+    word ^= word >> 2;
+    word ^= word >> 1;
+
+    return word & 1;
+}
+
+uint64_t Encoder::LoadWord(const uint8_t* msg, size_t raw_msg_size, size_t word_index) {
+    const uint8_t* bytes = msg + word_index * 8;
+    if (word_index * 8 + 8 <= raw_msg_size) {
+        return (static_cast<uint64_t>(bytes[0]) << 56) | (static_cast<uint64_t>(bytes[1]) << 48) |
+        (static_cast<uint64_t>(bytes[2]) << 40) | (static_cast<uint64_t>(bytes[3]) << 32) |
+        (static_cast<uint64_t>(bytes[4]) << 24) | (static_cast<uint64_t>(bytes[5]) << 16) |
+        (static_cast<uint64_t>(bytes[6]) << 8) | static_cast<uint64_t>(bytes[7]);
+    }
+
+    uint64_t word = 0;
+    for (size_t i = 0; word_index * 8 + i < raw_msg_size; ++i) {
+        word |= static_cast<uint64_t>(bytes[i]) << (56 - 8 * i);
+    }
+
+    return word;
+}
+
+void Encoder::AccumulateWord(uint64_t word, size_t window, uint64_t low_mask,
+    uint64_t& run_word, size_t& window_xor) {
+
+    run_word ^= word;
+    if (GetWordParityBit(word & low_mask)) {
+        window_xor ^= window;
+    }
+    if (GetWordParityBit(word & ~low_mask)) {
+        window_xor ^= window + 1;
+    }
+}
+
+size_t Encoder::GetRunSyndrome(uint64_t word, size_t window_xor, size_t offset) {
+    // Маски бит слова, номера позиций которых (по модулю 64) содержат бит s
+    static const uint64_t kPositionMasks[6] = {
+        0x5555555555555555, 0x3333333333333333, 0x0F0F0F0F0F0F0F0F,
+        0x00FF00FF00FF00FF, 0x0000FFFF0000FFFF, 0x00000000FFFFFFFF
+    };
+
+    // Сдвиг позиций на offset % 64 внутри окна - циклический сдвиг слова
+    size_t shift = offset % 64;
+    if (shift != 0) {
+        word = (word >> shift) | (word << (64 - shift));
+    }
+    size_t syndrome = window_xor << 6;
+    for (size_t s = 0; s < 6; ++s) {
+        syndrome ^= static_cast<size_t>(GetWordParityBit(word & kPositionMasks[s])) << s;
+    }
+
+    return syndrome;
+}
+
 size_t Encoder::GetCodeBitSize(size_t msg_bit_size) {
     if (msg_bit_size == 0) {
         return 0;
@@ -56,9 +108,7 @@ bool Encoder::GetMsgParityBit(std::istream& reader, size_t msg_bit_size) {
         
         size_t to_read = std::min(buffer_size, msg_size - (pos - start_pos));
         reader.read(reinterpret_cast<char*>(buffer), to_read);
-        for (size_t i = 0; i < to_read; ++i) {
-            xor_byte ^= buffer[i];
-        }
+        xor_byte ^= HammingKernel::XorBytes(buffer, to_read);
     }
 
     bool res = GetByteParityBit(xor_byte, 8);
@@ -79,115 +129,106 @@ bool Encoder::GetMsgParityBit(const uint8_t* msg, size_t msg_bit_size) {
         return res;
     }
 
-    uint8_t xor_byte = 0;
-    for (size_t i = 0; i < msg_size; ++i) {
-        xor_byte ^= msg[i];
-    }
-    bool res = GetByteParityBit(xor_byte, 8);
+    bool res = GetByteParityBit(HammingKernel::XorBytes(msg, msg_size), 8);
     if (msg_bit_size % 8 != 0) {
-        res ^= GetByteParityBit(msg[msg_size - 1], msg_bit_size % 8);
+        res ^= GetByteParityBit(msg[msg_size], msg_bit_size % 8);
     }
 
     return res;
 } 
 
 
-uint8_t* Encoder::GetCode(std::istream& reader, size_t raw_msg_size) {
-    size_t code_bit_size = GetCodeBitSize(raw_msg_size * 8);
-    size_t code_size = code_bit_size / 8 + 1;
-    uint8_t* control_bytes = new uint8_t[code_size]{};
-    
-    bool parity_bit = false;
-    size_t encoded_msg_bit_size = code_bit_size + raw_msg_size * 8;
-    size_t start_pos = reader.tellg();
-    char* buf = new char[1];
+Encoder::Syndrome Encoder::GetSyndrome(const uint8_t* msg, size_t raw_msg_size) {
+    Syndrome syndrome{0, false};
+    size_t msg_bit_size = raw_msg_size * 8;
 
-    // i - индекс контрольного бита в блоке контрольных бит (формат <сообщение><контроль>)
-    // i_ - индекс контрольного бита при вставке контрольных бит в сообщение
-    // j и j_ - индексы информационных бит в тех же форматах
-    // Индексация ind начинается с 0, ind_ - с 1
-    // Соотношения: i_ = 2^i; j = j_ - round(log2(j_), up) - 1
-    for (size_t i = 0; i < code_bit_size; ++i) {
-        bool control_bit = 0;
-        size_t i_ = (1 << i);
-        for (
-             size_t j_ = i_ + 1, log_j_ = i + 1; 
-             j_ <= encoded_msg_bit_size; j_ += i_
-            ) {
-            
-            while (j_ <= encoded_msg_bit_size && (j_ & i_) == i_) {
-                while ((1 << log_j_) < j_) {
-                    ++log_j_;
-                }
-                std::streamoff j = j_ - log_j_ - 1;
-                ShiftAndRead(reader, j / 8, 1, buf);
-                control_bit ^= BitOperator::GetBit(static_cast<uint8_t>(buf[0]), j % 8);
-                ++j_;
-            }
+    // Информационный бит j находится на позиции j_ = j + offset (нумерация с 1),
+    // где offset постоянен на участке между соседними контрольными битами:
+    // для позиций (2^k, 2^(k + 1)) offset = k + 2.
+    // Позиция раскладывается как 64 * (номер окна) + (номер бита в окне): номера бит 
+    // в окне учитываются через XOR всех слов участка, номера окон - через XOR
+    // номеров окон, в которые попало нечётное число единичных бит.
+    for (size_t k = 1; (static_cast<size_t>(1) << k) - k - 1 < msg_bit_size; ++k) {
+        size_t run_begin = (static_cast<size_t>(1) << k) - k - 1;
+        size_t run_end = std::min((static_cast<size_t>(1) << (k + 1)) - k - 2, msg_bit_size);
+        size_t offset = k + 2;
+        uint64_t low_mask = ~static_cast<uint64_t>(0) << (offset % 64);
+
+        uint64_t run_word = 0;
+        size_t window_xor = 0;
+        size_t first_word = run_begin / 64;
+        size_t last_word = (run_end - 1) / 64;
+        uint64_t head_mask = ~static_cast<uint64_t>(0) >> (run_begin % 64);
+        uint64_t tail_mask = ~static_cast<uint64_t>(0);
+        if (run_end % 64 != 0) {
+            tail_mask = ~(~static_cast<uint64_t>(0) >> (run_end % 64));
         }
-        if (control_bit) {
-            BitOperator::SetBit(control_bytes[i / 8], i % 8);
+
+        if (first_word == last_word) {
+            AccumulateWord(LoadWord(msg, raw_msg_size, first_word) & head_mask & tail_mask,
+                first_word + offset / 64, low_mask, run_word, window_xor);
+        } else {
+            AccumulateWord(LoadWord(msg, raw_msg_size, first_word) & head_mask,
+                first_word + offset / 64, low_mask, run_word, window_xor);
+            // Полные слова внутри участка обрабатываются векторным ядром
+            HammingKernel::AccumulateRun(msg + (first_word + 1) * 8, last_word - first_word - 1,
+                first_word + 1 + offset / 64, low_mask, run_word, window_xor);
+            AccumulateWord(LoadWord(msg, raw_msg_size, last_word) & tail_mask,
+                last_word + offset / 64, low_mask, run_word, window_xor);
         }
-        parity_bit ^= control_bit;
+        syndrome.positions ^= GetRunSyndrome(run_word, window_xor, offset);
+        syndrome.parity ^= GetWordParityBit(run_word);
     }
-    delete [] buf;
 
-    parity_bit ^= GetMsgParityBit(reader, raw_msg_size * 8);
-    if (parity_bit) {
-        BitOperator::SetBit(control_bytes[code_size - 1], code_bit_size % 8);
-    }
+    return syndrome;
+}
+
+uint8_t* Encoder::GetCode(std::istream& reader, size_t raw_msg_size) {
+    uint8_t* msg = new uint8_t[raw_msg_size];
+    reader.read(reinterpret_cast<char*>(msg), raw_msg_size);
+    uint8_t* control_bytes = GetCode(msg, raw_msg_size);
+    delete [] msg;
 
     return control_bytes;
 }
 
 uint8_t* Encoder::GetCode(const uint8_t* msg, size_t raw_msg_size) {
+    uint8_t* control_bytes = new uint8_t[GetCodeBitSize(raw_msg_size * 8) / 8 + 1];
+    GetCode(msg, raw_msg_size, control_bytes);
+
+    return control_bytes;
+}
+
+void Encoder::GetCode(const uint8_t* msg, size_t raw_msg_size, uint8_t* control_bytes) {
     size_t code_bit_size = GetCodeBitSize(raw_msg_size * 8);
     size_t code_size = code_bit_size / 8 + 1;
-    uint8_t* control_bytes = new uint8_t[code_size]{};
+    std::fill(control_bytes, control_bytes + code_size, 0);
     
-    bool parity_bit = false;
-    size_t encoded_msg_bit_size = code_bit_size + raw_msg_size * 8;
-
-    uint8_t cur_byte = 0;
-    // i - индекс контрольного бита в блоке контрольных бит (формат <сообщение><контроль>)
-    // i_ - индекс контрольного бита при вставке контрольных бит в сообщение
-    // j и j_ - индексы информационных бит в тех же форматах
-    // Индексация ind начинается с 0, ind_ - с 1
-    // Соотношения: i_ = 2^i; j = j_ - round(log2(j_), up) - 1
+    Syndrome syndrome = GetSyndrome(msg, raw_msg_size);
+    bool parity_bit = syndrome.parity;
     for (size_t i = 0; i < code_bit_size; ++i) {
-        bool control_bit = 0;
-        size_t i_ = (1 << i);
-        for (
-             size_t j_ = i_ + 1, log_j_ = i + 1; 
-             j_ <= encoded_msg_bit_size; j_ += i_
-            ) {
-            
-            while (j_ <= encoded_msg_bit_size && (j_ & i_) == i_) {
-                while ((1 << log_j_) < j_) {
-                    ++log_j_;
-                }
-                size_t j = j_ - log_j_ - 1;
-                control_bit ^= BitOperator::GetBit(static_cast<uint8_t>(msg[j / 8]), j % 8);
-                ++j_;
-            }
-        }
-        if (control_bit) {
+        if ((syndrome.positions >> i) & 1) {
             BitOperator::SetBit(control_bytes[i / 8], i % 8);
+            parity_bit ^= true;
         }
-        parity_bit ^= control_bit;
     }
-    parity_bit ^= GetMsgParityBit(msg, raw_msg_size * 8);
     if (parity_bit) {
         BitOperator::SetBit(control_bytes[code_size - 1], code_bit_size % 8);
     }
-
-    return control_bytes;
 }
 
 
 Encoder::EncodingResult Encoder::EncodeAndWrite(
     std::istream& reader, std::ostream& writer, size_t raw_msg_size) {
     
+    EncoderContext context;
+
+    return EncodeAndWrite(reader, writer, raw_msg_size, context);
+}
+
+Encoder::EncodingResult Encoder::EncodeAndWrite(
+    std::istream& reader, std::ostream& writer, size_t raw_msg_size, EncoderContext& context) {
+    
     if (!reader.good()) {
         return EncodingResult::kReaderCorrupted;
     }
@@ -195,26 +236,19 @@ Encoder::EncodingResult Encoder::EncodeAndWrite(
         return EncodingResult::kSuccess;
     }
     
+    // Размер остатка потока не измеряется перемещением позиции: 
+    // поток может не поддерживать seekg (например, канал)
     EncodingResult exit_code = EncodingResult::kSuccess;
-    size_t start_pos = reader.tellg();
-    reader.seekg(0, std::ios::end);
-    size_t tail_size = static_cast<size_t>(reader.tellg()) - start_pos;
-    reader.seekg(start_pos, std::ios::beg);
-    if (tail_size < raw_msg_size) {
+    context.Reserve(raw_msg_size);
+    uint8_t* msg = context.GetBuffer();
+    reader.read(reinterpret_cast<char*>(msg), raw_msg_size);
+    size_t read_size = reader.gcount();
+    if (read_size < raw_msg_size) {
         exit_code = EncodingResult::kReaderEOFReached;
-        raw_msg_size = tail_size;
-        if (raw_msg_size == 0) {
-            return exit_code;
-        }
     }
-
-    uint8_t* control_bytes = GetCode(reader, raw_msg_size);
-    writer.write
-    (
-        reinterpret_cast<char*>(control_bytes), 
-        GetCodeBitSize(raw_msg_size * 8) / 8 + 1
-    );
-    delete [] control_bytes;
+    if (read_size != 0) {
+        EncodeAndWrite(msg, writer, read_size);
+    }
 
     return exit_code;
 }
@@ -225,13 +259,57 @@ Encoder::EncodingResult Encoder::EncodeAndWrite(
     if (raw_msg_size == 0) {
         return EncodingResult::kSuccess;
     }
-    uint8_t* control_bytes = GetCode(msg, raw_msg_size);
+    uint8_t control_bytes[kMaxCodeSize];
+    GetCode(msg, raw_msg_size, control_bytes);
     writer.write
     (
         reinterpret_cast<char*>(control_bytes), 
         GetCodeBitSize(raw_msg_size * 8) / 8 + 1
     );
-    delete [] control_bytes;
 
     return EncodingResult::kSuccess;
 }
+
+Encoder::EncodingResult Encoder::EncodeBlocks(std::istream& reader, std::ostream& writer, 
+    size_t data_size, size_t block_size) {
+
+    EncoderContext context;
+
+    return EncodeBlocks(reader, writer, data_size, block_size, context);
+}
+
+Encoder::EncodingResult Encoder::EncodeBlocks(std::istream& reader, std::ostream& writer, 
+    size_t data_size, size_t block_size, EncoderContext& context) {
+
+    if (data_size == 0) {
+        return EncodingResult::kSuccess;
+    }
+    if (!reader.good()) {
+        return EncodingResult::kReaderCorrupted;
+    }
+    block_size = std::min(block_size, data_size);
+    // Код блока записывается в буфер сразу за блоком, 
+    // поэтому <блок><код> выводится одной записью
+    context.Reserve(block_size);
+    uint8_t* buffer = context.GetBuffer();
+    EncodingResult exit_code = EncodingResult::kSuccess;
+    for (size_t i = 0; i < data_size; i += block_size) {
+        size_t cur_block_size = std::min(block_size, data_size - i);
+        reader.read(reinterpret_cast<char*>(buffer), cur_block_size);
+        size_t read_size = reader.gcount();
+        if (read_size < cur_block_size) {
+            exit_code = EncodingResult::kReaderEOFReached;
+        }
+        if (read_size == 0) {
+            break;
+        }
+        GetCode(buffer, read_size, buffer + read_size);
+        writer.write(reinterpret_cast<char*>(buffer), 
+            read_size + GetCodeBitSize(read_size * 8) / 8 + 1);
+        if (exit_code != EncodingResult::kSuccess) {
+            break;
+        }
+    }
+
+    return exit_code;
+}
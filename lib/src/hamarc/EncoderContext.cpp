@@ -0,0 +1,38 @@
+#include <new>
+
+#include "EncoderContext.hpp"
+#include "Encoder.hpp"
+
+const size_t EncoderContext::kAlignment = 64;
+
+EncoderContext::EncoderContext() : buffer_(nullptr), max_block_size_(0) {}
+
+EncoderContext::EncoderContext(size_t max_block_size) : EncoderContext() {
+    Reserve(max_block_size);
+}
+
+EncoderContext::~EncoderContext() {
+    if (buffer_ != nullptr) {
+        ::operator delete[](buffer_, std::align_val_t{kAlignment});
+    }
+}
+
+void EncoderContext::Reserve(size_t max_block_size) {
+    if (buffer_ != nullptr && max_block_size <= max_block_size_) {
+        return;
+    }
+    if (buffer_ != nullptr) {
+        ::operator delete[](buffer_, std::align_val_t{kAlignment});
+    }
+    size_t buffer_size = max_block_size + Encoder::GetCodeBitSize(max_block_size * 8) / 8 + 1;
+    buffer_ = static_cast<uint8_t*>(::operator new[](buffer_size, std::align_val_t{kAlignment}));
+    max_block_size_ = max_block_size;
+}
+
+uint8_t* EncoderContext::GetBuffer() {
+    return buffer_;
+}
+
+size_t EncoderContext::GetMaxBlockSize() const {
+    return max_block_size_;
+}
@@ -0,0 +1,181 @@
+#include <algorithm>
+#include <thread>
+
+#include "EncodingPipeline.hpp"
+
+// Пока один пакет читается, второй кодируется, а третий записывается
+const size_t EncodingPipeline::kBatchesCount = 3;
+
+EncodingPipeline::EncodingPipeline(size_t threads_count, size_t max_inflight_size)
+: threads_count(std::max(threads_count, static_cast<size_t>(1))),
+  max_inflight_size(max_inflight_size)
+{}
+
+Encoder::EncodingResult EncodingPipeline::Run(std::istream& reader, std::ostream& writer,
+    size_t data_size, size_t block_size) {
+
+    if (!reader.good()) {
+        return Encoder::EncodingResult::kReaderCorrupted;
+    }
+    if (data_size == 0) {
+        return Encoder::EncodingResult::kSuccess;
+    }
+
+    this->data_size = data_size;
+    this->block_size = block_size;
+    code_size = Encoder::GetCodeBitSize(block_size * 8) / 8 + 1;
+    blocks_total = (data_size + block_size - 1) / block_size;
+    batch_blocks = std::max(
+        max_inflight_size / kBatchesCount / (block_size + code_size), static_cast<size_t>(1));
+    batch_blocks = std::min(batch_blocks, blocks_total);
+    blocks_claimed = 0;
+    reader_eof_reached = false;
+
+    batches.resize(kBatchesCount);
+    for (size_t i = 0; i < kBatchesCount; ++i) {
+        batches[i] = Batch{BatchState::kFree, 0, 0, 0, 0, 0,
+            new uint8_t[batch_blocks * block_size], new uint8_t[batch_blocks * code_size]};
+    }
+
+    std::thread reader_thread(&EncodingPipeline::ReadBatches, this, std::ref(reader));
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < threads_count; ++i) {
+        workers.emplace_back(&EncodingPipeline::EncodeBlocks, this);
+    }
+    WriteBatches(writer);
+    reader_thread.join();
+    for (size_t i = 0; i < workers.size(); ++i) {
+        workers[i].join();
+    }
+
+    for (size_t i = 0; i < kBatchesCount; ++i) {
+        delete [] batches[i].data;
+        delete [] batches[i].codes;
+    }
+    batches.clear();
+
+    return reader_eof_reached
+        ? Encoder::EncodingResult::kReaderEOFReached
+        : Encoder::EncodingResult::kSuccess;
+}
+
+void EncodingPipeline::ReadBatches(std::istream& reader) {
+    size_t batches_total = (blocks_total + batch_blocks - 1) / batch_blocks;
+    for (size_t sequence = 0; sequence < batches_total; ++sequence) {
+        Batch& batch = batches[sequence % kBatchesCount];
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            state_changed.wait(lock, [&batch] { return batch.state == BatchState::kFree; });
+        }
+
+        size_t first_block = sequence * batch_blocks;
+        size_t blocks_count = std::min(batch_blocks, blocks_total - first_block);
+        size_t batch_size = std::min(blocks_count * block_size, data_size - first_block * block_size);
+        reader.read(reinterpret_cast<char*>(batch.data), batch_size);
+        size_t read_size = reader.gcount();
+        std::fill(batch.data + read_size, batch.data + batch_size, 0);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            reader_eof_reached = reader_eof_reached || read_size != batch_size;
+            batch.sequence = sequence;
+            batch.first_block = first_block;
+            batch.blocks_count = blocks_count;
+            batch.next_block = 0;
+            batch.encoded_blocks = 0;
+            batch.state = BatchState::kFilled;
+        }
+        state_changed.notify_all();
+    }
+}
+
+void EncodingPipeline::EncodeBlocks() {
+    while (true) {
+        Batch* batch;
+        size_t begin;
+        size_t end;
+        bool all_claimed;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            state_changed.wait(lock, [this] {
+                return blocks_claimed == blocks_total || FindClaimableBatch() != nullptr;
+            });
+            if (blocks_claimed == blocks_total) {
+                return;
+            }
+            // Блоки берутся порциями, чтобы реже обращаться к общему состоянию
+            batch = FindClaimableBatch();
+            size_t portion = std::max(batch_blocks / (threads_count * 4), static_cast<size_t>(1));
+            begin = batch->next_block;
+            end = std::min(begin + portion, batch->blocks_count);
+            batch->next_block = end;
+            blocks_claimed += end - begin;
+            all_claimed = blocks_claimed == blocks_total;
+        }
+        if (all_claimed) {
+            state_changed.notify_all();
+        }
+
+        for (size_t i = begin; i < end; ++i) {
+            Encoder::GetCode(batch->data + i * block_size, GetBlockSize(batch->first_block + i),
+                batch->codes + i * code_size);
+        }
+
+        bool encoded;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            batch->encoded_blocks += end - begin;
+            encoded = batch->encoded_blocks == batch->blocks_count;
+            if (encoded) {
+                batch->state = BatchState::kEncoded;
+            }
+        }
+        if (encoded) {
+            state_changed.notify_all();
+        }
+    }
+}
+
+void EncodingPipeline::WriteBatches(std::ostream& writer) {
+    size_t batches_total = (blocks_total + batch_blocks - 1) / batch_blocks;
+    for (size_t sequence = 0; sequence < batches_total; ++sequence) {
+        Batch& batch = batches[sequence % kBatchesCount];
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            state_changed.wait(lock, [&batch, sequence] {
+                return batch.state == BatchState::kEncoded && batch.sequence == sequence;
+            });
+        }
+
+        for (size_t i = 0; i < batch.blocks_count; ++i) {
+            size_t cur_block_size = GetBlockSize(batch.first_block + i);
+            writer.write(reinterpret_cast<char*>(batch.data + i * block_size), cur_block_size);
+            writer.write(reinterpret_cast<char*>(batch.codes + i * code_size),
+                Encoder::GetCodeBitSize(cur_block_size * 8) / 8 + 1);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            batch.state = BatchState::kFree;
+        }
+        state_changed.notify_all();
+    }
+}
+
+size_t EncodingPipeline::GetBlockSize(size_t block) const {
+    return std::min(block_size, data_size - block * block_size);
+}
+
+EncodingPipeline::Batch* EncodingPipeline::FindClaimableBatch() {
+    Batch* res = nullptr;
+    for (size_t i = 0; i < batches.size(); ++i) {
+        if (batches[i].state == BatchState::kFilled &&
+            batches[i].next_block < batches[i].blocks_count &&
+            (res == nullptr || batches[i].sequence < res->sequence)) {
+
+            res = &batches[i];
+        }
+    }
+
+    return res;
+}
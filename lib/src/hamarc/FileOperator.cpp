@@ -1,5 +1,9 @@
+#include <algorithm>
+
 #include "FileOperator.hpp"
 
+const size_t FileOperator::kCopyBufferSize = 1024 * 1024;
+
 FileOperator::FileOperator() : dir_(std::filesystem::current_path()) {}
 
 FileOperator::FileOperator(std::filesystem::path init_dir) 
@@ -8,60 +12,67 @@ FileOperator::FileOperator(std::filesystem::path init_dir)
 
 void FileOperator::SetDir(std::filesystem::path new_dir) {
     dir_ = std::filesystem::path{new_dir};
-    std::filesystem::create_directories(new_dir);
-}
-
-bool FileOperator::FileExists(std::filesystem::path filename) {
-    std::ifstream checker(dir_ / filename, std::ios::binary);
-    return checker.is_open();
 }
 
-size_t FileOperator::GetFileSize(std::filesystem::path filename) {
-    std::ifstream file(dir_ / filename, std::ios::binary);
-    file.seekg(0, std::ios::end);
-
-    return static_cast<size_t>(file.tellg());
+std::filesystem::path FileOperator::GetPath(std::filesystem::path filename) {
+    return (dir_ / filename).lexically_normal();
 }
 
-// Создаёт новый, либо очищает уже существующий файл
 bool FileOperator::CreateFile(std::filesystem::path filename) {
-    std::ofstream creator(dir_ / filename, std::ios::trunc);
-    return creator.is_open();
+    return OpenFile(filename, true, true, true) != nullptr;
 }
 
-bool FileOperator::CreateDir(std::filesystem::path name) {
-    return std::filesystem::create_directories(dir_ / name);
-}
+bool FileOperator::OpenForReading(std::filesystem::path file, 
+    FileStream& stream, std::ios::openmode openmode) {
 
-bool FileOperator::DeleteFile(std::filesystem::path filename) {
-    return std::filesystem::remove(dir_ / filename);
+    return Open(file, stream, openmode | std::ios::in);
 }
 
-size_t FileOperator::DeleteDir(std::filesystem::path name) {
-    return std::filesystem::remove_all(dir_ / name);
+bool FileOperator::OpenForWriting(std::filesystem::path file, 
+    FileStream& stream, std::ios::openmode openmode) {
+
+    return Open(file, stream, openmode | std::ios::out);
 }
 
-void FileOperator::RenameFile(std::filesystem::path old_name, 
-        std::filesystem::path new_name) {
-    
-    std::filesystem::rename(dir_ / old_name, dir_ / new_name);
+bool FileOperator::Open(std::filesystem::path file, 
+    FileStream& stream, std::ios::openmode openmode) {
+
+    // Режимы std::basic_filebuf::open: без in запись очищает файл, если не задан app
+    bool append = (openmode & std::ios::app) != 0;
+    bool writable = (openmode & std::ios::out) != 0 || append;
+    bool truncate = (openmode & std::ios::trunc) != 0 
+        || (writable && (openmode & std::ios::in) == 0 && !append);
+    bool create = writable && ((openmode & std::ios::in) == 0 || truncate || append);
+    stream.Open(OpenFile(file, writable, create, truncate), append);
+
+    return stream.IsOpen();
 }
 
-bool FileOperator::OpenForReading(std::filesystem::path file, 
-    std::ifstream& stream, std::ifstream::openmode openmode) {
-    stream.open(dir_ / file, openmode);
-    return stream.is_open();
+bool FileOperator::OpenMapped(std::filesystem::path, MappedFile&) {
+    return false;
 }
 
-bool FileOperator::OpenForWriting(std::filesystem::path file, 
-    std::ofstream& stream, std::ofstream::openmode openmode) {
-    stream.open(dir_ / file, openmode);
-    return stream.is_open();
+bool FileOperator::SyncDir(std::filesystem::path) {
+    return true;
 }
 
-bool FileOperator::Open(std::filesystem::path file, 
-    std::fstream& stream, std::fstream::openmode openmode) {
+bool FileOperator::CopyRange(std::filesystem::path src, size_t src_offset, 
+    std::filesystem::path dst, size_t dst_offset, size_t size) {
+
+    std::unique_ptr<RandomAccessFile> reader = OpenFile(src, false, false, false);
+    std::unique_ptr<RandomAccessFile> writer = OpenFile(dst, true, false, false);
+    if (reader == nullptr || writer == nullptr) {
+        return false;
+    }
+    uint8_t* buf = new uint8_t[std::min(size, kCopyBufferSize)];
+    bool copied = true;
+    for (size_t done = 0; done < size && copied;) {
+        size_t part = std::min(size - done, kCopyBufferSize);
+        copied = reader->ReadAt(src_offset + done, buf, part) == part 
+            && writer->WriteAt(dst_offset + done, buf, part);
+        done += part;
+    }
+    delete [] buf;
 
-    stream.open(dir_ / file, openmode);
-    return stream.is_open();
+    return copied && writer->Sync();
 }
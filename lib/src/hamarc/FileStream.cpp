@@ -0,0 +1,261 @@
+#include <algorithm>
+#include <cstring>
+
+#include "FileStream.hpp"
+
+const size_t FileStream::FileBuf::kBufferSize = 64 * 1024;
+
+FileStream::FileStream() : std::iostream(&buf_) {}
+
+void FileStream::Open(std::unique_ptr<RandomAccessFile> file, bool append) {
+    buf_.Open(std::move(file), append);
+    clear();
+}
+
+bool FileStream::IsOpen() const {
+    return buf_.IsOpen();
+}
+
+void FileStream::Close() {
+    if (!buf_.Close()) {
+        setstate(std::ios_base::failbit);
+    }
+}
+
+bool FileStream::SyncToDevice() {
+    if (!buf_.SyncToDevice()) {
+        setstate(std::ios_base::failbit);
+        return false;
+    }
+
+    return true;
+}
+
+FileStream::FileBuf::FileBuf() 
+    : data_(nullptr), buf_(new char[kBufferSize]), pos_(0), append_(false) {}
+
+FileStream::FileBuf::~FileBuf() {
+    Close();
+    delete [] buf_;
+}
+
+void FileStream::FileBuf::Open(std::unique_ptr<RandomAccessFile> file, bool append) {
+    Close();
+    file_ = std::move(file);
+    data_ = file_ != nullptr ? file_->GetData() : nullptr;
+    append_ = append;
+    Reset(0);
+}
+
+bool FileStream::FileBuf::IsOpen() const {
+    return file_ != nullptr;
+}
+
+bool FileStream::FileBuf::Close() {
+    if (file_ == nullptr) {
+        return true;
+    }
+    bool flushed = FlushWrites() && file_->Sync();
+    file_.reset();
+    data_ = nullptr;
+    Reset(0);
+
+    return flushed;
+}
+
+bool FileStream::FileBuf::SyncToDevice() {
+    return file_ != nullptr && FlushWrites() && file_->SyncToDevice();
+}
+
+size_t FileStream::FileBuf::GetPosition() const {
+    if (pbase() != nullptr) {
+        return pos_ + (pptr() - pbase());
+    }
+
+    return pos_ + (gptr() - eback());
+}
+
+void FileStream::FileBuf::Reset(size_t pos) {
+    setg(nullptr, nullptr, nullptr);
+    setp(nullptr, nullptr);
+    pos_ = pos;
+}
+
+void FileStream::FileBuf::StartWriting() {
+    Reset(append_ ? file_->GetSize() : GetPosition());
+    setp(buf_, buf_ + kBufferSize);
+}
+
+bool FileStream::FileBuf::StopWriting() {
+    if (pbase() == nullptr) {
+        return true;
+    }
+    size_t pos = GetPosition();
+    bool flushed = FlushWrites();
+    Reset(pos);
+
+    return flushed;
+}
+
+bool FileStream::FileBuf::FlushWrites() {
+    if (pbase() == nullptr || pptr() == pbase()) {
+        return true;
+    }
+    size_t size = pptr() - pbase();
+    bool written = file_->WriteAt(pos_, reinterpret_cast<const uint8_t*>(pbase()), size);
+    pos_ += size;
+    setp(buf_, buf_ + kBufferSize);
+
+    return written;
+}
+
+FileStream::FileBuf::int_type FileStream::FileBuf::underflow() {
+    if (file_ == nullptr || !StopWriting()) {
+        return traits_type::eof();
+    }
+    if (gptr() < egptr()) {
+        return traits_type::to_int_type(*gptr());
+    }
+    size_t pos = GetPosition();
+    if (data_ != nullptr) {
+        // Поток только читает отображённый файл, поэтому снятие const безопасно
+        char* begin = reinterpret_cast<char*>(const_cast<uint8_t*>(data_));
+        size_t size = file_->GetSize();
+        if (pos >= size) {
+            return traits_type::eof();
+        }
+        pos_ = 0;
+        setg(begin, begin + pos, begin + size);
+        return traits_type::to_int_type(*gptr());
+    }
+    Reset(pos);
+    size_t read = file_->ReadAt(pos, reinterpret_cast<uint8_t*>(buf_), kBufferSize);
+    if (read == 0) {
+        return traits_type::eof();
+    }
+    setg(buf_, buf_, buf_ + read);
+
+    return traits_type::to_int_type(*gptr());
+}
+
+std::streamsize FileStream::FileBuf::xsgetn(char* s, std::streamsize count) {
+    if (file_ == nullptr || !StopWriting()) {
+        return 0;
+    }
+    size_t size = static_cast<size_t>(count);
+    size_t done = 0;
+    while (done < size) {
+        if (gptr() == egptr()) {
+            if (data_ == nullptr && size - done >= kBufferSize) {
+                size_t pos = GetPosition();
+                Reset(pos);
+                size_t read = file_->ReadAt(pos, reinterpret_cast<uint8_t*>(s + done), size - done);
+                pos_ += read;
+                done += read;
+                break;
+            }
+            if (traits_type::eq_int_type(underflow(), traits_type::eof())) {
+                break;
+            }
+        }
+        size_t part = std::min(static_cast<size_t>(egptr() - gptr()), size - done);
+        std::memcpy(s + done, gptr(), part);
+        setg(eback(), gptr() + part, egptr());
+        done += part;
+    }
+
+    return static_cast<std::streamsize>(done);
+}
+
+FileStream::FileBuf::int_type FileStream::FileBuf::overflow(int_type ch) {
+    if (file_ == nullptr) {
+        return traits_type::eof();
+    }
+    if (pbase() == nullptr) {
+        StartWriting();
+    } else if (!FlushWrites()) {
+        return traits_type::eof();
+    }
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+
+    return traits_type::not_eof(ch);
+}
+
+std::streamsize FileStream::FileBuf::xsputn(const char* s, std::streamsize count) {
+    if (file_ == nullptr) {
+        return 0;
+    }
+    if (pbase() == nullptr) {
+        StartWriting();
+    }
+    size_t size = static_cast<size_t>(count);
+    if (size > static_cast<size_t>(epptr() - pptr())) {
+        if (!FlushWrites()) {
+            return 0;
+        }
+        if (size >= kBufferSize) {
+            if (!file_->WriteAt(pos_, reinterpret_cast<const uint8_t*>(s), size)) {
+                return 0;
+            }
+            pos_ += size;
+            return count;
+        }
+    }
+    std::memcpy(pptr(), s, size);
+    pbump(static_cast<int>(size));
+
+    return count;
+}
+
+FileStream::FileBuf::pos_type FileStream::FileBuf::seekoff(
+    off_type off, std::ios_base::seekdir dir, std::ios_base::openmode) {
+
+    if (file_ == nullptr) {
+        return pos_type(off_type(-1));
+    }
+    size_t cur = GetPosition();
+    if (dir == std::ios_base::cur && off == 0) {
+        return pos_type(static_cast<off_type>(cur));
+    }
+    if (!StopWriting()) {
+        return pos_type(off_type(-1));
+    }
+    off_type base = 0;
+    if (dir == std::ios_base::cur) {
+        base = static_cast<off_type>(cur);
+    } else if (dir == std::ios_base::end) {
+        base = static_cast<off_type>(file_->GetSize());
+    }
+    off_type pos = base + off;
+    if (pos < 0) {
+        return pos_type(off_type(-1));
+    }
+    // Позиция в пределах прочитанной области сохраняет её
+    size_t new_pos = static_cast<size_t>(pos);
+    if (eback() != nullptr && new_pos >= pos_ 
+        && new_pos <= pos_ + static_cast<size_t>(egptr() - eback())) {
+
+        setg(eback(), eback() + (new_pos - pos_), egptr());
+        return pos_type(pos);
+    }
+    Reset(new_pos);
+
+    return pos_type(pos);
+}
+
+FileStream::FileBuf::pos_type FileStream::FileBuf::seekpos(
+    pos_type pos, std::ios_base::openmode which) {
+
+    return seekoff(off_type(pos), std::ios_base::beg, which);
+}
+
+int FileStream::FileBuf::sync() {
+    if (file_ == nullptr) {
+        return 0;
+    }
+
+    return FlushWrites() && file_->Sync() ? 0 : -1;
+}
@@ -1,18 +1,87 @@
+#include <algorithm>
+#include <chrono>
+#include <memory>
 #include <unordered_map>
+#include <cstring>
+#include <thread>
 
 #include "HamArchiver.hpp"
-#include "Copydata.hpp"
+#include "EncodingPipeline.hpp"
+#include "WorkStealingQueue.hpp"
+#include "IoPriority.hpp"
 
 const size_t HamArchiver::kNumericMetadataSize = 4 + 8 + 8;
+const size_t HamArchiver::kIndexRecordHeaderSize = 8 + 8 + 8 + 4;
+const size_t HamArchiver::kIndexNameSizeOffset = 8 + 8 + 8;
+const size_t HamArchiver::kNameSizeFieldSize = 4;
+const size_t HamArchiver::kIndexBlockSize = 4096;
+const size_t HamArchiver::kIndexTrailerSize = 8 + 8 + 8;
+const uint8_t HamArchiver::kIndexMagic[8] = {'H', 'A', 'F', 'I', 'N', 'D', 'E', 'X'};
 
-HamArchiver::HamArchiver() : file_operator() {}
+const size_t HamArchiver::kDefaultMaxInflightSize = 64 * 1024 * 1024;
+const size_t HamArchiver::kExtractionChunkSize = 1024 * 1024;
+const size_t HamArchiver::kDeletedFlag = static_cast<size_t>(1) << 31;
+const size_t HamArchiver::kStreamedFlag = static_cast<size_t>(1) << 30;
+const size_t HamArchiver::kStreamChunkSize = 1024 * 1024;
+const size_t HamArchiver::kChunkHeaderSize = 8;
+const size_t HamArchiver::kVacuumBufferSize = 4 * 1024 * 1024;
+const size_t HamArchiver::kScrubWriteGap = 4096;
+const size_t HamArchiver::kScrubCheckpointInterval = 64 * 1024 * 1024;
+
+HamArchiver::HamArchiver() 
+: HamArchiver(DiskFileOperator::CreateDefault(std::filesystem::current_path())) 
+{}
 
 HamArchiver::HamArchiver(std::filesystem::path working_dir) 
-: file_operator(working_dir)
+: HamArchiver(DiskFileOperator::CreateDefault(working_dir)) 
+{}
+
+HamArchiver::HamArchiver(std::shared_ptr<FileOperator> storage) 
+: file_operator(storage), write_index(true), threads_count(1), 
+  max_inflight_size(kDefaultMaxInflightSize)
  {}
 
 void HamArchiver::SetDir(std::filesystem::path new_dir) {
-    file_operator.SetDir(new_dir);
+    file_operator->SetDir(new_dir);
+}
+
+void HamArchiver::SetStorage(std::shared_ptr<FileOperator> storage) {
+    file_operator = storage;
+}
+
+void HamArchiver::SetWriteIndex(bool enabled) {
+    write_index = enabled;
+}
+
+void HamArchiver::SetThreads(size_t count) {
+    if (count == 0) {
+        count = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    threads_count = count;
+}
+
+void HamArchiver::SetMaxInflightMemory(size_t size) {
+    max_inflight_size = size;
+}
+
+void HamArchiver::SetMetricsEnabled(bool enabled) {
+    metrics.SetEnabled(enabled);
+}
+
+Metrics& HamArchiver::GetMetrics() {
+    return metrics;
+}
+
+void HamArchiver::SetBlockCacheSize(size_t size) {
+    block_cache.SetCapacity(size);
+}
+
+const BlockCache& HamArchiver::GetBlockCache() const {
+    return block_cache;
+}
+
+bool HamArchiver::SetKernel(HammingKernel::Type type) {
+    return HammingKernel::Select(type);
 }
 
 size_t HamArchiver::GetMsgCodeSize(size_t raw_msg_size) {
@@ -23,6 +92,10 @@ size_t HamArchiver::GetMsgCodeSize(size_t raw_msg_size) {
 }
 
 size_t HamArchiver::GetEncodedMsgSize(size_t raw_msg_size, size_t encoding_block_size) {
+    // Пустой файл хранится с нулевым размером блока
+    if (encoding_block_size == 0) {
+        return raw_msg_size;
+    }
     return raw_msg_size 
     + (raw_msg_size / encoding_block_size) 
     * GetMsgCodeSize(encoding_block_size) 
@@ -37,7 +110,7 @@ std::vector<HamArchiver::CreationResult> HamArchiver::Create(std::string_view ar
     const std::vector<FileMetadata>& files) {
 
     std::vector<CreationResult> creation_result;
-    if (file_operator.FileExists(arcname)) {
+    if (file_operator->FileExists(arcname)) {
         creation_result.push_back(CreationResult::kArcAlreadyExists);
         return creation_result;
     }
@@ -45,47 +118,83 @@ std::vector<HamArchiver::CreationResult> HamArchiver::Create(std::string_view ar
         creation_result.push_back(CreationResult::kEmptyFileList);
         return creation_result;
     }
-    file_operator.CreateFile(arcname);
+    file_operator->CreateFile(arcname);
     auto addition_result = AppendFiles(arcname, files);
     
     creation_result.resize(addition_result.size());
     for (size_t i = 0; i < addition_result.size(); ++i) {
-        switch (addition_result[i]) {
-            case AdditionResult::kSuccess:
-                creation_result[i] = CreationResult::kSuccess;
-                break;
-            case AdditionResult::kFileNotFound:
-                creation_result[i] = CreationResult::kFileNotFound;
-                break;
-            case AdditionResult::kFileNotAccessible:
-                creation_result[i] = CreationResult::kFileNotAccessible;
-        }
+        creation_result[i] = ToCreationResult(addition_result[i]);
+    }
+
+    return creation_result;
+}
+
+std::vector<HamArchiver::CreationResult> HamArchiver::Create(std::ostream& writer, 
+    const std::vector<FileMetadata>& files) {
+
+    Metrics::PhaseTimer timer(metrics, Metrics::Phase::kEncoding);
+    if (files.empty()) {
+        return {CreationResult::kEmptyFileList};
+    }
+
+    std::vector<IndexEntry> entries;
+    size_t offset = 0;
+    auto addition_result = WriteEntries(files, writer, entries, offset);
+    if (write_index) {
+        WriteIndex(entries, writer, offset);
+    }
+    writer.flush();
+    if (!writer.good()) {
+        return {CreationResult::kWriteError};
+    }
+
+    std::vector<CreationResult> creation_result(addition_result.size());
+    for (size_t i = 0; i < addition_result.size(); ++i) {
+        creation_result[i] = ToCreationResult(addition_result[i]);
     }
 
     return creation_result;
 }
 
+HamArchiver::CreationResult HamArchiver::ToCreationResult(AdditionResult result) {
+    switch (result) {
+        case AdditionResult::kSuccess:
+            return CreationResult::kSuccess;
+        case AdditionResult::kFileNotFound:
+            return CreationResult::kFileNotFound;
+        case AdditionResult::kWriteError:
+            return CreationResult::kWriteError;
+        default:
+            return CreationResult::kFileNotAccessible;
+    }
+}
+
 std::vector<HamArchiver::FileMetadata> HamArchiver::GetFileList(std::filesystem::path arcfile) {
-    if (!file_operator.FileExists(arcfile)) {
+    if (!file_operator->FileExists(arcfile)) {
         return std::vector<FileMetadata>{};
     }
     
-    size_t arc_size = file_operator.GetFileSize(arcfile);
-    std::fstream stream;
-    file_operator.Open(arcfile, stream, std::fstream::in | std::fstream::out | std::fstream::binary);
+    MappedFile mapping;
+    MemoryStream memory_reader;
+    FileStream file_reader;
+    std::istream& stream = OpenArchive(arcfile, mapping, memory_reader, file_reader);
+    size_t entries_end;
+    bool complete;
+    std::vector<IndexEntry> entries = LoadEntries(
+        stream, file_operator->GetFileSize(arcfile), entries_end, complete);
+
     std::vector<FileMetadata> files;
-    while (stream.tellg() != arc_size) {
-        files.push_back(GetMetadata(stream));
-        if (files.back().size == -1) {
-            break;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (!entries[i].deleted) {
+            files.push_back(entries[i].metadata);
         }
-        stream.seekg(
-            GetEncodedMsgSize(
-                files.back().size, 
-                files.back().encoding_block_size
-            ), 
-            std::fstream::cur
-        );
+    }
+    if (!complete) {
+        files.push_back(FileMetadata{
+            std::filesystem::path{}, 
+            static_cast<size_t>(-1), 
+            static_cast<size_t>(-1)
+        });
     }
 
     return files;
@@ -93,296 +202,2141 @@ std::vector<HamArchiver::FileMetadata> HamArchiver::GetFileList(std::filesystem:
 
 std::vector<HamArchiver::ExtractionResult> HamArchiver::ExtractFiles(std::filesystem::path arcfile) {
 
-    if (!file_operator.FileExists(arcfile)) {
+    if (!file_operator->FileExists(arcfile)) {
         return {ExtractionResult::kArcNotFound};
     }
     std::vector<FileMetadata> file_list = GetFileList(arcfile);
-    std::vector<std::string> filenames(file_list.size());
+    std::vector<std::string> filenames;
     for (size_t i = 0; i < file_list.size(); ++i) {
         if (file_list[i].size == -1) {
             break;
         } 
-        filenames[i] = file_list[i].path.string();
+        filenames.push_back(file_list[i].path.string());
     }
-    return RebuildArc(arcfile, filenames, true);    
+    return ExtractFiles(arcfile, filenames);
 }
 
 std::vector<HamArchiver::ExtractionResult> HamArchiver::ExtractFiles(std::filesystem::path arcfile, 
         const std::vector<std::string>& filenames) {
 
-    return RebuildArc(arcfile, filenames, true);    
-}
+    Metrics::PhaseTimer timer(metrics, Metrics::Phase::kExtraction);
 
-std::vector<HamArchiver::ExtractionResult> HamArchiver::DeleteFiles(std::filesystem::path arcfile, 
-        const std::vector<std::string>& filenames) {
+    if (!file_operator->FileExists(arcfile)) {
+        return {ExtractionResult::kArcNotFound};
+    }
+    if (filenames.empty()) {
+        return {ExtractionResult::kEmptyFileList};
+    }
 
-    return RebuildArc(arcfile, filenames, false);
-}
+    std::unordered_map<std::string_view, ExtractionResult> file_states;
+    for (size_t i = 0; i < filenames.size(); ++i) {
+        file_states[filenames[i]] = ExtractionResult::kFileNotFound;
+    }
 
+    MappedFile mapping;
+    MemoryStream memory_reader;
+    FileStream file_reader;
+    std::istream& stream = OpenArchive(arcfile, mapping, memory_reader, file_reader);
+    size_t entries_end;
+    bool complete;
+    std::vector<IndexEntry> entries = LoadEntries(
+        stream, file_operator->GetFileSize(arcfile), entries_end, complete);
+    uint64_t archive_id = GetCacheId(arcfile);
+    if (threads_count > 1) {
+        // Из файлов с одинаковыми названиями извлекается последний
+        std::unordered_map<std::string, size_t> last_entries;
+        for (size_t i = 0; i < entries.size(); ++i) {
+            std::string cur_filename = entries[i].metadata.path.filename().string();
+            if (!entries[i].deleted && !cur_filename.empty() 
+                && file_states.find(cur_filename) != file_states.end()) {
 
-std::vector<HamArchiver::AdditionResult> HamArchiver::AppendFiles(std::filesystem::path arcfile, 
-        const std::vector<FileMetadata>& files) {
+                last_entries[cur_filename] = i;
+            }
+        }
+        // Потоковые файлы делятся на порции с заголовками, поэтому извлекаются последовательно
+        std::vector<IndexEntry> selected;
+        std::vector<IndexEntry> streamed;
+        for (size_t i = 0; i < entries.size(); ++i) {
+            auto it = last_entries.find(entries[i].metadata.path.filename().string());
+            if (it != last_entries.end() && it->second == i) {
+                (entries[i].streamed ? streamed : selected).push_back(entries[i]);
+            }
+        }
+        std::vector<ExtractionResult> selected_states = ExtractEntries(arcfile, selected, mapping, archive_id);
+        for (size_t i = 0; i < selected.size(); ++i) {
+            file_states[selected[i].metadata.path.filename().string()] = selected_states[i];
+        }
+        for (size_t i = 0; i < streamed.size(); ++i) {
+            stream.clear();
+            metrics.Add(Metrics::Counter::kSeeks, 1);
+            stream.seekg(streamed[i].content_offset, std::istream::beg);
+            file_states[streamed[i].metadata.path.filename().string()] = 
+                ExtractFile(streamed[i], stream, false, archive_id);
+        }
+    } else {
+        mapping.Advise(0, mapping.GetSize(), MappedFile::AccessPattern::kSequential);
+        for (size_t i = 0; i < entries.size(); ++i) {
+            std::string cur_filename = entries[i].metadata.path.filename().string();
+            if (!entries[i].deleted && !cur_filename.empty() 
+                && file_states.find(cur_filename) != file_states.end()) {
 
-    std::vector<AdditionResult> addition_result;
-    if (!file_operator.FileExists(arcfile)) {
-        addition_result.push_back(AdditionResult::kArcNotFound);
-        return addition_result;
+                stream.clear();
+                metrics.Add(Metrics::Counter::kSeeks, 1);
+                stream.seekg(entries[i].content_offset, std::ifstream::beg);
+                file_states[cur_filename] = ExtractFile(entries[i], stream, false, archive_id);
+            }
+        }
     }
-    if (files.empty()) {
-        addition_result.push_back(AdditionResult::kEmptyFileList);
-        return addition_result;
+    bool arc_corrupted = !complete;
+
+    std::vector<ExtractionResult> res(filenames.size());
+    for (size_t i = 0; i < filenames.size(); ++i) {
+        res[i] = file_states[filenames[i]];
     }
-    
-    std::ofstream writer;
-    file_operator.OpenForWriting(arcfile, writer, std::ofstream::app | std::ofstream::binary);
-    addition_result.resize(files.size());
-    for (size_t i = 0; i < files.size(); ++i) {
-        addition_result[i] = WriteEncodedFile(files[i], writer);
+    if (arc_corrupted) {
+        res.push_back(ExtractionResult::kArcCorrupted);
     }
 
-    return addition_result;
+    return res;
 }
 
-std::vector<HamArchiver::ConcatenationResult> HamArchiver::Merge(std::string_view arcname,
-        const std::vector<std::string>& arcfiles) {
-    
-    if (arcfiles.empty()) {
-        return {ConcatenationResult::kEmptyFileList};
+HamArchiver::ExtractionResult HamArchiver::ExtractTo(std::filesystem::path arcfile, 
+    const std::string& filename, std::ostream& writer) {
+
+    return ExtractTo(arcfile, filename, [&writer](const uint8_t* data, size_t size) {
+        writer.write(reinterpret_cast<const char*>(data), size);
+        return writer.good();
+    });
+}
+
+HamArchiver::ExtractionResult HamArchiver::ExtractTo(std::filesystem::path arcfile, 
+    const std::string& filename, const ByteSink& sink) {
+
+    return ExtractTo(arcfile, std::vector<std::string>{filename}, sink)[0];
+}
+
+std::vector<HamArchiver::ExtractionResult> HamArchiver::ExtractTo(std::filesystem::path arcfile, 
+    const std::vector<std::string>& filenames, std::ostream& writer) {
+
+    return ExtractTo(arcfile, filenames, [&writer](const uint8_t* data, size_t size) {
+        writer.write(reinterpret_cast<const char*>(data), size);
+        return writer.good();
+    });
+}
+
+std::vector<HamArchiver::ExtractionResult> HamArchiver::ExtractTo(std::filesystem::path arcfile, 
+    const std::vector<std::string>& filenames, const ByteSink& sink) {
+
+    Metrics::PhaseTimer timer(metrics, Metrics::Phase::kExtraction);
+    if (!file_operator->FileExists(arcfile)) {
+        return {ExtractionResult::kArcNotFound};
     }
-    if (file_operator.FileExists(arcname)) {
-        return {ConcatenationResult::kArcAlreadyExists};
+    if (filenames.empty()) {
+        return {ExtractionResult::kEmptyFileList};
     }
-    file_operator.CreateFile(arcname);
-    std::ofstream writer;
-    file_operator.OpenForWriting(arcname, writer, std::ofstream::app | std::ofstream::binary);
-    std::vector<ConcatenationResult> res(arcfiles.size(), ConcatenationResult::kFileNotFound);
-    for (size_t i = 0; i < arcfiles.size(); ++i) {
-        if (!file_operator.FileExists(arcfiles[i])) {
+    MappedFile mapping;
+    MemoryStream memory_reader;
+    FileStream file_reader;
+    std::istream& stream = OpenArchive(arcfile, mapping, memory_reader, file_reader);
+    size_t entries_end;
+    bool complete;
+    std::vector<IndexEntry> entries = LoadEntries(
+        stream, file_operator->GetFileSize(arcfile), entries_end, complete);
+    uint64_t archive_id = GetCacheId(arcfile);
+
+    std::vector<ExtractionResult> res;
+    for (size_t i = 0; i < filenames.size(); ++i) {
+        const IndexEntry* entry = FindLastEntry(entries, filenames[i]);
+        if (entry == nullptr) {
+            res.push_back(complete ? ExtractionResult::kFileNotFound : ExtractionResult::kArcCorrupted);
             continue;
         }
-        std::ifstream reader;
-        file_operator.OpenForReading(arcfiles[i], reader, std::ifstream::binary);
-        Copydata::CopyData(reader, writer, file_operator.GetFileSize(arcfiles[i]));
-        res[i] = ConcatenationResult::kSuccess;
+        mapping.Advise(entry->content_offset, GetEncodedContentSize(*entry), 
+            MappedFile::AccessPattern::kSequential);
+        stream.clear();
+        metrics.Add(Metrics::Counter::kSeeks, 1);
+        stream.seekg(entry->content_offset, std::istream::beg);
+        res.push_back(DecodeEntry(*entry, stream, false, sink, archive_id));
+        // Вывод оборван на повреждённом блоке: следующие файлы не отделить от него
+        if (res.back() == ExtractionResult::kFileCorrupted) {
+            break;
+        }
     }
 
     return res;
 }
 
+HamArchiver::ExtractionResult HamArchiver::ReadRange(std::filesystem::path arcfile, 
+    const std::string& filename, size_t offset, size_t length, uint8_t* buffer, size_t& read_size) {
+
+    read_size = 0;
+    return ReadRange(arcfile, filename, offset, length, 
+        [buffer, &read_size](const uint8_t* data, size_t size) {
+            std::memcpy(buffer + read_size, data, size);
+            read_size += size;
+            return true;
+        });
+}
 
-std::vector<HamArchiver::ExtractionResult> HamArchiver::RebuildArc(std::filesystem::path arcfile,
-    const std::vector<std::string>& skip_list, bool extract) {
+HamArchiver::ExtractionResult HamArchiver::ReadRange(std::filesystem::path arcfile, 
+    const std::string& filename, size_t offset, size_t length, const ByteSink& sink) {
 
-    if (!file_operator.FileExists(arcfile)) {
-        return {ExtractionResult::kArcNotFound};
+    Metrics::PhaseTimer timer(metrics, Metrics::Phase::kExtraction);
+    if (!file_operator->FileExists(arcfile)) {
+        return ExtractionResult::kArcNotFound;
     }
-    if (skip_list.empty()) {
-        return {ExtractionResult::kEmptyFileList};
+    MappedFile mapping;
+    MemoryStream memory_reader;
+    FileStream file_reader;
+    std::istream& stream = OpenArchive(arcfile, mapping, memory_reader, file_reader);
+    size_t entries_end;
+    bool complete;
+    std::vector<IndexEntry> entries = LoadEntries(
+        stream, file_operator->GetFileSize(arcfile), entries_end, complete);
+    const IndexEntry* entry = FindLastEntry(entries, filename);
+    if (entry == nullptr) {
+        return complete ? ExtractionResult::kFileNotFound : ExtractionResult::kArcCorrupted;
+    }
+    if (offset >= entry->metadata.size) {
+        return ExtractionResult::kSuccess;
     }
+    size_t end = offset + std::min(length, entry->metadata.size - offset);
+    mapping.Advise(entry->content_offset, GetEncodedContentSize(*entry), 
+        MappedFile::AccessPattern::kRandom);
+    decoder_context.Reserve(entry->metadata.encoding_block_size);
+    uint64_t archive_id = GetCacheId(arcfile);
 
-    std::unordered_map<std::string_view, ExtractionResult> file_states;
-    for (size_t i = 0; i < skip_list.size(); ++i) {
-        file_states[skip_list[i]] = ExtractionResult::kFileNotFound;
-    }
-
-    std::fstream stream;
-    file_operator.Open(arcfile, stream, std::fstream::in | std::fstream::out | std::fstream::binary);
-    std::filesystem::path tmp{"__arctmp__.haf"};
-    std::ofstream writer;
-    file_operator.OpenForWriting(tmp, writer, std::ofstream::trunc | std::ofstream::binary);
-
-    size_t arcfile_size = file_operator.GetFileSize(arcfile);
-    bool arc_corrupted = false;
-    while (stream.tellg() < arcfile_size) {
-        std::streampos metadata_beg = stream.tellg();
-        FileMetadata cur_metadata = GetMetadata(stream);
-        if (cur_metadata.size == -1) {
-            arc_corrupted = true;
-            break;
+    // Проверяются только блоки, покрывающие диапазон; смежные блоки читаются без перемещения
+    size_t stream_pos = 0;  // в начале архива блоков содержимого нет
+    for (size_t pos = offset; pos < end;) {
+        size_t encoded_offset;
+        size_t block_begin;
+        size_t block_size;
+        LocateBlock(*entry, pos, encoded_offset, block_begin, block_size);
+        const uint8_t* block = GetCachedBlock(archive_id, encoded_offset, block_size, 
+            decoder_context.GetFixBuffer());
+        if (block == nullptr) {
+            if (encoded_offset != stream_pos) {
+                stream.clear();
+                metrics.Add(Metrics::Counter::kSeeks, 1);
+                stream.seekg(encoded_offset, std::istream::beg);
+            }
+            const uint8_t* encoded = ReadBytes(stream, GetEncodedMsgSize(block_size), 
+                decoder_context.GetEncodedBuffer());
+            if (encoded == nullptr) {
+                return ExtractionResult::kFileCorrupted;
+            }
+            stream_pos = encoded_offset + GetEncodedMsgSize(block_size);
+            Decoder::ValidationResult block_state;
+            block = DecodeBlock(encoded, block_size, decoder_context.GetFixBuffer(), block_state);
+            if (block_state == Decoder::ValidationResult::kDoubleError) {
+                return ExtractionResult::kFileCorrupted;
+            }
+            CacheBlock(archive_id, encoded_offset, block, block_size, block_state);
         }
-        
-        std::string cur_filename = cur_metadata.path.filename().string();
-        if (!cur_filename.empty() && file_states.find(cur_filename) != file_states.end()) {
-            if (extract) {
-                file_states[cur_filename] = ExtractFile(cur_metadata, stream, false);
-                continue;
-            } 
-            file_states[cur_filename] = ExtractionResult::kSuccess;
-            stream.seekg(
-                GetEncodedMsgSize(
-                    cur_metadata.size, 
-                    cur_metadata.encoding_block_size
-                ), std::fstream::cur);
-            continue;
+        size_t copy_size = std::min(end, block_begin + block_size) - pos;
+        if (!sink(block + (pos - block_begin), copy_size)) {
+            return ExtractionResult::kFileCorrupted;
         }
+        pos += copy_size;
+    }
+
+    return ExtractionResult::kSuccess;
+}
 
-        // Возврат на первый байт метаданных
-        stream.seekg(metadata_beg, std::fstream::beg);
+const HamArchiver::IndexEntry* HamArchiver::FindLastEntry(const std::vector<IndexEntry>& entries, 
+    const std::string& filename) {
 
-        Copydata::CopyData(stream, writer, 
-            GetEncodedMsgSize(kNumericMetadataSize) 
-            + GetEncodedMsgSize(cur_filename.size())
-            + GetEncodedMsgSize(
-                cur_metadata.size, cur_metadata.encoding_block_size
-            )
-        );
+    // Из файлов с одинаковыми названиями берётся последний, как и при извлечении в директорию
+    for (size_t i = entries.size(); i > 0; --i) {
+        const IndexEntry& entry = entries[i - 1];
+        if (!entry.deleted && entry.metadata.path.filename().string() == filename) {
+            return &entry;
+        }
     }
-    stream.close();
-    writer.close();
 
-    file_operator.DeleteFile(arcfile);
-    file_operator.RenameFile(tmp, arcfile);
+    return nullptr;
+}
+
+void HamArchiver::LocateBlock(const IndexEntry& entry, size_t pos, size_t& encoded_offset, 
+    size_t& block_begin, size_t& block_size) {
 
-    if (file_operator.GetFileSize(arcfile) == 0) {
-        file_operator.DeleteFile(arcfile);
+    size_t encoding_block_size = entry.metadata.encoding_block_size;
+    size_t content_begin = 0;
+    size_t content_size = entry.metadata.size;
+    encoded_offset = entry.content_offset;
+    if (entry.streamed) {
+        // Блоки отсчитываются от начала порции, содержащей pos
+        size_t chunk_size = GetStreamChunkSize(encoding_block_size);
+        size_t chunk_index = pos / chunk_size;
+        size_t encoded_header_size = GetEncodedMsgSize(kChunkHeaderSize);
+        content_begin = chunk_index * chunk_size;
+        content_size = std::min(chunk_size, entry.metadata.size - content_begin);
+        encoded_offset += chunk_index * (encoded_header_size 
+            + GetEncodedMsgSize(chunk_size, encoding_block_size)) + encoded_header_size;
     }
+    size_t block_index = (pos - content_begin) / encoding_block_size;
+    block_begin = content_begin + block_index * encoding_block_size;
+    block_size = std::min(encoding_block_size, content_begin + content_size - block_begin);
+    encoded_offset += GetEncodedMsgSize(block_index * encoding_block_size, encoding_block_size);
+}
+
+HamArchiver::VerificationResult HamArchiver::Verify(std::filesystem::path arcfile, 
+    VerificationReport& report) {
 
-    std::vector<ExtractionResult> res(skip_list.size());
-    for (size_t i = 0; i < skip_list.size(); ++i) {
-        res[i] = file_states[skip_list[i]];
+    Metrics::PhaseTimer timer(metrics, Metrics::Phase::kVerification);
+    report = VerificationReport{};
+    if (!file_operator->FileExists(arcfile)) {
+        return VerificationResult::kArcNotFound;
     }
-    if (arc_corrupted) {
-        res.push_back(ExtractionResult::kArcCorrupted);
+    MappedFile mapping;
+    MemoryStream memory_reader;
+    FileStream file_reader;
+    std::istream& stream = OpenArchive(arcfile, mapping, memory_reader, file_reader);
+    size_t arc_size = file_operator->GetFileSize(arcfile);
+    size_t entries_end;
+    bool complete;
+    std::vector<IndexEntry> entries = LoadEntries(stream, arc_size, entries_end, complete);
+    VerifyIndex(stream, arc_size, report.index);
+
+    // Метаданные проверяются последовательно, содержимое - участками в несколько потоков
+    std::vector<IndexEntry> live_entries;
+    std::vector<VerificationTask> tasks;
+    size_t max_task_size = 0;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (entries[i].deleted) {
+            continue;
+        }
+        const FileMetadata& metadata = entries[i].metadata;
+        report.entries.push_back(EntryVerification{metadata, BlockCounts{}});
+        VerifyEntryMetadata(stream, entries[i], report.entries.back().blocks);
+        live_entries.push_back(entries[i]);
+        if (metadata.size == 0) {
+            continue;
+        }
+        size_t block_size = metadata.encoding_block_size;
+        size_t task_size = block_size * std::max(kExtractionChunkSize / block_size, static_cast<size_t>(1));
+        size_t segment_size = entries[i].streamed ? GetStreamChunkSize(block_size) : metadata.size;
+        for (size_t segment = 0; segment < metadata.size; segment += segment_size) {
+            size_t segment_end = std::min(metadata.size, segment + segment_size);
+            for (size_t begin = segment; begin < segment_end; begin += task_size) {
+                tasks.push_back(VerificationTask{live_entries.size() - 1, begin, 
+                    std::min(task_size, segment_end - begin)});
+            }
+        }
+        max_task_size = std::max(max_task_size, GetEncodedMsgSize(task_size, block_size));
     }
 
-    return res;
-}
+    std::vector<BlockCounts> task_counts(tasks.size());
+    size_t workers_count = std::min(threads_count, tasks.size());
+    WorkStealingQueue<size_t> queue(std::max(workers_count, static_cast<size_t>(1)));
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        queue.Push(i % workers_count, i);
+    }
+    mapping.Advise(0, mapping.GetSize(), MappedFile::AccessPattern::kSequential);
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < workers_count; ++i) {
+        workers.emplace_back([this, i, &arcfile, &queue, &tasks, &task_counts, &live_entries, 
+            &mapping, max_task_size] {
 
-HamArchiver::ExtractionResult HamArchiver::ExtractFile(
-    FileMetadata metadata, std::fstream& stream, bool forced) {
-    
-    std::streampos start_pos = stream.tellg();
-    size_t full_blocks = metadata.size / metadata.encoding_block_size;
-    size_t encoded_block_size = GetEncodedMsgSize(metadata.encoding_block_size);
-    ExtractionResult exit_code = ExtractionResult::kSuccess;
-    for (size_t i = 0; i <= full_blocks; ++i) {
-        size_t cur_block_size = metadata.encoding_block_size;
-        if (i == full_blocks) {
-            size_t last_block_size = metadata.size % metadata.encoding_block_size;
-            if (last_block_size == 0) {
-                break;
+            MemoryStream memory_reader;
+            FileStream file_reader;
+            uint8_t* buf = nullptr;
+            if (mapping.IsOpen()) {
+                memory_reader.SetData(mapping.GetData(), mapping.GetSize());
+            } else {
+                file_operator->OpenForReading(arcfile, file_reader, std::ifstream::binary);
+                buf = new uint8_t[max_task_size];
             }
-            cur_block_size = last_block_size;
-            encoded_block_size = GetEncodedMsgSize(cur_block_size);
+            std::istream& stream = mapping.IsOpen() 
+                ? static_cast<std::istream&>(memory_reader) : file_reader;
+            size_t task;
+            while (queue.Pop(i, task)) {
+                VerifyRange(live_entries[tasks[task].entry], tasks[task], stream, buf, task_counts[task]);
+            }
+            delete [] buf;
+        });
+    }
+    for (size_t i = 0; i < workers.size(); ++i) {
+        workers[i].join();
+    }
+
+    bool files_corrupted = false;
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        BlockCounts& counts = report.entries[tasks[i].entry].blocks;
+        counts.clean += task_counts[i].clean;
+        counts.corrected += task_counts[i].corrected;
+        counts.corrupted += task_counts[i].corrupted;
+    }
+    for (size_t i = 0; i < report.entries.size(); ++i) {
+        files_corrupted = files_corrupted || report.entries[i].blocks.corrupted != 0;
+    }
+    if (!complete || report.index.corrupted != 0) {
+        return VerificationResult::kArcCorrupted;
+    }
+
+    return files_corrupted ? VerificationResult::kFileCorrupted : VerificationResult::kSuccess;
+}
+
+void HamArchiver::VerifyBlock(const uint8_t* encoded, size_t block_size, BlockCounts& counts) {
+    size_t error_bit;
+    Decoder::ValidationResult result = Decoder::Validate(encoded, block_size, 
+        encoded + block_size, error_bit);
+    CountValidation(result);
+    switch (result) {
+        case Decoder::ValidationResult::kValid:
+            ++counts.clean;
+            break;
+        case Decoder::ValidationResult::kSingleErrorFixed:
+            ++counts.corrected;
+            break;
+        case Decoder::ValidationResult::kDoubleError:
+            ++counts.corrupted;
+    }
+}
+
+void HamArchiver::VerifyEntryMetadata(std::istream& stream, const IndexEntry& entry, 
+    BlockCounts& counts) {
+
+    size_t filename_size = entry.metadata.path.filename().string().size();
+    decoder_context.Reserve(std::max(kNumericMetadataSize, filename_size));
+    stream.clear();
+    metrics.Add(Metrics::Counter::kSeeks, 1);
+    stream.seekg(entry.offset, std::istream::beg);
+    for (size_t block_size : {kNumericMetadataSize, filename_size}) {
+        const uint8_t* encoded = ReadBytes(stream, GetEncodedMsgSize(block_size), 
+            decoder_context.GetEncodedBuffer());
+        if (encoded == nullptr) {
+            ++counts.corrupted;
+            continue;
+        }
+        VerifyBlock(encoded, block_size, counts);
+    }
+    if (!entry.streamed) {
+        return;
+    }
+
+    // Заголовки всех порций, включая завершающую порцию нулевого размера
+    size_t block_size = entry.metadata.encoding_block_size;
+    size_t chunk_size = GetStreamChunkSize(block_size);
+    size_t encoded_header_size = GetEncodedMsgSize(kChunkHeaderSize);
+    size_t header_offset = entry.content_offset;
+    size_t chunks_count = (entry.metadata.size + chunk_size - 1) / chunk_size + 1;
+    for (size_t i = 0; i < chunks_count; ++i) {
+        size_t chunk_begin = std::min(entry.metadata.size, i * chunk_size);
+        size_t cur_chunk_size = std::min(chunk_size, entry.metadata.size - chunk_begin);
+        stream.clear();
+        metrics.Add(Metrics::Counter::kSeeks, 1);
+        stream.seekg(header_offset, std::istream::beg);
+        const uint8_t* encoded = ReadBytes(stream, encoded_header_size, 
+            decoder_context.GetEncodedBuffer());
+        if (encoded == nullptr) {
+            ++counts.corrupted;
+        } else {
+            VerifyBlock(encoded, kChunkHeaderSize, counts);
         }
+        header_offset += encoded_header_size + GetEncodedMsgSize(cur_chunk_size, block_size);
+    }
+}
 
-        Decoder::ValidationResult cur_block_state = Decoder::Validate(
-            stream, cur_block_size);
-        if (cur_block_state == Decoder::ValidationResult::kDoubleError) {
-            exit_code = ExtractionResult::kFileCorrupted;
-            if (!forced) {
-                stream.seekg(start_pos + static_cast<std::streampos>(
-                    GetEncodedMsgSize
-                (
-                    metadata.size, metadata.encoding_block_size
-                )
-                ), std::fstream::beg);
-                return exit_code;
-            }
+void HamArchiver::VerifyIndex(std::istream& stream, size_t arc_size, BlockCounts& counts) {
+    size_t index_offset;
+    size_t body_size;
+    if (!ReadIndexTrailer(stream, arc_size, index_offset, body_size)) {
+        return;
+    }
+    decoder_context.Reserve(std::max(kIndexBlockSize, kIndexTrailerSize));
+    stream.clear();
+    metrics.Add(Metrics::Counter::kSeeks, 1);
+    stream.seekg(index_offset, std::istream::beg);
+    for (size_t i = 0; i < body_size; i += kIndexBlockSize) {
+        size_t cur_block_size = std::min(kIndexBlockSize, body_size - i);
+        const uint8_t* encoded = ReadBytes(stream, GetEncodedMsgSize(cur_block_size), 
+            decoder_context.GetEncodedBuffer());
+        if (encoded == nullptr) {
+            ++counts.corrupted;
+            return;
         }
-        stream.seekg(encoded_block_size, std::fstream::cur);
+        VerifyBlock(encoded, cur_block_size, counts);
+    }
+    const uint8_t* encoded = ReadBytes(stream, GetEncodedMsgSize(kIndexTrailerSize), 
+        decoder_context.GetEncodedBuffer());
+    if (encoded == nullptr) {
+        ++counts.corrupted;
+        return;
     }
+    VerifyBlock(encoded, kIndexTrailerSize, counts);
+}
 
-    file_operator.CreateFile(metadata.path.filename());
-    std::ofstream writer;
-    file_operator.OpenForWriting(metadata.path.filename(), 
-        writer, std::fstream::binary);
-    stream.seekg(start_pos, std::fstream::beg);
+void HamArchiver::VerifyRange(const IndexEntry& entry, const VerificationTask& task, 
+    std::istream& stream, uint8_t* buf, BlockCounts& counts) {
 
-    for (size_t i = 0; i <= full_blocks; ++i) {
-        size_t cur_block_size = metadata.encoding_block_size;
-        if (i == full_blocks) {
-            size_t last_block_size = metadata.size % metadata.encoding_block_size;
-            if (last_block_size == 0) {
+    size_t block_size = entry.metadata.encoding_block_size;
+    size_t encoded_offset;
+    size_t block_begin;
+    size_t first_block_size;
+    LocateBlock(entry, task.begin, encoded_offset, block_begin, first_block_size);
+    stream.clear();
+    metrics.Add(Metrics::Counter::kSeeks, 1);
+    stream.seekg(encoded_offset, std::istream::beg);
+    const uint8_t* encoded = ReadBytes(stream, GetEncodedMsgSize(task.size, block_size), buf);
+    if (encoded == nullptr) {
+        // Архив обрезан: недочитанные блоки считаются повреждёнными
+        counts.corrupted += (task.size + block_size - 1) / block_size;
+        return;
+    }
+    for (size_t pos = 0; pos < task.size;) {
+        size_t cur_block_size = std::min(block_size, task.size - pos);
+        VerifyBlock(encoded, cur_block_size, counts);
+        encoded += GetEncodedMsgSize(cur_block_size);
+        pos += cur_block_size;
+    }
+}
+
+HamArchiver::ScrubResult HamArchiver::Scrub(std::filesystem::path arcfile, 
+    const ScrubOptions& options, ScrubReport& report) {
+
+    Metrics::PhaseTimer timer(metrics, Metrics::Phase::kScrub);
+    report = ScrubReport{};
+    if (!file_operator->FileExists(arcfile)) {
+        return ScrubResult::kArcNotFound;
+    }
+    std::unique_ptr<IdleIoPriority> priority;
+    if (options.idle_priority) {
+        priority = std::make_unique<IdleIoPriority>();
+    }
+    FileStream stream;
+    file_operator->Open(arcfile, stream, std::fstream::in | std::fstream::out | std::fstream::binary);
+    size_t arc_size = file_operator->GetFileSize(arcfile);
+    size_t entries_end;
+    bool complete;
+    std::vector<IndexEntry> entries = LoadEntries(stream, arc_size, entries_end, complete);
+    std::vector<ScrubRegion> regions = GetScrubRegions(stream, arc_size, entries);
+    std::sort(regions.begin(), regions.end(), [](const ScrubRegion& lhs, const ScrubRegion& rhs) {
+        return lhs.offset < rhs.offset;
+    });
+
+    // Контрольная точка архива другого размера относится к его прежнему состоянию
+    std::filesystem::path checkpoint_file = arcfile;
+    checkpoint_file += ".scrub";
+    size_t checkpoint_arc_size;
+    size_t resume_offset;
+    if (file_operator->FileExists(checkpoint_file) 
+        && ReadScrubCheckpoint(checkpoint_file, checkpoint_arc_size, resume_offset) 
+        && checkpoint_arc_size == arc_size) {
+
+        report.resumed_offset = resume_offset;
+    }
+
+    size_t max_batch_size = 0;
+    for (const ScrubRegion& region : regions) {
+        size_t batch_size = region.block_size 
+            * std::max(kExtractionChunkSize / region.block_size, static_cast<size_t>(1));
+        max_batch_size = std::max(max_batch_size, 
+            GetEncodedMsgSize(std::min(batch_size, region.size), region.block_size));
+    }
+    uint8_t* buf = new uint8_t[max_batch_size];
+    auto start = std::chrono::steady_clock::now();
+    size_t checkpoint_progress = 0;
+    ScrubResult result = ScrubResult::kSuccess;
+    for (size_t i = 0; i < regions.size() && result == ScrubResult::kSuccess; ++i) {
+        const ScrubRegion& region = regions[i];
+        size_t encoded_block_size = GetEncodedMsgSize(region.block_size);
+        size_t blocks_count = (region.size + region.block_size - 1) / region.block_size;
+        size_t batch_blocks = std::max(kExtractionChunkSize / region.block_size, static_cast<size_t>(1));
+        // Контрольная точка всегда приходится на начало блока
+        size_t first_block = region.offset < report.resumed_offset 
+            ? std::min(blocks_count, (report.resumed_offset - region.offset) / encoded_block_size) : 0;
+        for (size_t block = first_block; block < blocks_count; block += batch_blocks) {
+            size_t begin = block * region.block_size;
+            size_t size = std::min(batch_blocks * region.block_size, region.size - begin);
+            size_t offset = region.offset + block * encoded_block_size;
+            result = ScrubBlocks(stream, offset, size, region.block_size, buf, report);
+            if (result != ScrubResult::kSuccess) {
                 break;
             }
-            cur_block_size = last_block_size;
+            if (options.max_rate != 0) {
+                std::chrono::duration<double> due(
+                    static_cast<double>(report.bytes_read + report.bytes_written) / options.max_rate);
+                std::this_thread::sleep_until(
+                    start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(due));
+            }
+            checkpoint_progress += GetEncodedMsgSize(size, region.block_size);
+            if (checkpoint_progress >= kScrubCheckpointInterval) {
+                if (!WriteScrubCheckpoint(checkpoint_file, arc_size, 
+                    offset + GetEncodedMsgSize(size, region.block_size))) {
+
+                    result = ScrubResult::kWriteError;
+                    break;
+                }
+                checkpoint_progress = 0;
+            }
         }
+    }
+    delete [] buf;
+    stream.Close();
+    if (report.bytes_written != 0) {
+        InvalidateCache(arcfile);
+    }
+    if (result == ScrubResult::kWriteError) {
+        return result;
+    }
+    file_operator->DeleteFile(checkpoint_file);
+    if (!complete || result == ScrubResult::kArcCorrupted) {
+        return ScrubResult::kArcCorrupted;
+    }
 
-        Copydata::CopyData(stream, writer, cur_block_size);
-        stream.seekg(GetMsgCodeSize(cur_block_size), std::fstream::cur);
+    return report.blocks.corrupted != 0 ? ScrubResult::kFileCorrupted : ScrubResult::kSuccess;
+}
+
+std::vector<HamArchiver::ScrubResult> HamArchiver::Scrub(
+    const std::vector<std::filesystem::path>& arcfiles, const ScrubOptions& options, 
+    std::vector<ScrubReport>& reports) {
+
+    std::vector<ScrubResult> results(arcfiles.size());
+    reports.assign(arcfiles.size(), ScrubReport{});
+    for (size_t i = 0; i < arcfiles.size(); ++i) {
+        results[i] = Scrub(arcfiles[i], options, reports[i]);
     }
 
-    return exit_code;
+    return results;
 }
 
-HamArchiver::FileMetadata HamArchiver::GetMetadata(std::fstream& stream) {
-    if (Decoder::Validate(stream, kNumericMetadataSize) == Decoder::ValidationResult::kDoubleError) {
-        return FileMetadata{
-            std::filesystem::path{}, 
-            static_cast<size_t>(-1), 
-            static_cast<size_t>(-1)
-        };
+std::vector<HamArchiver::ScrubRegion> HamArchiver::GetScrubRegions(std::istream& stream, 
+    size_t arc_size, const std::vector<IndexEntry>& entries) {
+
+    std::vector<ScrubRegion> regions;
+    for (const IndexEntry& entry : entries) {
+        size_t filename_size = entry.metadata.path.filename().string().size();
+        regions.push_back(ScrubRegion{entry.offset, kNumericMetadataSize, kNumericMetadataSize});
+        regions.push_back(ScrubRegion{entry.offset + GetEncodedMsgSize(kNumericMetadataSize), 
+            filename_size, filename_size});
+        size_t size = entry.metadata.size;
+        size_t block_size = entry.metadata.encoding_block_size;
+        if (entry.deleted || (size == 0 && !entry.streamed)) {
+            continue;
+        }
+        if (!entry.streamed) {
+            regions.push_back(ScrubRegion{entry.content_offset, size, block_size});
+            continue;
+        }
+        size_t chunk_size = GetStreamChunkSize(block_size);
+        size_t encoded_header_size = GetEncodedMsgSize(kChunkHeaderSize);
+        size_t header_offset = entry.content_offset;
+        size_t chunks_count = (size + chunk_size - 1) / chunk_size + 1;
+        for (size_t i = 0; i < chunks_count; ++i) {
+            size_t cur_chunk_size = std::min(chunk_size, size - std::min(size, i * chunk_size));
+            regions.push_back(ScrubRegion{header_offset, kChunkHeaderSize, kChunkHeaderSize});
+            regions.push_back(ScrubRegion{header_offset + encoded_header_size, cur_chunk_size, block_size});
+            header_offset += encoded_header_size + GetEncodedMsgSize(cur_chunk_size, block_size);
+        }
     }
-    uint8_t* numeric_metadata_buf = new uint8_t[kNumericMetadataSize];
-    stream.read(reinterpret_cast<char*>(numeric_metadata_buf), kNumericMetadataSize);
-    HamArchiver::FileMetadata file{std::filesystem::path{}, 0, 0};
-    size_t filename_size = 0;
-    for (size_t i = 0; i < 4; ++i) {
-        filename_size |= (static_cast<size_t>(numeric_metadata_buf[i]) << i * 8);
-    }
-    for (size_t i = 0; i < 8; ++i) {
-        file.size |= (static_cast<size_t>(numeric_metadata_buf[i + 4]) << i * 8);
-    }
-    for (size_t i = 0; i < 8; ++i) {
-        file.encoding_block_size |= (static_cast<size_t>(numeric_metadata_buf[i + 12]) << i * 8);
-    }
-    delete [] numeric_metadata_buf;
-    stream.seekg(GetMsgCodeSize(kNumericMetadataSize), std::fstream::cur);
-    if (Decoder::Validate(stream, filename_size) == Decoder::ValidationResult::kDoubleError) {
-        stream.seekg(GetEncodedMsgSize(filename_size), std::fstream::cur);
-        return file;
-    }
-    char* filename_buf = new char[filename_size];
-    stream.read(filename_buf, filename_size);
-    stream.seekg(GetMsgCodeSize(filename_size), std::fstream::cur);
-    file.path = std::string{filename_buf, filename_size};
-    delete [] filename_buf;
-    
-    return file;
+    size_t index_offset;
+    size_t body_size;
+    if (ReadIndexTrailer(stream, arc_size, index_offset, body_size)) {
+        regions.push_back(ScrubRegion{index_offset, body_size, kIndexBlockSize});
+        regions.push_back(ScrubRegion{index_offset + GetEncodedMsgSize(body_size, kIndexBlockSize), 
+            kIndexTrailerSize, kIndexTrailerSize});
+    }
+    regions.erase(std::remove_if(regions.begin(), regions.end(), [](const ScrubRegion& region) {
+        return region.size == 0;
+    }), regions.end());
+
+    return regions;
 }
 
-void HamArchiver::WriteEncodedMetadata(FileMetadata file, std::ostream& writer) {
-    std::string filename = file.path.filename().string();
-    uint8_t* numeric_metadata_buf = new uint8_t[kNumericMetadataSize];
+HamArchiver::ScrubResult HamArchiver::ScrubBlocks(FileStream& stream, size_t offset, size_t size, 
+    size_t block_size, uint8_t* buf, ScrubReport& report) {
 
-    for (size_t i = 0; i < 4; ++i) {
-        numeric_metadata_buf[i] = (filename.size() >> (8 * i)) & 0b11111111;
+    size_t encoded_size = GetEncodedMsgSize(size, block_size);
+    stream.clear();
+    metrics.Add(Metrics::Counter::kSeeks, 1);
+    stream.seekg(offset, std::fstream::beg);
+    stream.read(reinterpret_cast<char*>(buf), encoded_size);
+    CountRead(stream);
+    report.bytes_read += stream.gcount();
+    if (static_cast<size_t>(stream.gcount()) != encoded_size) {
+        // Архив обрезан: недочитанные блоки считаются повреждёнными
+        report.blocks.corrupted += (size + block_size - 1) / block_size;
+        return ScrubResult::kArcCorrupted;
     }
-    for (size_t i = 0; i < 8; ++i) {
-        numeric_metadata_buf[i + 4] = (file.size >> (8 * i)) & 0b11111111;
+
+    // Исправленные участки буфера [begin, end); близкие участки объединяются
+    std::vector<std::pair<size_t, size_t>> fixes;
+    uint8_t* block = buf;
+    for (size_t pos = 0; pos < size;) {
+        size_t cur_block_size = std::min(block_size, size - pos);
+        size_t error_bit;
+        Decoder::ValidationResult result = Decoder::Validate(block, cur_block_size, 
+            block + cur_block_size, error_bit);
+        CountValidation(result);
+        size_t fix_begin = 0;
+        size_t fix_end = 0;
+        switch (result) {
+            case Decoder::ValidationResult::kValid:
+                ++report.blocks.clean;
+                break;
+            case Decoder::ValidationResult::kDoubleError:
+                ++report.blocks.corrupted;
+                break;
+            case Decoder::ValidationResult::kSingleErrorFixed:
+                ++report.blocks.corrected;
+                if (error_bit != Decoder::kNoDataError) {
+                    BitOperator::FlipBit(block[error_bit / 8], error_bit % 8);
+                    fix_begin = error_bit / 8;
+                    fix_end = fix_begin + 1;
+                } else {
+                    // Ошибка в коде: код исправленного блока совпадает с исходным
+                    Encoder::GetCode(block, cur_block_size, block + cur_block_size);
+                    fix_begin = cur_block_size;
+                    fix_end = cur_block_size + GetMsgCodeSize(cur_block_size);
+                }
+                fix_begin += block - buf;
+                fix_end += block - buf;
+                if (!fixes.empty() && fix_begin <= fixes.back().second + kScrubWriteGap) {
+                    fixes.back().second = std::max(fixes.back().second, fix_end);
+                } else {
+                    fixes.emplace_back(fix_begin, fix_end);
+                }
+        }
+        block += GetEncodedMsgSize(cur_block_size);
+        pos += cur_block_size;
     }
-    for (size_t i = 0; i < 8; ++i) {
-        numeric_metadata_buf[i + 12] = (file.encoding_block_size >> (8 * i)) & 0b11111111;
+    if (fixes.empty()) {
+        return ScrubResult::kSuccess;
     }
-    
-    writer.write(reinterpret_cast<char*>(numeric_metadata_buf), kNumericMetadataSize);
-    Encoder::EncodeAndWrite(numeric_metadata_buf, writer, kNumericMetadataSize);
-    delete [] numeric_metadata_buf;
-    writer.write(filename.data(), filename.size());
-    Encoder::EncodeAndWrite(reinterpret_cast<uint8_t*>(filename.data()), writer, filename.size());    
+    for (const auto& [begin, end] : fixes) {
+        metrics.Add(Metrics::Counter::kSeeks, 1);
+        stream.seekp(offset + begin, std::fstream::beg);
+        stream.write(reinterpret_cast<const char*>(buf + begin), end - begin);
+        report.bytes_written += end - begin;
+        ++report.writes;
+    }
+    stream.flush();
 
+    return stream.good() ? ScrubResult::kSuccess : ScrubResult::kWriteError;
 }
 
-HamArchiver::AdditionResult HamArchiver::WriteEncodedFile(FileMetadata file, std::ostream& writer) {
-    AdditionResult exit_code;
-    if (!file_operator.FileExists(file.path)) {
-        return AdditionResult::kFileNotFound;
-    }
-    file.size = file_operator.GetFileSize(file.path);
-    file.encoding_block_size = std::min(file.size, file.encoding_block_size);
-    std::ifstream raw_file_reader;
-    if (!file_operator.OpenForReading(file.path, raw_file_reader, std::ifstream::binary)) {
-        return AdditionResult::kFileNotAccessible;
+bool HamArchiver::ReadScrubCheckpoint(std::filesystem::path checkpoint_file, size_t& arc_size, 
+    size_t& offset) {
+
+    const size_t header_size = 8 * 2;
+    uint8_t header[header_size + Encoder::kMaxCodeSize];
+    FileStream reader;
+    file_operator->OpenForReading(checkpoint_file, reader, std::ifstream::binary);
+    reader.read(reinterpret_cast<char*>(header), GetEncodedMsgSize(header_size));
+    bool valid = reader.good() && Decoder::Validate(header, header_size, header + header_size) 
+        != Decoder::ValidationResult::kDoubleError;
+    arc_size = LoadNumber(header, 8);
+    offset = LoadNumber(header + 8, 8);
+
+    return valid && offset <= arc_size;
+}
+
+bool HamArchiver::WriteScrubCheckpoint(std::filesystem::path checkpoint_file, size_t arc_size, 
+    size_t offset) {
+
+    uint8_t header[8 * 2];
+    StoreNumber(header, arc_size, 8);
+    StoreNumber(header + 8, offset, 8);
+    std::filesystem::path tmp = checkpoint_file;
+    tmp += ".tmp";
+    {
+        FileStream writer;
+        if (!file_operator->OpenForWriting(tmp, writer, std::ofstream::trunc | std::ofstream::binary)) {
+            return false;
+        }
+        writer.write(reinterpret_cast<char*>(header), sizeof(header));
+        Encoder::EncodeAndWrite(header, writer, sizeof(header));
+        // Как и у уплотнения: содержимое сохраняется до переименования
+        if (!writer.SyncToDevice()) {
+            return false;
+        }
     }
-    WriteEncodedMetadata(file, writer);
+    file_operator->RenameFile(tmp, checkpoint_file);
+
+    return file_operator->SyncDir(checkpoint_file.parent_path());
+}
+
+std::vector<HamArchiver::ExtractionResult> HamArchiver::DeleteFiles(std::filesystem::path arcfile, 
+        const std::vector<std::string>& filenames) {
 
-    for (size_t i = 0; i < file.size; i += file.encoding_block_size) {
-        size_t cur_block_size = std::min(file.encoding_block_size, file.size - i);
-        Copydata::CopyData(raw_file_reader, writer, cur_block_size);
-        raw_file_reader.seekg(-static_cast<std::streamoff>(cur_block_size), std::ifstream::cur);
-        Encoder::EncodeAndWrite(raw_file_reader, writer, cur_block_size);
+    Metrics::PhaseTimer timer(metrics, Metrics::Phase::kDeletion);
+
+    if (!file_operator->FileExists(arcfile)) {
+        return {ExtractionResult::kArcNotFound};
     }
-    
-    return AdditionResult::kSuccess;
+    if (filenames.empty()) {
+        return {ExtractionResult::kEmptyFileList};
+    }
+    InvalidateCache(arcfile);
+
+    std::unordered_map<std::string_view, ExtractionResult> file_states;
+    for (size_t i = 0; i < filenames.size(); ++i) {
+        file_states[filenames[i]] = ExtractionResult::kFileNotFound;
+    }
+
+    size_t arc_size = file_operator->GetFileSize(arcfile);
+    size_t entries_end = arc_size;
+    size_t body_size;
+    bool indexed = false;
+    bool complete = true;
+    std::vector<IndexEntry> entries;
+    FileStream stream;
+    file_operator->Open(arcfile, stream, std::fstream::in | std::fstream::out | std::fstream::binary);
+    if (ReadIndexTrailer(stream, arc_size, entries_end, body_size)) {
+        indexed = ReadIndexBody(stream, entries_end, body_size, entries);
+    }
+    if (!indexed) {
+        entries.clear();
+        complete = ScanEntries(stream, entries_end, entries);
+    }
+
+    std::vector<size_t> deleted;
+    stream.clear();
+    for (size_t i = 0; i < entries.size(); ++i) {
+        std::string cur_filename = entries[i].metadata.path.filename().string();
+        if (!entries[i].deleted && !cur_filename.empty() 
+            && file_states.find(cur_filename) != file_states.end()) {
+
+            file_states[cur_filename] = ExtractionResult::kSuccess;
+            entries[i].deleted = true;
+            WriteDeletedMetadata(entries[i], stream);
+            deleted.push_back(i);
+        }
+    }
+
+    if (indexed && !deleted.empty()) {
+        // Размер оглавления не меняется: перекодируются только блоки 
+        // с изменёнными размерами названий
+        std::string body;
+        std::vector<size_t> record_offsets;
+        BuildIndexBody(entries, body, record_offsets);
+        std::vector<size_t> blocks;
+        for (size_t i = 0; i < deleted.size(); ++i) {
+            size_t field_offset = record_offsets[deleted[i]] + kIndexNameSizeOffset;
+            blocks.push_back(field_offset / kIndexBlockSize);
+            blocks.push_back((field_offset + kNameSizeFieldSize - 1) / kIndexBlockSize);
+        }
+        std::sort(blocks.begin(), blocks.end());
+        blocks.erase(std::unique(blocks.begin(), blocks.end()), blocks.end());
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            size_t block_offset = blocks[i] * kIndexBlockSize;
+            size_t cur_block_size = std::min(kIndexBlockSize, body.size() - block_offset);
+            metrics.Add(Metrics::Counter::kSeeks, 1);
+            stream.seekp(entries_end + blocks[i] * GetEncodedMsgSize(kIndexBlockSize), std::fstream::beg);
+            stream.write(body.data() + block_offset, cur_block_size);
+            Encoder::EncodeAndWrite(
+                reinterpret_cast<const uint8_t*>(body.data() + block_offset), stream, cur_block_size);
+        }
+    }
+    stream.Close();
+    bool written = stream.good();
+    if (written && !indexed && complete && write_index && !deleted.empty()) {
+        if (entries_end != arc_size) {
+            file_operator->ResizeFile(arcfile, entries_end);
+        }
+        FileStream writer;
+        written = file_operator->OpenForWriting(arcfile, writer, std::ofstream::app | std::ofstream::binary);
+        WriteIndex(entries, writer, entries_end);
+        writer.Close();
+        written = written && writer.good();
+    }
+
+    std::vector<ExtractionResult> res(filenames.size());
+    for (size_t i = 0; i < filenames.size(); ++i) {
+        res[i] = file_states[filenames[i]];
+        // Признак удаления мог не дойти до архива
+        if (!written && res[i] == ExtractionResult::kSuccess) {
+            res[i] = ExtractionResult::kWriteError;
+        }
+    }
+    if (!complete) {
+        res.push_back(ExtractionResult::kArcCorrupted);
+    }
+
+    return res;
+}
+
+HamArchiver::VacuumResult HamArchiver::Vacuum(std::filesystem::path arcfile, double threshold) {
+    Metrics::PhaseTimer timer(metrics, Metrics::Phase::kVacuum);
+    if (!file_operator->FileExists(arcfile)) {
+        return VacuumResult::kArcNotFound;
+    }
+    InvalidateCache(arcfile);
+    std::filesystem::path checkpoint_file = arcfile;
+    checkpoint_file += ".vacuum";
+    VacuumCheckpoint checkpoint{0, 0, 0, 0};
+    std::vector<uint8_t> pending(kVacuumBufferSize);
+    bool resumed = file_operator->FileExists(checkpoint_file);
+    if (resumed && !ReadVacuumCheckpoint(checkpoint_file, checkpoint, pending.data())) {
+        return VacuumResult::kArcCorrupted;
+    }
+
+    size_t arc_size = file_operator->GetFileSize(arcfile);
+    size_t entries_end = arc_size;
+    std::vector<IndexEntry> entries;
+    if (resumed && checkpoint.src == checkpoint.entries_end) {
+        // Данные уже перенесены, а оглавление могло быть перезаписано:
+        // файлы находятся просмотром уплотнённой части
+        entries_end = checkpoint.dst;
+        FileStream reader;
+        file_operator->OpenForReading(arcfile, reader, std::ifstream::binary);
+        if (entries_end > arc_size || !ScanEntries(reader, entries_end, entries)) {
+            return VacuumResult::kArcCorrupted;
+        }
+    } else {
+        FileStream reader;
+        file_operator->OpenForReading(arcfile, reader, std::ifstream::binary);
+        size_t body_size;
+        bool indexed = ReadIndexTrailer(reader, arc_size, entries_end, body_size) 
+            && ReadIndexBody(reader, entries_end, body_size, entries);
+        // Прерванный перенос продолжается только по исходному оглавлению
+        if (resumed && (!indexed || entries_end != checkpoint.entries_end)) {
+            return VacuumResult::kArcCorrupted;
+        }
+        if (!indexed) {
+            entries.clear();
+            if (!ScanEntries(reader, entries_end, entries)) {
+                return VacuumResult::kArcCorrupted;
+            }
+        }
+        reader.Close();
+
+        size_t dead_size = 0;
+        size_t first_dead = entries_end;
+        for (size_t i = 0; i < entries.size(); ++i) {
+            if (entries[i].deleted) {
+                dead_size += GetEntrySize(entries[i]);
+                first_dead = std::min(first_dead, entries[i].offset);
+            }
+        }
+        if (!resumed && (dead_size == 0 || dead_size < threshold * entries_end)) {
+            return VacuumResult::kBelowThreshold;
+        }
+
+        if (!indexed) {
+            // Оглавление исходного архива нужно для продолжения прерванного переноса
+            std::string body;
+            std::vector<size_t> record_offsets;
+            if (!BuildIndexBody(entries, body, record_offsets)) {
+                return VacuumResult::kArcCorrupted;
+            }
+            if (entries_end != arc_size) {
+                file_operator->ResizeFile(arcfile, entries_end);
+            }
+            FileStream writer;
+            if (!file_operator->OpenForWriting(arcfile, writer, std::ofstream::app | std::ofstream::binary)) {
+                return VacuumResult::kWriteError;
+            }
+            WriteIndex(entries, writer, entries_end);
+            if (!writer.SyncToDevice()) {
+                return VacuumResult::kWriteError;
+            }
+        }
+        if (!resumed) {
+            checkpoint = VacuumCheckpoint{entries_end, first_dead, first_dead, 0};
+            if (!WriteVacuumCheckpoint(checkpoint_file, checkpoint, nullptr)) {
+                return VacuumResult::kWriteError;
+            }
+        }
+
+        // Прерванное уплотнение продолжается следующим вызовом по контрольной точке
+        if (!CompactEntries(arcfile, checkpoint_file, entries, checkpoint, pending.data(), entries_end)) {
+            return VacuumResult::kWriteError;
+        }
+
+        std::vector<IndexEntry> kept_entries;
+        size_t shift = 0;
+        for (size_t i = 0; i < entries.size(); ++i) {
+            if (entries[i].deleted) {
+                shift += GetEntrySize(entries[i]);
+                continue;
+            }
+            IndexEntry kept = entries[i];
+            kept.offset -= shift;
+            kept.content_offset -= shift;
+            kept_entries.push_back(kept);
+        }
+        entries = kept_entries;
+    }
+
+    file_operator->ResizeFile(arcfile, entries_end);
+    if (entries.empty()) {
+        file_operator->DeleteFile(arcfile);
+    } else if (write_index) {
+        FileStream writer;
+        bool written = file_operator->OpenForWriting(arcfile, writer, std::ofstream::app | std::ofstream::binary);
+        WriteIndex(entries, writer, entries_end);
+        writer.Close();
+        // Контрольная точка сохраняется: повторный вызов найдёт файлы просмотром
+        if (!written || !writer.good()) {
+            return VacuumResult::kWriteError;
+        }
+    }
+    file_operator->DeleteFile(checkpoint_file);
+
+    return VacuumResult::kSuccess;
+}
+
+
+std::vector<HamArchiver::AdditionResult> HamArchiver::AppendFiles(std::filesystem::path arcfile, 
+        const std::vector<FileMetadata>& files) {
+
+    Metrics::PhaseTimer timer(metrics, Metrics::Phase::kEncoding);
+    std::vector<AdditionResult> addition_result;
+    if (!file_operator->FileExists(arcfile)) {
+        addition_result.push_back(AdditionResult::kArcNotFound);
+        return addition_result;
+    }
+    if (files.empty()) {
+        addition_result.push_back(AdditionResult::kEmptyFileList);
+        return addition_result;
+    }
+    
+    std::vector<IndexEntry> entries;
+    size_t offset;
+    bool complete = PrepareAppend(arcfile, entries, offset);
+    FileStream writer;
+    file_operator->OpenForWriting(arcfile, writer, std::ofstream::app | std::ofstream::binary);
+    addition_result = WriteEntries(files, writer, entries, offset);
+    if (write_index && complete) {
+        WriteIndex(entries, writer, offset);
+    }
+
+    return addition_result;
+}
+
+std::vector<HamArchiver::AdditionResult> HamArchiver::WriteEntries(
+    const std::vector<FileMetadata>& files, std::ostream& writer, 
+    std::vector<IndexEntry>& entries, size_t& offset) {
+
+    // Смещения вычисляются по размерам записей, а не по позиции потока
+    std::vector<AdditionResult> addition_result(files.size());
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (!writer.good()) {
+            addition_result[i] = AdditionResult::kWriteError;
+            continue;
+        }
+        FileMetadata file = files[i];
+        addition_result[i] = WriteEncodedFile(file, writer);
+        if (addition_result[i] != AdditionResult::kSuccess) {
+            continue;
+        }
+        file.path = file.path.filename();
+        IndexEntry entry{file, offset, offset + GetEncodedMetadataSize(file.path.string().size())};
+        entries.push_back(entry);
+        offset += GetEntrySize(entry);
+    }
+
+    return addition_result;
+}
+
+HamArchiver::AdditionResult HamArchiver::AppendStream(std::filesystem::path arcfile, 
+    FileMetadata file, std::istream& reader) {
+
+    Metrics::PhaseTimer timer(metrics, Metrics::Phase::kEncoding);
+    if (!file_operator->FileExists(arcfile)) {
+        return AdditionResult::kArcNotFound;
+    }
+
+    std::vector<IndexEntry> entries;
+    size_t offset;
+    bool complete = PrepareAppend(arcfile, entries, offset);
+    FileStream writer;
+    file_operator->OpenForWriting(arcfile, writer, std::ofstream::app | std::ofstream::binary);
+    AdditionResult exit_code = WriteEncodedStream(file, reader, writer);
+    if (exit_code == AdditionResult::kSuccess) {
+        file.path = file.path.filename();
+        IndexEntry entry{file, offset, offset + GetEncodedMetadataSize(file.path.string().size()), 
+            false, true};
+        entries.push_back(entry);
+        offset += GetEntrySize(entry);
+    }
+    if (write_index && complete) {
+        WriteIndex(entries, writer, offset);
+    }
+
+    return exit_code;
+}
+
+HamArchiver::CreationResult HamArchiver::CreateFromStream(std::string_view arcname, 
+    FileMetadata file, std::istream& reader) {
+
+    if (file_operator->FileExists(arcname)) {
+        return CreationResult::kArcAlreadyExists;
+    }
+    file_operator->CreateFile(arcname);
+    if (AppendStream(arcname, file, reader) != AdditionResult::kSuccess) {
+        file_operator->DeleteFile(arcname);
+        return CreationResult::kFileNotAccessible;
+    }
+
+    return CreationResult::kSuccess;
+}
+
+HamArchiver::CreationResult HamArchiver::CreateFromStream(std::ostream& writer, 
+    FileMetadata file, std::istream& reader) {
+
+    Metrics::PhaseTimer timer(metrics, Metrics::Phase::kEncoding);
+    if (WriteEncodedStream(file, reader, writer) != AdditionResult::kSuccess) {
+        return CreationResult::kFileNotAccessible;
+    }
+    file.path = file.path.filename();
+    IndexEntry entry{file, 0, GetEncodedMetadataSize(file.path.string().size()), false, true};
+    if (write_index) {
+        WriteIndex({entry}, writer, GetEntrySize(entry));
+    }
+    writer.flush();
+
+    return writer.good() ? CreationResult::kSuccess : CreationResult::kWriteError;
+}
+
+bool HamArchiver::PrepareAppend(std::filesystem::path arcfile, std::vector<IndexEntry>& entries, 
+    size_t& entries_end) {
+
+    InvalidateCache(arcfile);
+    // Оглавление всегда располагается в конце архива: перед дозаписью оно удаляется
+    size_t arc_size = file_operator->GetFileSize(arcfile);
+    entries_end = arc_size;
+    bool complete = false;
+    {
+        FileStream reader;
+        file_operator->OpenForReading(arcfile, reader, std::ifstream::binary);
+        size_t body_size;
+        if (ReadIndexTrailer(reader, arc_size, entries_end, body_size) && write_index) {
+            complete = ReadIndexBody(reader, entries_end, body_size, entries);
+        }
+        if (!complete && write_index) {
+            entries.clear();
+            complete = ScanEntries(reader, entries_end, entries);
+        }
+    }
+    if (entries_end != arc_size) {
+        file_operator->ResizeFile(arcfile, entries_end);
+    }
+
+    return complete;
+}
+
+std::vector<HamArchiver::ConcatenationResult> HamArchiver::Merge(std::string_view arcname,
+        const std::vector<std::string>& arcfiles) {
+
+    Metrics::PhaseTimer timer(metrics, Metrics::Phase::kMerge);
+    
+    if (arcfiles.empty()) {
+        return {ConcatenationResult::kEmptyFileList};
+    }
+    if (file_operator->FileExists(arcname)) {
+        return {ConcatenationResult::kArcAlreadyExists};
+    }
+    std::vector<ConcatenationResult> res(arcfiles.size(), ConcatenationResult::kFileNotFound);
+    std::vector<IndexEntry> merged_entries;
+    // Оглавления исходных архивов не копируются: данные каждого архива 
+    // занимают в итоговом участок [offsets[i], offsets[i] + sizes[i])
+    std::vector<size_t> offsets(arcfiles.size(), 0);
+    std::vector<size_t> sizes(arcfiles.size(), 0);
+    bool all_complete = true;
+    size_t offset = 0;
+    for (size_t i = 0; i < arcfiles.size(); ++i) {
+        if (!file_operator->FileExists(arcfiles[i])) {
+            continue;
+        }
+        MappedFile mapping;
+        MemoryStream memory_reader;
+        FileStream file_reader;
+        std::istream& reader = OpenArchive(arcfiles[i], mapping, memory_reader, file_reader);
+        size_t entries_end;
+        bool complete;
+        std::vector<IndexEntry> entries = LoadEntries(
+            reader, file_operator->GetFileSize(arcfiles[i]), entries_end, complete);
+        for (size_t j = 0; j < entries.size(); ++j) {
+            entries[j].offset += offset;
+            entries[j].content_offset += offset;
+            merged_entries.push_back(entries[j]);
+        }
+        all_complete = all_complete && complete;
+        offsets[i] = offset;
+        sizes[i] = entries_end;
+        offset += entries_end;
+        res[i] = ConcatenationResult::kSuccess;
+    }
+
+    file_operator->CreateFile(arcname);
+    file_operator->ResizeFile(arcname, offset);
+    std::atomic<size_t> next_arcfile{0};
+    std::atomic<bool> copy_failed{false};
+    auto copy_arcfiles = [this, &arcname, &arcfiles, &offsets, &sizes, &next_arcfile, &copy_failed] {
+        for (size_t i = next_arcfile++; i < arcfiles.size(); i = next_arcfile++) {
+            if (sizes[i] == 0) {
+                continue;
+            }
+            if (!file_operator->CopyRange(arcfiles[i], 0, arcname, offsets[i], sizes[i])) {
+                copy_failed = true;
+                continue;
+            }
+            metrics.Add(Metrics::Counter::kBytesCopied, sizes[i]);
+        }
+    };
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < std::min(threads_count, arcfiles.size()); ++i) {
+        workers.emplace_back(copy_arcfiles);
+    }
+    copy_arcfiles();
+    for (size_t i = 0; i < workers.size(); ++i) {
+        workers[i].join();
+    }
+    // Нескопированный участок остался бы заполненным нулями
+    if (copy_failed) {
+        file_operator->DeleteFile(arcname);
+        return {ConcatenationResult::kWriteError};
+    }
+
+    if (write_index && all_complete) {
+        FileStream writer;
+        file_operator->OpenForWriting(arcname, writer, std::ofstream::app | std::ofstream::binary);
+        WriteIndex(merged_entries, writer, offset);
+    }
+
+    return res;
+}
+
+
+HamArchiver::ExtractionResult HamArchiver::ExtractFile(
+    const IndexEntry& entry, std::istream& stream, bool forced, uint64_t archive_id) {
+    
+    const FileMetadata& metadata = entry.metadata;
+    if (metadata.size == 0) {
+        return file_operator->CreateFile(metadata.path.filename()) 
+            ? ExtractionResult::kSuccess : ExtractionResult::kFileCorrupted;
+    }
+    std::streampos start_pos = stream.tellg();
+    std::filesystem::path filename = metadata.path.filename();
+    std::filesystem::path partial = GetPartialPath(filename);
+    FileStream writer;
+    if (!file_operator->OpenForWriting(partial, writer, std::ofstream::trunc | std::ofstream::binary)) {
+        return ExtractionResult::kFileCorrupted;
+    }
+    ExtractionResult exit_code = DecodeEntry(entry, stream, forced, 
+        [&writer](const uint8_t* data, size_t size) {
+            writer.write(reinterpret_cast<const char*>(data), size);
+            return writer.good();
+        }, archive_id);
+    writer.Close();
+    if (!writer.good()) {
+        exit_code = ExtractionResult::kFileCorrupted;
+    }
+
+    if (exit_code == ExtractionResult::kSuccess || forced) {
+        file_operator->RenameFile(partial, filename);
+    } else {
+        // Частично записанный файл удаляется, поток переходит к следующей записи
+        file_operator->DeleteFile(partial);
+        stream.clear();
+        metrics.Add(Metrics::Counter::kSeeks, 1);
+        stream.seekg(start_pos + static_cast<std::streampos>(GetEncodedContentSize(entry)), 
+            std::istream::beg);
+    }
+
+    return exit_code;
+}
+
+HamArchiver::ExtractionResult HamArchiver::DecodeEntry(
+    const IndexEntry& entry, std::istream& stream, bool forced, const ByteSink& sink, 
+    uint64_t archive_id) {
+
+    const FileMetadata& metadata = entry.metadata;
+    if (!entry.streamed) {
+        return DecodeContent(metadata.size, metadata.encoding_block_size, stream, forced, sink, 
+            archive_id);
+    }
+    size_t chunk_size = GetStreamChunkSize(metadata.encoding_block_size);
+    ExtractionResult exit_code = ExtractionResult::kSuccess;
+    for (size_t i = 0; i < metadata.size; i += chunk_size) {
+        // Размеры порций следуют из размера файла, поэтому заголовки лишь пропускаются
+        metrics.Add(Metrics::Counter::kSeeks, 1);
+        stream.seekg(GetEncodedMsgSize(kChunkHeaderSize), std::istream::cur);
+        ExtractionResult chunk_code = DecodeContent(std::min(chunk_size, metadata.size - i), 
+            metadata.encoding_block_size, stream, forced, sink, archive_id);
+        if (chunk_code != ExtractionResult::kSuccess) {
+            exit_code = chunk_code;
+            if (!forced || !stream.good()) {
+                break;
+            }
+        }
+    }
+
+    return exit_code;
+}
+
+HamArchiver::ExtractionResult HamArchiver::DecodeContent(size_t size, size_t block_size, 
+    std::istream& stream, bool forced, const ByteSink& sink, uint64_t archive_id) {
+
+    if (size == 0) {
+        return ExtractionResult::kSuccess;
+    }
+    FileMetadata metadata{std::filesystem::path{}, size, block_size};
+    // Каждый блок проверяется, исправляется в памяти и сразу передаётся 
+    // получателю, поэтому архив читается за один проход
+    size_t full_blocks = metadata.size / metadata.encoding_block_size;
+    decoder_context.Reserve(metadata.encoding_block_size);
+    uint8_t* buf = decoder_context.GetEncodedBuffer();
+    uint8_t* fix_buf = decoder_context.GetFixBuffer();
+    // Блоки из кэша не читаются: поток перемещается только перед следующим прочитанным блоком
+    size_t block_offset = archive_id != 0 ? static_cast<size_t>(stream.tellg()) : 0;
+    bool positioned = true;
+    ExtractionResult exit_code = ExtractionResult::kSuccess;
+    for (size_t i = 0; i <= full_blocks; ++i) {
+        size_t cur_block_size = metadata.encoding_block_size;
+        if (i == full_blocks) {
+            size_t last_block_size = metadata.size % metadata.encoding_block_size;
+            if (last_block_size == 0) {
+                break;
+            }
+            cur_block_size = last_block_size;
+        }
+
+        Decoder::ValidationResult cur_block_state = Decoder::ValidationResult::kValid;
+        const uint8_t* decoded = GetCachedBlock(archive_id, block_offset, cur_block_size, fix_buf);
+        if (decoded == nullptr) {
+            if (!positioned) {
+                metrics.Add(Metrics::Counter::kSeeks, 1);
+                stream.seekg(block_offset, std::istream::beg);
+                positioned = true;
+            }
+            const uint8_t* encoded = ReadBytes(stream, GetEncodedMsgSize(cur_block_size), buf);
+            cur_block_state = Decoder::ValidationResult::kDoubleError;
+            if (encoded != nullptr) {
+                decoded = DecodeBlock(encoded, cur_block_size, fix_buf, cur_block_state);
+                CacheBlock(archive_id, block_offset, decoded, cur_block_size, cur_block_state);
+            }
+        } else {
+            positioned = false;
+        }
+        block_offset += GetEncodedMsgSize(cur_block_size);
+        if (cur_block_state == Decoder::ValidationResult::kDoubleError) {
+            exit_code = ExtractionResult::kFileCorrupted;
+        }
+        if (decoded == nullptr || (exit_code != ExtractionResult::kSuccess && !forced)) {
+            break;
+        }
+        if (!sink(decoded, cur_block_size)) {
+            return ExtractionResult::kFileCorrupted;
+        }
+        metrics.Add(Metrics::Counter::kRawBytes, cur_block_size);
+        metrics.Add(Metrics::Counter::kEncodedBytes, GetEncodedMsgSize(cur_block_size));
+    }
+    if (!positioned) {
+        metrics.Add(Metrics::Counter::kSeeks, 1);
+        stream.seekg(block_offset, std::istream::beg);
+    }
+
+    return exit_code;
+}
+
+std::vector<HamArchiver::ExtractionResult> HamArchiver::ExtractEntries(
+    std::filesystem::path arcfile, const std::vector<IndexEntry>& entries, const MappedFile& mapping, 
+    uint64_t archive_id) {
+
+    std::vector<ExtractionState> states(entries.size());
+    std::vector<ExtractionTask> tasks;
+    size_t max_chunk_size = 0;
+    size_t max_block_size = 0;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const FileMetadata& metadata = entries[i].metadata;
+        states[i].entry = entries[i];
+        states[i].corrupted = false;
+        states[i].archive_id = archive_id;
+        if (metadata.size == 0) {
+            states[i].chunks_left = 1;
+            tasks.push_back(ExtractionTask{i, 0, 0});
+            continue;
+        }
+        size_t blocks_total = (metadata.size + metadata.encoding_block_size - 1) 
+            / metadata.encoding_block_size;
+        size_t chunk_blocks = std::max(kExtractionChunkSize / metadata.encoding_block_size, 
+            static_cast<size_t>(1));
+        chunk_blocks = std::min(chunk_blocks, blocks_total);
+        states[i].chunks_left = (blocks_total + chunk_blocks - 1) / chunk_blocks;
+        for (size_t j = 0; j < blocks_total; j += chunk_blocks) {
+            tasks.push_back(ExtractionTask{i, j, std::min(chunk_blocks, blocks_total - j)});
+        }
+        max_chunk_size = std::max(max_chunk_size, 
+            chunk_blocks * GetEncodedMsgSize(metadata.encoding_block_size));
+        max_block_size = std::max(max_block_size, metadata.encoding_block_size);
+        mapping.Advise(entries[i].content_offset, 
+            GetEncodedMsgSize(metadata.size, metadata.encoding_block_size), 
+            MappedFile::AccessPattern::kWillNeed);
+    }
+
+    size_t workers_count = std::min(threads_count, tasks.size());
+    WorkStealingQueue<ExtractionTask> queue(workers_count);
+    // Соседние части попадают к разным потокам, чтобы большой файл сразу делился между ними
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        queue.Push(i % workers_count, tasks[i]);
+    }
+
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < workers_count; ++i) {
+        workers.emplace_back([this, i, &arcfile, &queue, &states, &mapping, 
+            max_chunk_size, max_block_size] {
+
+            // Отображение общее для всех потоков, позиция чтения - своя
+            MemoryStream memory_reader;
+            FileStream file_reader;
+            uint8_t* buf = nullptr;
+            if (mapping.IsOpen()) {
+                memory_reader.SetData(mapping.GetData(), mapping.GetSize());
+            } else {
+                file_operator->OpenForReading(arcfile, file_reader, std::ifstream::binary);
+                buf = new uint8_t[max_chunk_size];
+            }
+            std::istream& stream = mapping.IsOpen() 
+                ? static_cast<std::istream&>(memory_reader) : file_reader;
+            uint8_t* fix_buf = new uint8_t[max_block_size];
+            ExtractionTask task;
+            while (queue.Pop(i, task)) {
+                ExtractChunk(task, states[task.entry], stream, buf, fix_buf);
+            }
+            delete [] buf;
+            delete [] fix_buf;
+        });
+    }
+    for (size_t i = 0; i < workers.size(); ++i) {
+        workers[i].join();
+    }
+
+    std::vector<ExtractionResult> res(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        res[i] = states[i].corrupted ? ExtractionResult::kFileCorrupted : ExtractionResult::kSuccess;
+    }
+
+    return res;
+}
+
+void HamArchiver::ExtractChunk(const ExtractionTask& task, ExtractionState& state, 
+    std::istream& stream, uint8_t* buf, uint8_t* fix_buf) {
+
+    const FileMetadata& metadata = state.entry.metadata;
+    std::filesystem::path filename = metadata.path.filename();
+    std::filesystem::path partial = GetPartialPath(filename);
+    std::call_once(state.created, [this, &state, &partial, &metadata] {
+        if (!file_operator->CreateFile(partial)) {
+            state.corrupted = true;
+        } else if (metadata.size != 0) {
+            file_operator->ResizeFile(partial, metadata.size);
+        }
+    });
+
+    if (task.blocks_count != 0 && !state.corrupted) {
+        size_t block_size = metadata.encoding_block_size;
+        size_t encoded_block_size = GetEncodedMsgSize(block_size);
+        size_t raw_begin = task.first_block * block_size;
+        size_t raw_size = std::min(task.blocks_count * block_size, metadata.size - raw_begin);
+        stream.clear();
+        metrics.Add(Metrics::Counter::kSeeks, 1);
+        stream.seekg(state.entry.content_offset + task.first_block * encoded_block_size, 
+            std::istream::beg);
+        const uint8_t* chunk = ReadBytes(stream, GetEncodedMsgSize(raw_size, block_size), buf);
+
+        if (chunk == nullptr) {
+            state.corrupted = true;
+        } else {
+            FileStream writer;
+            file_operator->Open(partial, writer, std::fstream::in | std::fstream::out | std::fstream::binary);
+            metrics.Add(Metrics::Counter::kSeeks, 1);
+            writer.seekp(raw_begin, std::fstream::beg);
+            for (size_t i = 0; i < task.blocks_count; ++i) {
+                size_t cur_block_size = std::min(block_size, raw_size - i * block_size);
+                // Часть уже прочитана целиком, кэш лишь избавляет от проверки блока
+                size_t block_offset = state.entry.content_offset 
+                    + (task.first_block + i) * encoded_block_size;
+                const uint8_t* decoded = GetCachedBlock(state.archive_id, block_offset, 
+                    cur_block_size, fix_buf);
+                if (decoded == nullptr) {
+                    Decoder::ValidationResult cur_block_state;
+                    decoded = DecodeBlock(chunk + i * encoded_block_size, 
+                        cur_block_size, fix_buf, cur_block_state);
+                    if (cur_block_state == Decoder::ValidationResult::kDoubleError) {
+                        state.corrupted = true;
+                        break;
+                    }
+                    CacheBlock(state.archive_id, block_offset, decoded, cur_block_size, cur_block_state);
+                }
+                writer.write(reinterpret_cast<const char*>(decoded), cur_block_size);
+                metrics.Add(Metrics::Counter::kRawBytes, cur_block_size);
+                metrics.Add(Metrics::Counter::kEncodedBytes, GetEncodedMsgSize(cur_block_size));
+            }
+            writer.Close();
+            if (!writer.good()) {
+                state.corrupted = true;
+            }
+        }
+    }
+
+    // Последняя обработанная часть заменяет файл извлечённым либо удаляет повреждённый
+    if (--state.chunks_left == 0) {
+        if (state.corrupted) {
+            file_operator->DeleteFile(partial);
+        } else {
+            file_operator->RenameFile(partial, filename);
+        }
+    }
+}
+
+std::filesystem::path HamArchiver::GetPartialPath(const std::filesystem::path& filename) {
+    std::filesystem::path partial = filename;
+    partial += ".hamarc-part";
+
+    return partial;
+}
+
+std::istream& HamArchiver::OpenArchive(std::filesystem::path arcfile, MappedFile& mapping, 
+    MemoryStream& memory_reader, FileStream& file_reader) {
+
+    if (file_operator->OpenMapped(arcfile, mapping)) {
+        memory_reader.SetData(mapping.GetData(), mapping.GetSize());
+        return memory_reader;
+    }
+    file_operator->OpenForReading(arcfile, file_reader, std::ifstream::binary);
+
+    return file_reader;
+}
+
+const uint8_t* HamArchiver::ReadBytes(std::istream& stream, size_t size, uint8_t* buf) {
+    MemoryStream* memory_reader = dynamic_cast<MemoryStream*>(&stream);
+    if (memory_reader != nullptr) {
+        return memory_reader->ReadSpan(size);
+    }
+    stream.read(reinterpret_cast<char*>(buf), size);
+    CountRead(stream);
+
+    return static_cast<size_t>(stream.gcount()) == size ? buf : nullptr;
+}
+
+const uint8_t* HamArchiver::DecodeBlock(const uint8_t* encoded, size_t block_size, 
+    uint8_t* fix_buf, Decoder::ValidationResult& result) {
+
+    size_t error_bit;
+    result = Decoder::Validate(encoded, block_size, encoded + block_size, error_bit);
+    CountValidation(result);
+    if (error_bit == Decoder::kNoDataError) {
+        return encoded;
+    }
+    std::memcpy(fix_buf, encoded, block_size);
+    BitOperator::FlipBit(fix_buf[error_bit / 8], error_bit % 8);
+
+    return fix_buf;
+}
+
+uint64_t HamArchiver::GetCacheId(std::filesystem::path arcfile) {
+    if (!block_cache.IsEnabled()) {
+        return 0;
+    }
+
+    return block_cache.GetArchiveId(file_operator->GetPath(arcfile), 
+        file_operator->GetFileSize(arcfile), file_operator->GetLastWriteTime(arcfile));
+}
+
+void HamArchiver::InvalidateCache(std::filesystem::path arcfile) {
+    if (block_cache.IsEnabled()) {
+        block_cache.Invalidate(file_operator->GetPath(arcfile));
+    }
+}
+
+const uint8_t* HamArchiver::GetCachedBlock(uint64_t archive_id, size_t block_offset, 
+    size_t block_size, uint8_t* fix_buf) {
+
+    if (archive_id == 0) {
+        return nullptr;
+    }
+    if (!block_cache.Get(archive_id, block_offset, fix_buf, block_size)) {
+        metrics.Add(Metrics::Counter::kCacheMisses, 1);
+        return nullptr;
+    }
+    metrics.Add(Metrics::Counter::kCacheHits, 1);
+
+    return fix_buf;
+}
+
+void HamArchiver::CacheBlock(uint64_t archive_id, size_t block_offset, const uint8_t* block, 
+    size_t block_size, Decoder::ValidationResult result) {
+
+    if (archive_id != 0 && result != Decoder::ValidationResult::kDoubleError) {
+        block_cache.Put(archive_id, block_offset, block, block_size);
+    }
+}
+
+void HamArchiver::CountRead(std::istream& stream) {
+    // Чтение из отображённого в память архива не обращается к файлу
+    if (metrics.IsEnabled() && dynamic_cast<MemoryStream*>(&stream) == nullptr) {
+        metrics.Add(Metrics::Counter::kReads, 1);
+    }
+}
+
+void HamArchiver::CountValidation(Decoder::ValidationResult result) {
+    metrics.Add(Metrics::Counter::kBlocksValidated, 1);
+    if (result == Decoder::ValidationResult::kSingleErrorFixed) {
+        metrics.Add(Metrics::Counter::kSingleErrorsFixed, 1);
+    } else if (result == Decoder::ValidationResult::kDoubleError) {
+        metrics.Add(Metrics::Counter::kDoubleErrors, 1);
+    }
+}
+
+void HamArchiver::CountEncodedFile(const FileMetadata& file) {
+    if (file.size == 0) {
+        return;
+    }
+    metrics.Add(Metrics::Counter::kRawBytes, file.size);
+    metrics.Add(Metrics::Counter::kEncodedBytes, GetEncodedMsgSize(file.size, file.encoding_block_size));
+    metrics.Add(Metrics::Counter::kBlocksEncoded, 
+        (file.size + file.encoding_block_size - 1) / file.encoding_block_size);
+}
+
+HamArchiver::FileMetadata HamArchiver::GetMetadata(std::istream& stream, bool& deleted, bool& streamed) {
+    size_t encoded_numeric_size = GetEncodedMsgSize(kNumericMetadataSize);
+    decoder_context.Reserve(kNumericMetadataSize);
+    const uint8_t* encoded = ReadBytes(stream, encoded_numeric_size, decoder_context.GetEncodedBuffer());
+    Decoder::ValidationResult numeric_state = Decoder::ValidationResult::kDoubleError;
+    const uint8_t* numeric_metadata = nullptr;
+    if (encoded != nullptr) {
+        numeric_metadata = DecodeBlock(encoded, kNumericMetadataSize, 
+            decoder_context.GetFixBuffer(), numeric_state);
+    }
+    if (numeric_state == Decoder::ValidationResult::kDoubleError) {
+        return FileMetadata{
+            std::filesystem::path{}, 
+            static_cast<size_t>(-1), 
+            static_cast<size_t>(-1)
+        };
+    }
+    HamArchiver::FileMetadata file{std::filesystem::path{}, 0, 0};
+    size_t filename_size = LoadNumber(numeric_metadata, 4);
+    deleted = (filename_size & kDeletedFlag) != 0;
+    streamed = (filename_size & kStreamedFlag) != 0;
+    filename_size &= ~(kDeletedFlag | kStreamedFlag);
+    file.size = LoadNumber(numeric_metadata + 4, 8);
+    file.encoding_block_size = LoadNumber(numeric_metadata + 12, 8);
+
+    size_t encoded_filename_size = GetEncodedMsgSize(filename_size);
+    decoder_context.Reserve(filename_size);
+    encoded = ReadBytes(stream, encoded_filename_size, decoder_context.GetEncodedBuffer());
+    if (encoded != nullptr) {
+        Decoder::ValidationResult filename_state;
+        const uint8_t* filename = DecodeBlock(encoded, filename_size, 
+            decoder_context.GetFixBuffer(), filename_state);
+        if (filename_state != Decoder::ValidationResult::kDoubleError) {
+            file.path = std::string{reinterpret_cast<const char*>(filename), filename_size};
+        }
+    }
+    
+    return file;
+}
+
+void HamArchiver::WriteEncodedMetadata(FileMetadata file, std::ostream& writer, bool streamed) {
+    std::string filename = file.path.filename().string();
+    uint8_t numeric_metadata_buf[kNumericMetadataSize];
+
+    StoreNumber(numeric_metadata_buf, filename.size() | (streamed ? kStreamedFlag : 0), 4);
+    StoreNumber(numeric_metadata_buf + 4, file.size, 8);
+    StoreNumber(numeric_metadata_buf + 12, file.encoding_block_size, 8);
+    
+    writer.write(reinterpret_cast<char*>(numeric_metadata_buf), kNumericMetadataSize);
+    Encoder::EncodeAndWrite(numeric_metadata_buf, writer, kNumericMetadataSize);
+    writer.write(filename.data(), filename.size());
+    Encoder::EncodeAndWrite(reinterpret_cast<uint8_t*>(filename.data()), writer, filename.size());    
+
+}
+
+HamArchiver::AdditionResult HamArchiver::WriteEncodedFile(FileMetadata& file, std::ostream& writer) {
+    if (!file_operator->FileExists(file.path)) {
+        return AdditionResult::kFileNotFound;
+    }
+    file.size = file_operator->GetFileSize(file.path);
+    file.encoding_block_size = std::min(file.size, file.encoding_block_size);
+    FileStream raw_file_reader;
+    if (!file_operator->OpenForReading(file.path, raw_file_reader, std::ifstream::binary)) {
+        return AdditionResult::kFileNotAccessible;
+    }
+    WriteEncodedMetadata(file, writer, false);
+
+    Encoder::EncodingResult encoding_result;
+    if (threads_count > 1 && file.size > file.encoding_block_size) {
+        EncodingPipeline pipeline(threads_count, max_inflight_size);
+        encoding_result = pipeline.Run(raw_file_reader, writer, file.size, file.encoding_block_size);
+    } else {
+        encoding_result = Encoder::EncodeBlocks(raw_file_reader, writer, file.size, 
+            file.encoding_block_size, encoder_context);
+    }
+    if (encoding_result != Encoder::EncodingResult::kSuccess || !writer.good()) {
+        // Запись уже частично в архиве: смещения следующих записей были бы неверны
+        writer.setstate(std::ios::badbit);
+        return AdditionResult::kWriteError;
+    }
+    CountEncodedFile(file);
+    
+    return AdditionResult::kSuccess;
+}
+
+HamArchiver::AdditionResult HamArchiver::WriteEncodedStream(FileMetadata& file, 
+    std::istream& reader, std::ostream& writer) {
+
+    if (file.encoding_block_size == 0 || !reader.good()) {
+        return AdditionResult::kFileNotAccessible;
+    }
+    file.size = 0;
+    WriteEncodedMetadata(file, writer, true);
+
+    // Данные читаются порциями: размер порции записывается перед ней,
+    // поэтому память ограничена размером порции, а длина потока может быть неизвестна
+    size_t chunk_size = GetStreamChunkSize(file.encoding_block_size);
+    uint8_t* chunk = new uint8_t[chunk_size];
+    MemoryStream chunk_reader;
+    size_t cur_chunk_size = chunk_size;
+    while (cur_chunk_size == chunk_size) {
+        reader.read(reinterpret_cast<char*>(chunk), chunk_size);
+        cur_chunk_size = reader.gcount();
+        WriteChunkHeader(cur_chunk_size, writer);
+        if (cur_chunk_size == 0) {
+            break;
+        }
+        chunk_reader.SetData(chunk, cur_chunk_size);
+        Encoder::EncodeBlocks(chunk_reader, writer, cur_chunk_size, file.encoding_block_size, 
+            encoder_context);
+        file.size += cur_chunk_size;
+        metrics.Add(Metrics::Counter::kBlocksEncoded, 
+            (cur_chunk_size + file.encoding_block_size - 1) / file.encoding_block_size);
+    }
+    if (cur_chunk_size != 0) {
+        WriteChunkHeader(0, writer);
+    }
+    delete [] chunk;
+    metrics.Add(Metrics::Counter::kRawBytes, file.size);
+    metrics.Add(Metrics::Counter::kEncodedBytes, 
+        GetEncodedContentSize(IndexEntry{file, 0, 0, false, true}));
+
+    return AdditionResult::kSuccess;
+}
+
+void HamArchiver::WriteChunkHeader(size_t chunk_size, std::ostream& writer) {
+    uint8_t header[kChunkHeaderSize];
+    StoreNumber(header, chunk_size, kChunkHeaderSize);
+    writer.write(reinterpret_cast<char*>(header), kChunkHeaderSize);
+    Encoder::EncodeAndWrite(header, writer, kChunkHeaderSize);
+}
+
+size_t HamArchiver::GetEncodedMetadataSize(size_t filename_size) {
+    return GetEncodedMsgSize(kNumericMetadataSize) + GetEncodedMsgSize(filename_size);
+}
+
+size_t HamArchiver::GetEntrySize(const IndexEntry& entry) {
+    return entry.content_offset - entry.offset + GetEncodedContentSize(entry);
+}
+
+size_t HamArchiver::GetEncodedContentSize(const IndexEntry& entry) {
+    size_t size = entry.metadata.size;
+    size_t block_size = entry.metadata.encoding_block_size;
+    if (!entry.streamed) {
+        return GetEncodedMsgSize(size, block_size);
+    }
+    size_t chunk_size = GetStreamChunkSize(block_size);
+    size_t encoded_header_size = GetEncodedMsgSize(kChunkHeaderSize);
+    size_t content_size = (size / chunk_size) * (encoded_header_size + GetEncodedMsgSize(chunk_size, block_size));
+    if (size % chunk_size != 0) {
+        content_size += encoded_header_size + GetEncodedMsgSize(size % chunk_size, block_size);
+    }
+
+    // Завершающая порция нулевого размера
+    return content_size + encoded_header_size;
+}
+
+size_t HamArchiver::GetStreamChunkSize(size_t block_size) {
+    return block_size * std::max(kStreamChunkSize / block_size, static_cast<size_t>(1));
+}
+
+size_t HamArchiver::GetNameSizeField(const IndexEntry& entry) {
+    return entry.metadata.path.filename().string().size() 
+        | (entry.deleted ? kDeletedFlag : 0) | (entry.streamed ? kStreamedFlag : 0);
+}
+
+void HamArchiver::StoreNumber(uint8_t* buf, size_t value, size_t bytes_count) {
+    for (size_t i = 0; i < bytes_count; ++i) {
+        buf[i] = (value >> (8 * i)) & 0b11111111;
+    }
+}
+
+size_t HamArchiver::LoadNumber(const uint8_t* buf, size_t bytes_count) {
+    size_t value = 0;
+    for (size_t i = 0; i < bytes_count; ++i) {
+        value |= (static_cast<size_t>(buf[i]) << i * 8);
+    }
+
+    return value;
+}
+
+std::vector<HamArchiver::IndexEntry> HamArchiver::LoadEntries(std::istream& stream, 
+    size_t arc_size, size_t& entries_end, bool& complete) {
+
+    Metrics::PhaseTimer timer(metrics, Metrics::Phase::kLoadEntries);
+
+    std::vector<IndexEntry> entries;
+    size_t body_size;
+    if (!ReadIndexTrailer(stream, arc_size, entries_end, body_size)) {
+        entries_end = arc_size;
+    } else if (ReadIndexBody(stream, entries_end, body_size, entries)) {
+        complete = true;
+        return entries;
+    }
+
+    entries.clear();
+    complete = ScanEntries(stream, entries_end, entries);
+
+    return entries;
+}
+
+bool HamArchiver::ScanEntries(std::istream& stream, size_t entries_end, 
+    std::vector<IndexEntry>& entries) {
+
+    stream.clear();
+    metrics.Add(Metrics::Counter::kSeeks, 1);
+    stream.seekg(0, std::istream::beg);
+    size_t offset = 0;
+    while (offset < entries_end) {
+        bool deleted;
+        bool streamed;
+        FileMetadata cur_metadata = GetMetadata(stream, deleted, streamed);
+        if (cur_metadata.size == -1 || !stream.good()) {
+            return false;
+        }
+        IndexEntry entry{cur_metadata, offset, static_cast<size_t>(stream.tellg()), deleted, streamed};
+        if (streamed && !ScanStreamChunks(stream, cur_metadata.encoding_block_size, entry.metadata.size)) {
+            return false;
+        }
+        entries.push_back(entry);
+        offset += GetEntrySize(entry);
+        metrics.Add(Metrics::Counter::kSeeks, 1);
+        stream.seekg(offset, std::istream::beg);
+    }
+
+    return true;
+}
+
+bool HamArchiver::ScanStreamChunks(std::istream& stream, size_t block_size, size_t& data_size) {
+    if (block_size == 0) {
+        return false;
+    }
+    data_size = 0;
+    size_t chunk_size = GetStreamChunkSize(block_size);
+    decoder_context.Reserve(kChunkHeaderSize);
+    while (true) {
+        const uint8_t* encoded = ReadBytes(stream, GetEncodedMsgSize(kChunkHeaderSize), 
+            decoder_context.GetEncodedBuffer());
+        if (encoded == nullptr) {
+            return false;
+        }
+        Decoder::ValidationResult header_state;
+        const uint8_t* header = DecodeBlock(encoded, kChunkHeaderSize, 
+            decoder_context.GetFixBuffer(), header_state);
+        if (header_state == Decoder::ValidationResult::kDoubleError) {
+            return false;
+        }
+        size_t cur_chunk_size = LoadNumber(header, kChunkHeaderSize);
+        if (cur_chunk_size == 0) {
+            return true;
+        }
+        // Неполной может быть только последняя порция с данными
+        if (cur_chunk_size > chunk_size || data_size % chunk_size != 0) {
+            return false;
+        }
+        data_size += cur_chunk_size;
+        metrics.Add(Metrics::Counter::kSeeks, 1);
+        stream.seekg(GetEncodedMsgSize(cur_chunk_size, block_size), std::istream::cur);
+    }
+}
+
+bool HamArchiver::ReadIndexTrailer(std::istream& stream, size_t arc_size, 
+    size_t& index_offset, size_t& body_size) {
+
+    size_t encoded_trailer_size = GetEncodedMsgSize(kIndexTrailerSize);
+    if (arc_size < encoded_trailer_size) {
+        return false;
+    }
+    decoder_context.Reserve(kIndexTrailerSize);
+    uint8_t* trailer = decoder_context.GetEncodedBuffer();
+    stream.clear();
+    metrics.Add(Metrics::Counter::kSeeks, 1);
+    stream.seekg(arc_size - encoded_trailer_size, std::istream::beg);
+    stream.read(reinterpret_cast<char*>(trailer), encoded_trailer_size);
+    CountRead(stream);
+    // Проверка концевика не учитывается в метриках: в архиве без оглавления
+    // на его месте находятся произвольные данные
+    bool valid = stream.good() && Decoder::Validate(trailer, kIndexTrailerSize, 
+        trailer + kIndexTrailerSize) != Decoder::ValidationResult::kDoubleError;
+    for (size_t i = 0; valid && i < sizeof(kIndexMagic); ++i) {
+        valid = trailer[i] == kIndexMagic[i];
+    }
+    size_t trailer_index_offset = LoadNumber(trailer + 8, 8);
+    size_t trailer_body_size = LoadNumber(trailer + 16, 8);
+    valid = valid && trailer_index_offset <= arc_size && trailer_body_size <= arc_size 
+        && trailer_index_offset + GetEncodedMsgSize(trailer_body_size, kIndexBlockSize) 
+        + encoded_trailer_size == arc_size;
+    // Без оглавления выходные параметры не изменяются
+    if (valid) {
+        index_offset = trailer_index_offset;
+        body_size = trailer_body_size;
+    }
+
+    return valid;
+}
+
+bool HamArchiver::ReadIndexBody(std::istream& stream, size_t index_offset, 
+    size_t body_size, std::vector<IndexEntry>& entries) {
+
+    uint8_t* body = new uint8_t[body_size];
+    decoder_context.Reserve(kIndexBlockSize);
+    uint8_t* buf = decoder_context.GetEncodedBuffer();
+    stream.clear();
+    metrics.Add(Metrics::Counter::kSeeks, 1);
+    stream.seekg(index_offset, std::istream::beg);
+    bool valid = true;
+    for (size_t i = 0; valid && i < body_size; i += kIndexBlockSize) {
+        size_t cur_block_size = std::min(kIndexBlockSize, body_size - i);
+        stream.read(reinterpret_cast<char*>(buf), GetEncodedMsgSize(cur_block_size));
+        CountRead(stream);
+        valid = stream.good();
+        if (valid) {
+            Decoder::ValidationResult block_state = Decoder::Validate(
+                buf, cur_block_size, buf + cur_block_size);
+            CountValidation(block_state);
+            valid = block_state != Decoder::ValidationResult::kDoubleError;
+        }
+        std::copy(buf, buf + cur_block_size, body + i);
+    }
+
+    for (size_t pos = 0; valid && pos < body_size;) {
+        if (body_size - pos < kIndexRecordHeaderSize) {
+            valid = false;
+            break;
+        }
+        IndexEntry entry{FileMetadata{std::filesystem::path{}, 0, 0}, 0, 0};
+        entry.offset = LoadNumber(body + pos, 8);
+        entry.metadata.size = LoadNumber(body + pos + 8, 8);
+        entry.metadata.encoding_block_size = LoadNumber(body + pos + 16, 8);
+        size_t filename_size = LoadNumber(body + pos + 24, 4);
+        entry.deleted = (filename_size & kDeletedFlag) != 0;
+        entry.streamed = (filename_size & kStreamedFlag) != 0;
+        filename_size &= ~(kDeletedFlag | kStreamedFlag);
+        pos += kIndexRecordHeaderSize;
+        if (body_size - pos < filename_size) {
+            valid = false;
+            break;
+        }
+        entry.metadata.path = std::string{reinterpret_cast<char*>(body + pos), filename_size};
+        pos += filename_size;
+        // Смещение проверяется до сложения, чтобы content_offset не переполнялся
+        valid = entry.offset <= index_offset;
+        entry.content_offset = entry.offset + GetEncodedMetadataSize(filename_size);
+        valid = valid && entry.content_offset <= index_offset 
+            && GetEntrySize(entry) <= index_offset - entry.offset;
+        entries.push_back(entry);
+    }
+    delete [] body;
+
+    return valid;
+}
+
+void HamArchiver::WriteIndex(const std::vector<IndexEntry>& entries, 
+    std::ostream& writer, size_t index_offset) {
+
+    std::string body;
+    std::vector<size_t> record_offsets;
+    if (!BuildIndexBody(entries, body, record_offsets) || body.empty()) {
+        return;
+    }
+
+    for (size_t i = 0; i < body.size(); i += kIndexBlockSize) {
+        size_t cur_block_size = std::min(kIndexBlockSize, body.size() - i);
+        writer.write(body.data() + i, cur_block_size);
+        Encoder::EncodeAndWrite(
+            reinterpret_cast<const uint8_t*>(body.data() + i), writer, cur_block_size);
+    }
+
+    uint8_t trailer[kIndexTrailerSize];
+    std::copy(kIndexMagic, kIndexMagic + sizeof(kIndexMagic), trailer);
+    StoreNumber(trailer + 8, index_offset, 8);
+    StoreNumber(trailer + 16, body.size(), 8);
+    writer.write(reinterpret_cast<char*>(trailer), kIndexTrailerSize);
+    Encoder::EncodeAndWrite(trailer, writer, kIndexTrailerSize);
+}
+
+bool HamArchiver::BuildIndexBody(const std::vector<IndexEntry>& entries, std::string& body, 
+    std::vector<size_t>& record_offsets) {
+
+    // Записи с повреждёнными именами не могут быть описаны в оглавлении
+    for (size_t i = 0; i < entries.size(); ++i) {
+        std::string filename = entries[i].metadata.path.filename().string();
+        if (entries[i].content_offset - entries[i].offset != GetEncodedMetadataSize(filename.size())) {
+            return false;
+        }
+        uint8_t header[kIndexRecordHeaderSize];
+        StoreNumber(header, entries[i].offset, 8);
+        StoreNumber(header + 8, entries[i].metadata.size, 8);
+        StoreNumber(header + 16, entries[i].metadata.encoding_block_size, 8);
+        StoreNumber(header + 24, GetNameSizeField(entries[i]), 4);
+        record_offsets.push_back(body.size());
+        body.append(reinterpret_cast<char*>(header), kIndexRecordHeaderSize);
+        body.append(filename);
+    }
+
+    return true;
+}
+
+void HamArchiver::WriteDeletedMetadata(const IndexEntry& entry, std::ostream& writer) {
+    uint8_t numeric_metadata[kNumericMetadataSize];
+    IndexEntry deleted_entry = entry;
+    deleted_entry.deleted = true;
+    StoreNumber(numeric_metadata, GetNameSizeField(deleted_entry), 4);
+    // В метаданных потокового файла размер не указывается
+    StoreNumber(numeric_metadata + 4, entry.streamed ? 0 : entry.metadata.size, 8);
+    StoreNumber(numeric_metadata + 12, entry.metadata.encoding_block_size, 8);
+    metrics.Add(Metrics::Counter::kSeeks, 1);
+    writer.seekp(entry.offset, std::ostream::beg);
+    writer.write(reinterpret_cast<char*>(numeric_metadata), kNumericMetadataSize);
+    Encoder::EncodeAndWrite(numeric_metadata, writer, kNumericMetadataSize);
+}
+
+bool HamArchiver::CompactEntries(std::filesystem::path arcfile, 
+    std::filesystem::path checkpoint_file, const std::vector<IndexEntry>& entries,
+    VacuumCheckpoint checkpoint, uint8_t* buf, size_t& entries_end) {
+
+    FileStream stream;
+    if (!file_operator->Open(arcfile, stream, std::fstream::in | std::fstream::out | std::fstream::binary)) {
+        return false;
+    }
+    if (checkpoint.pending_size != 0) {
+        // Порция, запись которой была прервана, берётся из контрольной точки
+        metrics.Add(Metrics::Counter::kSeeks, 1);
+        stream.seekp(checkpoint.dst, std::fstream::beg);
+        stream.write(reinterpret_cast<char*>(buf), checkpoint.pending_size);
+        if (!stream.SyncToDevice()) {
+            return false;
+        }
+        checkpoint.src += checkpoint.pending_size;
+        checkpoint.dst += checkpoint.pending_size;
+        checkpoint.pending_size = 0;
+        if (!WriteVacuumCheckpoint(checkpoint_file, checkpoint, nullptr)) {
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < entries.size();) {
+        if (entries[i].deleted) {
+            ++i;
+            continue;
+        }
+        // Подряд идущие неудалённые файлы переносятся одним участком
+        size_t run_begin = entries[i].offset;
+        size_t run_end = run_begin;
+        for (; i < entries.size() && !entries[i].deleted; ++i) {
+            run_end = entries[i].offset + GetEntrySize(entries[i]);
+        }
+        if (run_end <= checkpoint.src) {
+            continue;
+        }
+        checkpoint.src = std::max(checkpoint.src, run_begin);
+
+        while (checkpoint.src < run_end) {
+            size_t cur_size = std::min(kVacuumBufferSize, run_end - checkpoint.src);
+            metrics.Add(Metrics::Counter::kSeeks, 1);
+            stream.seekg(checkpoint.src, std::fstream::beg);
+            stream.read(reinterpret_cast<char*>(buf), cur_size);
+            metrics.Add(Metrics::Counter::kReads, 1);
+            if (static_cast<size_t>(stream.gcount()) != cur_size) {
+                return false;
+            }
+            // Если порция перекрывает свой источник, повторить её после сбоя 
+            // можно только по копии в контрольной точке
+            if (checkpoint.dst + cur_size > checkpoint.src) {
+                checkpoint.pending_size = cur_size;
+                if (!WriteVacuumCheckpoint(checkpoint_file, checkpoint, buf)) {
+                    return false;
+                }
+            }
+            metrics.Add(Metrics::Counter::kSeeks, 1);
+            stream.seekp(checkpoint.dst, std::fstream::beg);
+            stream.write(reinterpret_cast<char*>(buf), cur_size);
+            // Контрольная точка продвигается только после сохранения порции на устройстве
+            if (!stream.SyncToDevice()) {
+                return false;
+            }
+            checkpoint.src += cur_size;
+            checkpoint.dst += cur_size;
+            checkpoint.pending_size = 0;
+            if (!WriteVacuumCheckpoint(checkpoint_file, checkpoint, nullptr)) {
+                return false;
+            }
+            metrics.Add(Metrics::Counter::kBytesCopied, cur_size);
+        }
+    }
+
+    checkpoint.src = checkpoint.entries_end;
+    entries_end = checkpoint.dst;
+
+    return WriteVacuumCheckpoint(checkpoint_file, checkpoint, nullptr);
+}
+
+bool HamArchiver::ReadVacuumCheckpoint(std::filesystem::path checkpoint_file, 
+    VacuumCheckpoint& checkpoint, uint8_t* pending) {
+
+    const size_t header_size = 8 * 4;
+    size_t encoded_header_size = GetEncodedMsgSize(header_size);
+    uint8_t* header = new uint8_t[encoded_header_size];
+    FileStream reader;
+    file_operator->OpenForReading(checkpoint_file, reader, std::ifstream::binary);
+    reader.read(reinterpret_cast<char*>(header), encoded_header_size);
+    bool valid = reader.good() && Decoder::Validate(header, header_size, header + header_size) 
+        != Decoder::ValidationResult::kDoubleError;
+    checkpoint.entries_end = LoadNumber(header, 8);
+    checkpoint.src = LoadNumber(header + 8, 8);
+    checkpoint.dst = LoadNumber(header + 16, 8);
+    checkpoint.pending_size = LoadNumber(header + 24, 8);
+    delete [] header;
+    if (!valid || checkpoint.pending_size > kVacuumBufferSize 
+        || checkpoint.dst > checkpoint.src || checkpoint.src > checkpoint.entries_end) {
+
+        return false;
+    }
+    reader.read(reinterpret_cast<char*>(pending), checkpoint.pending_size);
+
+    return static_cast<size_t>(reader.gcount()) == checkpoint.pending_size;
+}
+
+bool HamArchiver::WriteVacuumCheckpoint(std::filesystem::path checkpoint_file, 
+    const VacuumCheckpoint& checkpoint, const uint8_t* pending) {
+
+    uint8_t header[8 * 4];
+    StoreNumber(header, checkpoint.entries_end, 8);
+    StoreNumber(header + 8, checkpoint.src, 8);
+    StoreNumber(header + 16, checkpoint.dst, 8);
+    StoreNumber(header + 24, checkpoint.pending_size, 8);
+    std::filesystem::path tmp = checkpoint_file;
+    tmp += ".tmp";
+    {
+        FileStream writer;
+        if (!file_operator->OpenForWriting(tmp, writer, std::ofstream::trunc | std::ofstream::binary)) {
+            return false;
+        }
+        writer.write(reinterpret_cast<char*>(header), sizeof(header));
+        Encoder::EncodeAndWrite(header, writer, sizeof(header));
+        if (pending != nullptr) {
+            writer.write(reinterpret_cast<const char*>(pending), checkpoint.pending_size);
+        }
+        // Иначе после сбоя переименованная контрольная точка может оказаться пустой
+        if (!writer.SyncToDevice()) {
+            return false;
+        }
+    }
+    file_operator->RenameFile(tmp, checkpoint_file);
+
+    return file_operator->SyncDir(checkpoint_file.parent_path());
 }
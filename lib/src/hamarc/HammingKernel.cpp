@@ -0,0 +1,362 @@
+#include <cstdlib>
+#include <cstring>
+
+#include "HammingKernel.hpp"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+bool HammingKernel::Select(Type type) {
+    if (type == Type::kAuto) {
+        type = GetBestSupported();
+    }
+    if (!IsSupported(type)) {
+        return false;
+    }
+    GetActiveKernels().store(&GetKernelSet(type), std::memory_order_release);
+
+    return true;
+}
+
+HammingKernel::Type HammingKernel::GetActive() {
+    return GetKernels().type;
+}
+
+bool HammingKernel::IsSupported(Type type) {
+    switch (type) {
+        case Type::kAuto:
+        case Type::kScalar:
+            return true;
+#if defined(__GNUC__) && defined(__x86_64__)
+        case Type::kSSE42:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt");
+        case Type::kAVX2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+        case Type::kAVX512:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+#endif
+        default:
+            return false;
+    }
+}
+
+const char* HammingKernel::GetName(Type type) {
+    switch (type) {
+        case Type::kScalar:
+            return "scalar";
+        case Type::kSSE42:
+            return "sse4.2";
+        case Type::kAVX2:
+            return "avx2";
+        case Type::kAVX512:
+            return "avx512";
+        default:
+            return "auto";
+    }
+}
+
+void HammingKernel::AccumulateRun(const uint8_t* words, size_t count, size_t first_window,
+    uint64_t low_mask, uint64_t& run_word, size_t& window_xor) {
+
+    GetKernels().accumulate_run(words, count, first_window, low_mask, run_word, window_xor);
+}
+
+uint8_t HammingKernel::XorBytes(const uint8_t* data, size_t size) {
+    return GetKernels().xor_bytes(data, size);
+}
+
+const HammingKernel::Kernels& HammingKernel::GetKernels() {
+    return *GetActiveKernels().load(std::memory_order_acquire);
+}
+
+std::atomic<const HammingKernel::Kernels*>& HammingKernel::GetActiveKernels() {
+    static std::atomic<const Kernels*> active(&GetKernelSet(GetDefaultType()));
+    return active;
+}
+
+const HammingKernel::Kernels& HammingKernel::GetKernelSet(Type type) {
+    // Наборы создаются один раз при первом обращении (инициализация потокобезопасна)
+    static const Kernels kSets[] = {MakeKernels(Type::kScalar), MakeKernels(Type::kSSE42), 
+        MakeKernels(Type::kAVX2), MakeKernels(Type::kAVX512)};
+    switch (type) {
+        case Type::kSSE42:
+            return kSets[1];
+        case Type::kAVX2:
+            return kSets[2];
+        case Type::kAVX512:
+            return kSets[3];
+        default:
+            return kSets[0];
+    }
+}
+
+HammingKernel::Type HammingKernel::GetBestSupported() {
+    const Type kPreferred[] = {Type::kAVX512, Type::kAVX2, Type::kSSE42};
+    for (Type type : kPreferred) {
+        if (IsSupported(type)) {
+            return type;
+        }
+    }
+
+    return Type::kScalar;
+}
+
+HammingKernel::Type HammingKernel::GetDefaultType() {
+    const char* forced = std::getenv("HAMARC_KERNEL");
+    if (forced != nullptr) {
+        const Type kTypes[] = {Type::kScalar, Type::kSSE42, Type::kAVX2, Type::kAVX512};
+        for (Type type : kTypes) {
+            if (std::strcmp(forced, GetName(type)) == 0 && IsSupported(type)) {
+                return type;
+            }
+        }
+    }
+
+    return GetBestSupported();
+}
+
+HammingKernel::Kernels HammingKernel::MakeKernels(Type type) {
+    switch (type) {
+#if defined(__GNUC__) && defined(__x86_64__)
+        case Type::kSSE42:
+            return Kernels{type, AccumulateRunSSE42, XorBytesSSE42};
+        case Type::kAVX2:
+            return Kernels{type, AccumulateRunAVX2, XorBytesAVX2};
+        case Type::kAVX512:
+            return Kernels{type, AccumulateRunAVX512, XorBytesAVX512};
+#endif
+        default:
+            return Kernels{Type::kScalar, AccumulateRunScalar, XorBytesScalar};
+    }
+}
+
+uint64_t HammingKernel::LoadWord(const uint8_t* bytes) {
+    return (static_cast<uint64_t>(bytes[0]) << 56) | (static_cast<uint64_t>(bytes[1]) << 48) |
+    (static_cast<uint64_t>(bytes[2]) << 40) | (static_cast<uint64_t>(bytes[3]) << 32) |
+    (static_cast<uint64_t>(bytes[4]) << 24) | (static_cast<uint64_t>(bytes[5]) << 16) |
+    (static_cast<uint64_t>(bytes[6]) << 8) | static_cast<uint64_t>(bytes[7]);
+}
+
+bool HammingKernel::GetWordParityBit(uint64_t word) {
+    word ^= word >> 32;
+    word ^= word >> 16;
+    word ^= word >> 8;
+    word ^= word >> 4;
+    word ^= word >> 2;
+    word ^= word >> 1;
+
+    return word & 1;
+}
+
+void HammingKernel::AccumulateRunScalar(const uint8_t* words, size_t count, size_t first_window,
+    uint64_t low_mask, uint64_t& run_word, size_t& window_xor) {
+
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t word = LoadWord(words + i * 8);
+        run_word ^= word;
+        if (GetWordParityBit(word & low_mask)) {
+            window_xor ^= first_window + i;
+        }
+        if (GetWordParityBit(word & ~low_mask)) {
+            window_xor ^= first_window + i + 1;
+        }
+    }
+}
+
+uint8_t HammingKernel::XorBytesScalar(const uint8_t* data, size_t size) {
+    uint64_t acc = 0;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, 8);
+        acc ^= word;
+    }
+    acc ^= acc >> 32;
+    acc ^= acc >> 16;
+    acc ^= acc >> 8;
+    uint8_t res = static_cast<uint8_t>(acc);
+    for (; i < size; ++i) {
+        res ^= data[i];
+    }
+
+    return res;
+}
+
+#if defined(__GNUC__) && defined(__x86_64__)
+
+__attribute__((target("sse4.2,popcnt")))
+void HammingKernel::AccumulateRunSSE42(const uint8_t* words, size_t count, size_t first_window,
+    uint64_t low_mask, uint64_t& run_word, size_t& window_xor) {
+
+    const __m128i kByteSwap = _mm_set_epi8(8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7);
+    __m128i acc = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128i v = _mm_shuffle_epi8(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(words + i * 8)), kByteSwap);
+        acc = _mm_xor_si128(acc, v);
+        uint64_t lanes[2] = {
+            static_cast<uint64_t>(_mm_cvtsi128_si64(v)),
+            static_cast<uint64_t>(_mm_extract_epi64(v, 1))
+        };
+        for (size_t j = 0; j < 2; ++j) {
+            if (_mm_popcnt_u64(lanes[j] & low_mask) & 1) {
+                window_xor ^= first_window + i + j;
+            }
+            if (_mm_popcnt_u64(lanes[j] & ~low_mask) & 1) {
+                window_xor ^= first_window + i + j + 1;
+            }
+        }
+    }
+    run_word ^= static_cast<uint64_t>(_mm_cvtsi128_si64(acc)) ^
+        static_cast<uint64_t>(_mm_extract_epi64(acc, 1));
+    AccumulateRunScalar(words + i * 8, count - i, first_window + i, low_mask, run_word, window_xor);
+}
+
+__attribute__((target("sse4.2,popcnt")))
+uint8_t HammingKernel::XorBytesSSE42(const uint8_t* data, size_t size) {
+    __m128i acc = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        acc = _mm_xor_si128(acc, _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)));
+    }
+    uint8_t lanes[16];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), acc);
+
+    return XorBytesScalar(lanes, 16) ^ XorBytesScalar(data + i, size - i);
+}
+
+// Чётность каждого 64-битного элемента вектора в его младшем бите
+__attribute__((target("avx2")))
+static inline __m256i FoldParityAVX2(__m256i v) {
+    v = _mm256_xor_si256(v, _mm256_srli_epi64(v, 32));
+    v = _mm256_xor_si256(v, _mm256_srli_epi64(v, 16));
+    v = _mm256_xor_si256(v, _mm256_srli_epi64(v, 8));
+    v = _mm256_xor_si256(v, _mm256_srli_epi64(v, 4));
+    v = _mm256_xor_si256(v, _mm256_srli_epi64(v, 2));
+    v = _mm256_xor_si256(v, _mm256_srli_epi64(v, 1));
+
+    return v;
+}
+
+__attribute__((target("avx2")))
+void HammingKernel::AccumulateRunAVX2(const uint8_t* words, size_t count, size_t first_window,
+    uint64_t low_mask, uint64_t& run_word, size_t& window_xor) {
+
+    const __m256i kByteSwap = _mm256_set_epi8(
+        8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7,
+        8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i kZero = _mm256_setzero_si256();
+    const __m256i kOne = _mm256_set1_epi64x(1);
+    const __m256i kStep = _mm256_set1_epi64x(4);
+    const __m256i low = _mm256_set1_epi64x(static_cast<long long>(low_mask));
+    __m256i window = _mm256_add_epi64(
+        _mm256_set1_epi64x(static_cast<long long>(first_window)), _mm256_set_epi64x(3, 2, 1, 0));
+    __m256i acc = kZero;
+    __m256i window_acc = kZero;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256i v = _mm256_shuffle_epi8(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words + i * 8)), kByteSwap);
+        acc = _mm256_xor_si256(acc, v);
+        // Чётность старших бит - чётность слова, сложенная с чётностью младших
+        __m256i low_parity = _mm256_and_si256(FoldParityAVX2(_mm256_and_si256(v, low)), kOne);
+        __m256i high_parity = _mm256_xor_si256(
+            low_parity, _mm256_and_si256(FoldParityAVX2(v), kOne));
+        window_acc = _mm256_xor_si256(window_acc, _mm256_and_si256(
+            window, _mm256_sub_epi64(kZero, low_parity)));
+        window_acc = _mm256_xor_si256(window_acc, _mm256_and_si256(
+            _mm256_add_epi64(window, kOne), _mm256_sub_epi64(kZero, high_parity)));
+        window = _mm256_add_epi64(window, kStep);
+    }
+    uint64_t lanes[4];
+    uint64_t window_lanes[4];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), acc);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(window_lanes), window_acc);
+    for (size_t j = 0; j < 4; ++j) {
+        run_word ^= lanes[j];
+        window_xor ^= window_lanes[j];
+    }
+    AccumulateRunScalar(words + i * 8, count - i, first_window + i, low_mask, run_word, window_xor);
+}
+
+__attribute__((target("avx2")))
+uint8_t HammingKernel::XorBytesAVX2(const uint8_t* data, size_t size) {
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        acc = _mm256_xor_si256(acc, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)));
+    }
+    uint8_t lanes[32];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), acc);
+
+    return XorBytesScalar(lanes, 32) ^ XorBytesScalar(data + i, size - i);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static inline __m512i FoldParityAVX512(__m512i v) {
+    v = _mm512_xor_si512(v, _mm512_srli_epi64(v, 32));
+    v = _mm512_xor_si512(v, _mm512_srli_epi64(v, 16));
+    v = _mm512_xor_si512(v, _mm512_srli_epi64(v, 8));
+    v = _mm512_xor_si512(v, _mm512_srli_epi64(v, 4));
+    v = _mm512_xor_si512(v, _mm512_srli_epi64(v, 2));
+    v = _mm512_xor_si512(v, _mm512_srli_epi64(v, 1));
+
+    return v;
+}
+
+__attribute__((target("avx512f,avx512bw")))
+void HammingKernel::AccumulateRunAVX512(const uint8_t* words, size_t count, size_t first_window,
+    uint64_t low_mask, uint64_t& run_word, size_t& window_xor) {
+
+    const __m512i kByteSwap = _mm512_broadcast_i32x4(
+        _mm_set_epi8(8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7));
+    const __m512i kOne = _mm512_set1_epi64(1);
+    const __m512i kStep = _mm512_set1_epi64(8);
+    const __m512i low = _mm512_set1_epi64(static_cast<long long>(low_mask));
+    __m512i window = _mm512_add_epi64(
+        _mm512_set1_epi64(static_cast<long long>(first_window)),
+        _mm512_set_epi64(7, 6, 5, 4, 3, 2, 1, 0));
+    __m512i acc = _mm512_setzero_si512();
+    __m512i window_acc = _mm512_setzero_si512();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m512i v = _mm512_shuffle_epi8(_mm512_loadu_si512(words + i * 8), kByteSwap);
+        acc = _mm512_xor_si512(acc, v);
+        __m512i low_parity = FoldParityAVX512(_mm512_and_si512(v, low));
+        __m512i high_parity = _mm512_xor_si512(low_parity, FoldParityAVX512(v));
+        window_acc = _mm512_mask_xor_epi64(window_acc,
+            _mm512_test_epi64_mask(low_parity, kOne), window_acc, window);
+        window_acc = _mm512_mask_xor_epi64(window_acc,
+            _mm512_test_epi64_mask(high_parity, kOne), window_acc, _mm512_add_epi64(window, kOne));
+        window = _mm512_add_epi64(window, kStep);
+    }
+    uint64_t lanes[8];
+    uint64_t window_lanes[8];
+    _mm512_storeu_si512(lanes, acc);
+    _mm512_storeu_si512(window_lanes, window_acc);
+    for (size_t j = 0; j < 8; ++j) {
+        run_word ^= lanes[j];
+        window_xor ^= window_lanes[j];
+    }
+    AccumulateRunScalar(words + i * 8, count - i, first_window + i, low_mask, run_word, window_xor);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+uint8_t HammingKernel::XorBytesAVX512(const uint8_t* data, size_t size) {
+    __m512i acc = _mm512_setzero_si512();
+    size_t i = 0;
+    for (; i + 64 <= size; i += 64) {
+        acc = _mm512_xor_si512(acc, _mm512_loadu_si512(data + i));
+    }
+    uint8_t lanes[64];
+    _mm512_storeu_si512(lanes, acc);
+
+    return XorBytesScalar(lanes, 64) ^ XorBytesScalar(data + i, size - i);
+}
+
+#endif
@@ -0,0 +1,38 @@
+#include "IoPriority.hpp"
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+// Обёрток ioprio_set и ioprio_get в glibc нет; константы из linux/ioprio.h
+const int kIoprioWhoProcess = 1;    // pid 0 - вызывающий поток
+const int kIoprioClassShift = 13;
+const int kIoprioClassIdle = 3;
+
+}  // namespace
+#endif
+
+IdleIoPriority::IdleIoPriority() : previous_(0), applied_(false) {
+#if defined(__linux__) && defined(SYS_ioprio_set) && defined(SYS_ioprio_get)
+    previous_ = static_cast<int>(syscall(SYS_ioprio_get, kIoprioWhoProcess, 0));
+    if (previous_ == -1) {
+        return;
+    }
+    applied_ = syscall(SYS_ioprio_set, kIoprioWhoProcess, 0, 
+        kIoprioClassIdle << kIoprioClassShift) == 0;
+#endif
+}
+
+IdleIoPriority::~IdleIoPriority() {
+#if defined(__linux__) && defined(SYS_ioprio_set)
+    if (applied_) {
+        syscall(SYS_ioprio_set, kIoprioWhoProcess, 0, previous_);
+    }
+#endif
+}
+
+bool IdleIoPriority::IsApplied() const {
+    return applied_;
+}
@@ -0,0 +1,240 @@
+#include <algorithm>
+#include <cstring>
+
+#include "IoUring.hpp"
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <cerrno>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#if defined(SYS_io_uring_setup) && defined(SYS_io_uring_enter) && defined(SYS_io_uring_register)
+#define HAMARC_HAS_IO_URING
+#endif
+#endif
+
+IoUring::IoUring() 
+    : ring_fd_(-1), prepared_(0), buffers_registered_(false), sq_ring_(nullptr), sq_ring_size_(0),
+      cq_ring_(nullptr), cq_ring_size_(0), sqes_(nullptr), sqes_size_(0), sq_head_(nullptr),
+      sq_tail_(nullptr), sq_mask_(nullptr), sq_array_(nullptr), sq_entries_(0), cq_head_(nullptr),
+      cq_tail_(nullptr), cq_mask_(nullptr), cqes_(nullptr) {}
+
+IoUring::~IoUring() {
+    Close();
+}
+
+bool IoUring::IsSupported() {
+    static const bool supported = [] {
+        IoUring ring;
+        return ring.Init(1);
+    }();
+
+    return supported;
+}
+
+bool IoUring::IsOpen() const {
+    return ring_fd_ != -1;
+}
+
+#ifdef HAMARC_HAS_IO_URING
+
+bool IoUring::Init(unsigned entries) {
+    Close();
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    int fd = static_cast<int>(syscall(SYS_io_uring_setup, entries, &params));
+    if (fd < 0) {
+        return false;
+    }
+    ring_fd_ = fd;
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    // Начиная с Linux 5.4 обе очереди отображаются одним вызовом
+    bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+        sq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+        cq_ring_size_ = 0;
+    }
+    sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, 
+        fd, IORING_OFF_SQ_RING);
+    if (sq_ring_ == MAP_FAILED) {
+        sq_ring_ = nullptr;
+        Close();
+        return false;
+    }
+    cq_ring_ = sq_ring_;
+    if (!single_mmap) {
+        cq_ring_ = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, 
+            fd, IORING_OFF_CQ_RING);
+        if (cq_ring_ == MAP_FAILED) {
+            cq_ring_ = nullptr;
+            Close();
+            return false;
+        }
+    }
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, 
+        fd, IORING_OFF_SQES);
+    if (sqes_ == MAP_FAILED) {
+        sqes_ = nullptr;
+        Close();
+        return false;
+    }
+    uint8_t* sq = static_cast<uint8_t*>(sq_ring_);
+    uint8_t* cq = static_cast<uint8_t*>(cq_ring_);
+    sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask_ = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    sq_entries_ = params.sq_entries;
+    cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask_ = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = cq + params.cq_off.cqes;
+
+    return true;
+}
+
+bool IoUring::RegisterBuffers(uint8_t* const* buffers, size_t count, size_t size) {
+    if (!IsOpen()) {
+        return false;
+    }
+    iovec* iovecs = new iovec[count];
+    for (size_t i = 0; i < count; ++i) {
+        iovecs[i].iov_base = buffers[i];
+        iovecs[i].iov_len = size;
+    }
+    buffers_registered_ = syscall(SYS_io_uring_register, ring_fd_, IORING_REGISTER_BUFFERS, 
+        iovecs, static_cast<unsigned>(count)) == 0;
+    delete [] iovecs;
+
+    return buffers_registered_;
+}
+
+bool IoUring::PrepareRead(int fd, uint8_t* data, size_t size, size_t offset, 
+    unsigned buffer_index, uint64_t user_data) {
+
+    return Prepare(buffers_registered_ ? IORING_OP_READ_FIXED : IORING_OP_READ, 
+        fd, data, size, offset, buffer_index, user_data);
+}
+
+bool IoUring::PrepareWrite(int fd, const uint8_t* data, size_t size, size_t offset, 
+    unsigned buffer_index, uint64_t user_data) {
+
+    return Prepare(buffers_registered_ ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE, 
+        fd, data, size, offset, buffer_index, user_data);
+}
+
+bool IoUring::Prepare(uint8_t opcode, int fd, const uint8_t* data, size_t size, size_t offset, 
+    unsigned buffer_index, uint64_t user_data) {
+
+    // Хвост очереди отправки изменяет только приложение, голову - только ядро
+    unsigned tail = *sq_tail_;
+    if (tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >= sq_entries_) {
+        return false;
+    }
+    unsigned index = tail & *sq_mask_;
+    io_uring_sqe* sqe = static_cast<io_uring_sqe*>(sqes_) + index;
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = opcode;
+    sqe->fd = fd;
+    sqe->off = offset;
+    sqe->addr = reinterpret_cast<uint64_t>(data);
+    sqe->len = static_cast<uint32_t>(size);
+    sqe->user_data = user_data;
+    if (opcode == IORING_OP_READ_FIXED || opcode == IORING_OP_WRITE_FIXED) {
+        sqe->buf_index = static_cast<uint16_t>(buffer_index);
+    }
+    sq_array_[index] = index;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    ++prepared_;
+
+    return true;
+}
+
+bool IoUring::Submit(unsigned wait_count) {
+    while (prepared_ != 0 || wait_count != 0) {
+        int submitted = static_cast<int>(syscall(SYS_io_uring_enter, ring_fd_, prepared_, wait_count, 
+            wait_count != 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0));
+        if (submitted < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        prepared_ -= std::min(prepared_, static_cast<unsigned>(submitted));
+        wait_count = 0;
+    }
+
+    return true;
+}
+
+bool IoUring::PopCompletion(uint64_t& user_data, int& result) {
+    unsigned head = *cq_head_;
+    if (head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+    const io_uring_cqe* cqe = static_cast<const io_uring_cqe*>(cqes_) + (head & *cq_mask_);
+    user_data = cqe->user_data;
+    result = cqe->res;
+    __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+void IoUring::Close() {
+    if (sqes_ != nullptr) {
+        munmap(sqes_, sqes_size_);
+    }
+    if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+        munmap(cq_ring_, cq_ring_size_);
+    }
+    if (sq_ring_ != nullptr) {
+        munmap(sq_ring_, sq_ring_size_);
+    }
+    if (ring_fd_ != -1) {
+        close(ring_fd_);
+    }
+    ring_fd_ = -1;
+    prepared_ = 0;
+    buffers_registered_ = false;
+    sq_ring_ = nullptr;
+    cq_ring_ = nullptr;
+    sqes_ = nullptr;
+}
+
+#else
+
+bool IoUring::Init(unsigned entries) {
+    return false;
+}
+
+bool IoUring::RegisterBuffers(uint8_t* const* buffers, size_t count, size_t size) {
+    return false;
+}
+
+bool IoUring::PrepareRead(int fd, uint8_t* data, size_t size, size_t offset, 
+    unsigned buffer_index, uint64_t user_data) {
+
+    return false;
+}
+
+bool IoUring::PrepareWrite(int fd, const uint8_t* data, size_t size, size_t offset, 
+    unsigned buffer_index, uint64_t user_data) {
+
+    return false;
+}
+
+bool IoUring::Submit(unsigned wait_count) {
+    return false;
+}
+
+bool IoUring::PopCompletion(uint64_t& user_data, int& result) {
+    return false;
+}
+
+void IoUring::Close() {}
+
+#endif
@@ -0,0 +1,93 @@
+#include <algorithm>
+
+#include "MappedFile.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define HAMARC_HAS_MMAP
+#endif
+
+MappedFile::MappedFile() : data_(nullptr), size_(0) {}
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+bool MappedFile::Open(const std::filesystem::path& file) {
+    Close();
+#ifdef HAMARC_HAS_MMAP
+    int fd = open(file.c_str(), O_RDONLY);
+    if (fd == -1) {
+        return false;
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+        close(fd);
+        return false;
+    }
+    void* data = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // Отображение остаётся действительным после закрытия дескриптора
+    close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    data_ = static_cast<const uint8_t*>(data);
+    size_ = file_stat.st_size;
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+void MappedFile::Close() {
+#ifdef HAMARC_HAS_MMAP
+    if (data_ != nullptr) {
+        munmap(const_cast<uint8_t*>(data_), size_);
+    }
+#endif
+    data_ = nullptr;
+    size_ = 0;
+}
+
+bool MappedFile::IsOpen() const {
+    return data_ != nullptr;
+}
+
+const uint8_t* MappedFile::GetData() const {
+    return data_;
+}
+
+size_t MappedFile::GetSize() const {
+    return size_;
+}
+
+void MappedFile::Advise(size_t offset, size_t length, AccessPattern pattern) const {
+#ifdef HAMARC_HAS_MMAP
+    if (data_ == nullptr || offset >= size_) {
+        return;
+    }
+    // Начало области выравнивается вниз до границы страницы
+    size_t page_size = sysconf(_SC_PAGESIZE);
+    size_t begin = offset - offset % page_size;
+    size_t end = std::min(offset + length, size_);
+    int advice = MADV_NORMAL;
+    switch (pattern) {
+        case AccessPattern::kSequential:
+            advice = MADV_SEQUENTIAL;
+            break;
+        case AccessPattern::kRandom:
+            advice = MADV_RANDOM;
+            break;
+        case AccessPattern::kWillNeed:
+            advice = MADV_WILLNEED;
+            break;
+        default:
+            break;
+    }
+    madvise(const_cast<uint8_t*>(data_) + begin, end - begin, advice);
+#endif
+}
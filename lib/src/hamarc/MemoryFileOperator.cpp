@@ -0,0 +1,176 @@
+#include <algorithm>
+#include <cstring>
+
+#include "MemoryFileOperator.hpp"
+
+class MemoryFileOperator::MemoryFile : public RandomAccessFile {
+public:
+    MemoryFile(std::shared_ptr<Node> node, bool writable) : node_(node), writable_(writable) {}
+
+    size_t ReadAt(size_t offset, uint8_t* data, size_t size) override {
+        std::lock_guard<std::mutex> lock(node_->mutex);
+        if (offset >= node_->data.size()) {
+            return 0;
+        }
+        size = std::min(size, node_->data.size() - offset);
+        std::memcpy(data, node_->data.data() + offset, size);
+
+        return size;
+    }
+
+    bool WriteAt(size_t offset, const uint8_t* data, size_t size) override {
+        if (!writable_) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(node_->mutex);
+        if (node_->data.size() < offset + size) {
+            node_->data.resize(offset + size);
+        }
+        std::memcpy(node_->data.data() + offset, data, size);
+        node_->write_time = std::filesystem::file_time_type::clock::now();
+
+        return true;
+    }
+
+    size_t GetSize() override {
+        std::lock_guard<std::mutex> lock(node_->mutex);
+        return node_->data.size();
+    }
+
+private:
+    std::shared_ptr<Node> node_;
+    bool writable_;
+};
+
+void MemoryFileOperator::WriteFile(std::filesystem::path filename, std::string_view data) {
+    std::unique_ptr<RandomAccessFile> file = OpenFile(filename, true, true, true);
+    file->WriteAt(0, reinterpret_cast<const uint8_t*>(data.data()), data.size());
+}
+
+std::string MemoryFileOperator::ReadFile(std::filesystem::path filename) {
+    std::shared_ptr<Node> node = FindNode(filename);
+    if (node == nullptr) {
+        return std::string();
+    }
+    std::lock_guard<std::mutex> lock(node->mutex);
+
+    return std::string(node->data.begin(), node->data.end());
+}
+
+bool MemoryFileOperator::FileExists(std::filesystem::path filename) {
+    return FindNode(filename) != nullptr;
+}
+
+size_t MemoryFileOperator::GetFileSize(std::filesystem::path filename) {
+    std::shared_ptr<Node> node = FindNode(filename);
+    if (node == nullptr) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(node->mutex);
+
+    return node->data.size();
+}
+
+std::filesystem::file_time_type MemoryFileOperator::GetLastWriteTime(std::filesystem::path filename) {
+    std::shared_ptr<Node> node = FindNode(filename);
+    if (node == nullptr) {
+        return std::filesystem::file_time_type::min();
+    }
+    std::lock_guard<std::mutex> lock(node->mutex);
+
+    return node->write_time;
+}
+
+bool MemoryFileOperator::CreateDir(std::filesystem::path) {
+    return true;
+}
+
+bool MemoryFileOperator::DeleteFile(std::filesystem::path filename) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return files_.erase(GetKey(filename)) != 0;
+}
+
+size_t MemoryFileOperator::DeleteDir(std::filesystem::path name) {
+    std::string prefix = GetKey(name) + "/";
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t deleted = 0;
+    for (auto it = files_.begin(); it != files_.end();) {
+        if (it->first.compare(0, prefix.size(), prefix) == 0) {
+            it = files_.erase(it);
+            ++deleted;
+        } else {
+            ++it;
+        }
+    }
+
+    return deleted;
+}
+
+void MemoryFileOperator::RenameFile(std::filesystem::path old_name, 
+        std::filesystem::path new_name) {
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = files_.find(GetKey(old_name));
+    if (it == files_.end()) {
+        return;
+    }
+    std::shared_ptr<Node> node = it->second;
+    files_.erase(it);
+    files_[GetKey(new_name)] = node;
+}
+
+void MemoryFileOperator::ResizeFile(std::filesystem::path filename, size_t new_size) {
+    std::shared_ptr<Node> node = FindNode(filename);
+    if (node == nullptr) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(node->mutex);
+    node->data.resize(new_size);
+    node->write_time = std::filesystem::file_time_type::clock::now();
+}
+
+std::unique_ptr<RandomAccessFile> MemoryFileOperator::OpenFile(const std::filesystem::path& file, 
+    bool writable, bool create, bool truncate) {
+
+    std::string key = GetKey(file);
+    std::shared_ptr<Node> node;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = files_.find(key);
+        if (it != files_.end()) {
+            node = it->second;
+        } else if (create) {
+            node = std::make_shared<Node>();
+            node->write_time = std::filesystem::file_time_type::clock::now();
+            files_[key] = node;
+        } else {
+            return nullptr;
+        }
+    }
+    if (truncate) {
+        std::lock_guard<std::mutex> lock(node->mutex);
+        node->data.clear();
+        node->write_time = std::filesystem::file_time_type::clock::now();
+    }
+
+    return std::make_unique<MemoryFile>(node, writable);
+}
+
+std::string MemoryFileOperator::GetKey(const std::filesystem::path& filename) const {
+    std::string key = (dir_ / filename).lexically_normal().generic_string();
+    // Путь директории может оканчиваться разделителем
+    while (key.size() > 1 && key.back() == '/') {
+        key.pop_back();
+    }
+
+    return key;
+}
+
+std::shared_ptr<MemoryFileOperator::Node> MemoryFileOperator::FindNode(
+    const std::filesystem::path& filename) {
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = files_.find(GetKey(filename));
+
+    return it != files_.end() ? it->second : nullptr;
+}
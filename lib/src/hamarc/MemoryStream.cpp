@@ -0,0 +1,63 @@
+#include "MemoryStream.hpp"
+
+MemoryStream::MemoryStream() : std::istream(&buf_) {}
+
+MemoryStream::MemoryStream(const uint8_t* data, size_t size) : std::istream(&buf_) {
+    buf_.SetData(data, size);
+}
+
+void MemoryStream::SetData(const uint8_t* data, size_t size) {
+    buf_.SetData(data, size);
+    clear();
+}
+
+const uint8_t* MemoryStream::ReadSpan(size_t size) {
+    const uint8_t* span = buf_.ReadSpan(size);
+    if (span == nullptr) {
+        setstate(std::ios_base::failbit);
+    }
+    return span;
+}
+
+void MemoryStream::MemoryBuf::SetData(const uint8_t* data, size_t size) {
+    // Поток только читает область, поэтому снятие const безопасно
+    char* begin = reinterpret_cast<char*>(const_cast<uint8_t*>(data));
+    setg(begin, begin, begin + size);
+}
+
+const uint8_t* MemoryStream::MemoryBuf::ReadSpan(size_t size) {
+    if (static_cast<size_t>(egptr() - gptr()) < size) {
+        return nullptr;
+    }
+    const uint8_t* span = reinterpret_cast<const uint8_t*>(gptr());
+    setg(eback(), gptr() + size, egptr());
+
+    return span;
+}
+
+MemoryStream::MemoryBuf::pos_type MemoryStream::MemoryBuf::seekoff(
+    off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) {
+
+    if ((which & std::ios_base::in) == 0) {
+        return pos_type(off_type(-1));
+    }
+    off_type base = 0;
+    if (dir == std::ios_base::cur) {
+        base = gptr() - eback();
+    } else if (dir == std::ios_base::end) {
+        base = egptr() - eback();
+    }
+    off_type pos = base + off;
+    if (pos < 0 || pos > egptr() - eback()) {
+        return pos_type(off_type(-1));
+    }
+    setg(eback(), eback() + pos, egptr());
+
+    return pos_type(pos);
+}
+
+MemoryStream::MemoryBuf::pos_type MemoryStream::MemoryBuf::seekpos(
+    pos_type pos, std::ios_base::openmode which) {
+
+    return seekoff(off_type(pos), std::ios_base::beg, which);
+}
@@ -0,0 +1,143 @@
+#include <sstream>
+
+#include "Metrics.hpp"
+
+Metrics::PhaseTimer::PhaseTimer(Metrics& metrics, Phase phase) 
+    : metrics_(metrics), phase_(phase), active_(metrics.IsEnabled()) {
+
+    if (active_) {
+        wall_start_ = std::chrono::steady_clock::now();
+        cpu_start_ = std::clock();
+    }
+}
+
+Metrics::PhaseTimer::~PhaseTimer() {
+    if (!active_) {
+        return;
+    }
+    uint64_t wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - wall_start_).count();
+    uint64_t cpu_ns = static_cast<uint64_t>(
+        static_cast<double>(std::clock() - cpu_start_) * 1e9 / CLOCKS_PER_SEC);
+    metrics_.AddPhaseTime(phase_, wall_ns, cpu_ns);
+}
+
+Metrics::Metrics() : enabled_(false) {
+    Reset();
+}
+
+void Metrics::SetEnabled(bool enabled) {
+    enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+bool Metrics::IsEnabled() const {
+    return enabled_.load(std::memory_order_relaxed);
+}
+
+uint64_t Metrics::Get(Counter counter) const {
+    return counters_[static_cast<size_t>(counter)].load(std::memory_order_relaxed);
+}
+
+Metrics::PhaseTime Metrics::GetPhaseTime(Phase phase) const {
+    size_t i = static_cast<size_t>(phase);
+    return PhaseTime{
+        wall_ns_[i].load(std::memory_order_relaxed),
+        cpu_ns_[i].load(std::memory_order_relaxed),
+        calls_[i].load(std::memory_order_relaxed)
+    };
+}
+
+void Metrics::Reset() {
+    for (size_t i = 0; i < kCountersCount; ++i) {
+        counters_[i].store(0, std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < kPhasesCount; ++i) {
+        wall_ns_[i].store(0, std::memory_order_relaxed);
+        cpu_ns_[i].store(0, std::memory_order_relaxed);
+        calls_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void Metrics::AddPhaseTime(Phase phase, uint64_t wall_ns, uint64_t cpu_ns) {
+    size_t i = static_cast<size_t>(phase);
+    wall_ns_[i].fetch_add(wall_ns, std::memory_order_relaxed);
+    cpu_ns_[i].fetch_add(cpu_ns, std::memory_order_relaxed);
+    calls_[i].fetch_add(1, std::memory_order_relaxed);
+}
+
+std::string Metrics::ToJson() const {
+    std::ostringstream json;
+    json << "{\n  \"counters\": {";
+    for (size_t i = 0; i < kCountersCount; ++i) {
+        json << (i == 0 ? "\n" : ",\n") << "    \"" << GetName(static_cast<Counter>(i)) 
+            << "\": " << Get(static_cast<Counter>(i));
+    }
+    json << "\n  },\n  \"phases\": {";
+    bool first = true;
+    for (size_t i = 0; i < kPhasesCount; ++i) {
+        PhaseTime time = GetPhaseTime(static_cast<Phase>(i));
+        if (time.calls == 0) {
+            continue;
+        }
+        json << (first ? "\n" : ",\n") << "    \"" << GetName(static_cast<Phase>(i)) << "\": {"
+            << "\"wall_ms\": " << time.wall_ns / 1e6 << ", "
+            << "\"cpu_ms\": " << time.cpu_ns / 1e6 << ", "
+            << "\"calls\": " << time.calls << "}";
+        first = false;
+    }
+    json << "\n  }\n}\n";
+
+    return json.str();
+}
+
+const char* Metrics::GetName(Counter counter) {
+    switch (counter) {
+        case Counter::kRawBytes:
+            return "raw_bytes";
+        case Counter::kEncodedBytes:
+            return "encoded_bytes";
+        case Counter::kBlocksEncoded:
+            return "blocks_encoded";
+        case Counter::kBlocksValidated:
+            return "blocks_validated";
+        case Counter::kSingleErrorsFixed:
+            return "single_errors_fixed";
+        case Counter::kDoubleErrors:
+            return "double_errors";
+        case Counter::kSeeks:
+            return "seeks";
+        case Counter::kReads:
+            return "reads";
+        case Counter::kBytesCopied:
+            return "bytes_copied";
+        case Counter::kCacheHits:
+            return "cache_hits";
+        case Counter::kCacheMisses:
+            return "cache_misses";
+        default:
+            return "unknown";
+    }
+}
+
+const char* Metrics::GetName(Phase phase) {
+    switch (phase) {
+        case Phase::kLoadEntries:
+            return "load_entries";
+        case Phase::kEncoding:
+            return "encoding";
+        case Phase::kExtraction:
+            return "extraction";
+        case Phase::kDeletion:
+            return "deletion";
+        case Phase::kVacuum:
+            return "vacuum";
+        case Phase::kMerge:
+            return "merge";
+        case Phase::kVerification:
+            return "verification";
+        case Phase::kScrub:
+            return "scrub";
+        default:
+            return "unknown";
+    }
+}
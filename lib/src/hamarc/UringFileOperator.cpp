@@ -0,0 +1,431 @@
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#include "UringFileOperator.hpp"
+#include "IoUring.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define HAMARC_HAS_POSIX_IO
+#endif
+
+#ifdef HAMARC_HAS_POSIX_IO
+namespace {
+
+/**
+ * \brief Буферы запросов, повторно используемые открываемыми файлами
+*/
+class SlotPool {
+public:
+    static constexpr size_t kSlotSize = 256 * 1024;
+
+    static uint8_t* Acquire() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (free_.slots.empty()) {
+            return new uint8_t[kSlotSize];
+        }
+        uint8_t* slot = free_.slots.back();
+        free_.slots.pop_back();
+
+        return slot;
+    }
+
+    static void Release(uint8_t* slot) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_.slots.push_back(slot);
+    }
+
+private:
+    // Свободные буферы освобождаются при завершении программы
+    struct FreeList {
+        std::vector<uint8_t*> slots;
+
+        ~FreeList() {
+            for (uint8_t* slot : slots) {
+                delete[] slot;
+            }
+        }
+    };
+
+    static inline std::mutex mutex_;
+    static inline FreeList free_;
+};
+
+/**
+ * \brief Файл, запросы к которому выполняются через собственное кольцо io_uring.
+ * Данные проходят через kSlotsCount буферов по SlotPool::kSlotSize байт: буфер 
+ * хранит либо выровненную по своему размеру часть файла (прочитанную или 
+ * читаемую заранее), либо данные отправленной записи
+*/
+class UringFile : public RandomAccessFile {
+public:
+    UringFile(int fd) : fd_(fd), ring_ready_(false), write_failed_(false), in_flight_(0), 
+        use_counter_(0), last_chunk_(static_cast<size_t>(-1)) {
+
+        for (size_t i = 0; i < kSlotsCount; ++i) {
+            slots_[i] = Slot{nullptr, SlotState::kFree, 0, 0, 0, 0};
+        }
+    }
+
+    ~UringFile() {
+        if (ring_ready_) {
+            while (in_flight_ != 0 && Reap(1)) {}
+            for (size_t i = 0; i < kSlotsCount; ++i) {
+                SlotPool::Release(slots_[i].data);
+            }
+        }
+        close(fd_);
+    }
+
+    size_t ReadAt(size_t offset, uint8_t* data, size_t size) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!EnsureRing()) {
+            return ReadSync(offset, data, size);
+        }
+        // Кольцо не упорядочивает запросы: чтение видит только завершённые записи
+        DrainWrites();
+        if (size == 0) {
+            return 0;
+        }
+        size_t first_chunk = offset / SlotPool::kSlotSize;
+        size_t last_chunk = (offset + size - 1) / SlotPool::kSlotSize;
+        bool sequential = first_chunk == last_chunk_ || first_chunk == last_chunk_ + 1 
+            || (last_chunk_ == static_cast<size_t>(-1) && first_chunk == 0);
+        size_t done = 0;
+        for (size_t chunk = first_chunk; chunk <= last_chunk; ++chunk) {
+            size_t prefetch_end = std::max(last_chunk + 1, sequential ? chunk + 1 + kReadAhead : 0);
+            for (size_t next = chunk; next < prefetch_end; ++next) {
+                if (next != chunk && next * SlotPool::kSlotSize >= size_) {
+                    break;
+                }
+                size_t found = FindChunk(next);
+                if (found != kSlotsCount) {
+                    // Нужная часть не должна вытесняться при чтении следующих
+                    slots_[found].last_use = ++use_counter_;
+                } else if (!RequestChunk(next)) {
+                    break;
+                }
+                if (next - chunk + 1 >= kSlotsCount / 2) {
+                    break;
+                }
+            }
+            size_t index = FindChunk(chunk);
+            if (index == kSlotsCount) {
+                return done + ReadSync(offset + done, data + done, size - done);
+            }
+            ring_.Submit(0);
+            if (!WaitSlot(index)) {
+                return done;
+            }
+            Slot& slot = slots_[index];
+            slot.last_use = ++use_counter_;
+            size_t chunk_begin = chunk * SlotPool::kSlotSize;
+            size_t begin = offset + done - chunk_begin;
+            size_t end = std::min(offset + size - chunk_begin, slot.result);
+            if (end > begin) {
+                std::memcpy(data + done, slot.data + begin, end - begin);
+                done += end - begin;
+            }
+            // Конец файла не кэшируется: файл может быть дописан
+            if (slot.result < SlotPool::kSlotSize) {
+                slot.state = SlotState::kFree;
+                break;
+            }
+            last_chunk_ = chunk;
+        }
+
+        return done;
+    }
+
+    bool WriteAt(size_t offset, const uint8_t* data, size_t size) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!EnsureRing()) {
+            return WriteSync(offset, data, size);
+        }
+        if (write_failed_) {
+            return false;
+        }
+        // Прочитанные части устаревают, а пересекающиеся записи должны завершиться по порядку
+        for (size_t i = 0; i < kSlotsCount; ++i) {
+            Slot& slot = slots_[i];
+            if (slot.state != SlotState::kFree && slot.offset < offset + size 
+                && offset < slot.offset + slot.size) {
+
+                WaitSlot(i);
+                slot.state = SlotState::kFree;
+            }
+        }
+        for (size_t done = 0; done < size;) {
+            size_t part = std::min(size - done, SlotPool::kSlotSize);
+            size_t index = GetFreeSlot();
+            if (index == kSlotsCount) {
+                write_failed_ = true;
+                return false;
+            }
+            Slot& slot = slots_[index];
+            std::memcpy(slot.data, data + done, part);
+            slot.state = SlotState::kWriting;
+            slot.offset = offset + done;
+            slot.size = part;
+            slot.result = 0;
+            if (!ring_.PrepareWrite(fd_, slot.data, part, slot.offset, index, index)) {
+                ring_.Submit(0);
+                ring_.PrepareWrite(fd_, slot.data, part, slot.offset, index, index);
+            }
+            ++in_flight_;
+            done += part;
+        }
+        ring_.Submit(0);
+        size_ = std::max(size_, offset + size);
+
+        return !write_failed_;
+    }
+
+    size_t GetSize() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (ring_ready_) {
+            DrainWrites();
+        }
+        struct stat file_stat;
+        return fstat(fd_, &file_stat) == 0 ? static_cast<size_t>(file_stat.st_size) : 0;
+    }
+
+    bool Sync() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (ring_ready_) {
+            DrainWrites();
+        }
+
+        return !write_failed_;
+    }
+
+    bool SyncToDevice() override {
+        return Sync() && fsync(fd_) == 0;
+    }
+
+private:
+    static constexpr size_t kSlotsCount = 8;
+    static constexpr size_t kReadAhead = 4;
+
+    enum class SlotState {
+        kFree,
+        kReading,
+        kRead,
+        kWriting
+    };
+
+    struct Slot {
+        uint8_t* data;
+        SlotState state;
+        size_t offset;
+        size_t size;            // размер запроса
+        size_t result;          // прочитанные или записанные байты
+        uint64_t last_use;
+    };
+
+    bool EnsureRing() {
+        if (ring_ready_) {
+            return true;
+        }
+        if (!IoUring::IsSupported() || !ring_.Init(kSlotsCount * 2)) {
+            return false;
+        }
+        uint8_t* buffers[kSlotsCount];
+        for (size_t i = 0; i < kSlotsCount; ++i) {
+            slots_[i].data = SlotPool::Acquire();
+            buffers[i] = slots_[i].data;
+        }
+        // Без регистрации запросы используют обычные буферы
+        ring_.RegisterBuffers(buffers, kSlotsCount, SlotPool::kSlotSize);
+        struct stat file_stat;
+        size_ = fstat(fd_, &file_stat) == 0 ? static_cast<size_t>(file_stat.st_size) : 0;
+        ring_ready_ = true;
+
+        return true;
+    }
+
+    size_t FindChunk(size_t chunk) const {
+        for (size_t i = 0; i < kSlotsCount; ++i) {
+            const Slot& slot = slots_[i];
+            if ((slot.state == SlotState::kReading || slot.state == SlotState::kRead) 
+                && slot.offset == chunk * SlotPool::kSlotSize) {
+
+                return i;
+            }
+        }
+
+        return kSlotsCount;
+    }
+
+    bool RequestChunk(size_t chunk) {
+        size_t index = GetFreeSlot();
+        if (index == kSlotsCount) {
+            return false;
+        }
+        Slot& slot = slots_[index];
+        slot.offset = chunk * SlotPool::kSlotSize;
+        slot.size = SlotPool::kSlotSize;
+        slot.result = 0;
+        slot.last_use = ++use_counter_;
+        if (!ring_.PrepareRead(fd_, slot.data, slot.size, slot.offset, index, index)) {
+            return false;
+        }
+        slot.state = SlotState::kReading;
+        ++in_flight_;
+
+        return true;
+    }
+
+/**
+ * \brief Возвращает свободный буфер, вытесняя давно использованную прочитанную часть,
+ * либо дожидаясь завершения запроса
+ * \return kSlotsCount, если кольцо неработоспособно
+*/
+    size_t GetFreeSlot() {
+        while (true) {
+            size_t oldest = kSlotsCount;
+            for (size_t i = 0; i < kSlotsCount; ++i) {
+                if (slots_[i].state == SlotState::kFree) {
+                    return i;
+                }
+                if (slots_[i].state == SlotState::kRead 
+                    && (oldest == kSlotsCount || slots_[i].last_use < slots_[oldest].last_use)) {
+                    oldest = i;
+                }
+            }
+            if (oldest != kSlotsCount) {
+                slots_[oldest].state = SlotState::kFree;
+                return oldest;
+            }
+            if (!Reap(1)) {
+                return kSlotsCount;
+            }
+        }
+    }
+
+    bool WaitSlot(size_t index) {
+        while (slots_[index].state == SlotState::kReading || slots_[index].state == SlotState::kWriting) {
+            if (!Reap(1)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void DrainWrites() {
+        for (size_t i = 0; i < kSlotsCount; ++i) {
+            if (slots_[i].state == SlotState::kWriting) {
+                WaitSlot(i);
+            }
+        }
+    }
+
+/**
+ * \brief Отправляет подготовленные запросы, ждёт завершения wait_count из них
+ * и разбирает результаты
+*/
+    bool Reap(unsigned wait_count) {
+        if (!ring_.Submit(wait_count)) {
+            // Кольцо неработоспособно: незавершённые запросы считаются неудавшимися
+            return false;
+        }
+        uint64_t index;
+        int result;
+        while (ring_.PopCompletion(index, result)) {
+            Slot& slot = slots_[index];
+            --in_flight_;
+            if (slot.state == SlotState::kReading) {
+                slot.result = result > 0 ? static_cast<size_t>(result) : 0;
+                slot.state = SlotState::kRead;
+                continue;
+            }
+            if (result > 0 && slot.result + result < slot.size) {
+                // Записана часть данных: остаток отправляется повторно
+                slot.result += result;
+                ring_.PrepareWrite(fd_, slot.data + slot.result, slot.size - slot.result, 
+                    slot.offset + slot.result, static_cast<unsigned>(index), index);
+                ++in_flight_;
+                continue;
+            }
+            write_failed_ = write_failed_ || result <= 0;
+            slot.state = SlotState::kFree;
+        }
+
+        return true;
+    }
+
+    size_t ReadSync(size_t offset, uint8_t* data, size_t size) {
+        size_t done = 0;
+        while (done < size) {
+            ssize_t read = pread(fd_, data + done, size - done, offset + done);
+            if (read == -1 && errno == EINTR) {
+                continue;
+            }
+            if (read <= 0) {
+                break;
+            }
+            done += read;
+        }
+
+        return done;
+    }
+
+    bool WriteSync(size_t offset, const uint8_t* data, size_t size) {
+        size_t done = 0;
+        while (done < size) {
+            ssize_t written = pwrite(fd_, data + done, size - done, offset + done);
+            if (written == -1 && errno == EINTR) {
+                continue;
+            }
+            if (written <= 0) {
+                return false;
+            }
+            done += written;
+        }
+
+        return true;
+    }
+
+    std::mutex mutex_;
+    int fd_;
+    IoUring ring_;
+    bool ring_ready_;
+    bool write_failed_;
+    Slot slots_[kSlotsCount];
+    size_t in_flight_;
+    size_t size_;               // размер файла с учётом отправленных записей
+    uint64_t use_counter_;
+    size_t last_chunk_;         // последняя прочитанная часть, для распознавания последовательного чтения
+};
+
+}  // namespace
+#endif
+
+bool UringFileOperator::OpenMapped(std::filesystem::path, MappedFile&) {
+    return false;
+}
+
+std::unique_ptr<RandomAccessFile> UringFileOperator::OpenFile(const std::filesystem::path& file, 
+    bool writable, bool create, bool truncate) {
+
+#ifdef HAMARC_HAS_POSIX_IO
+    if (!IoUring::IsSupported()) {
+        return FdFileOperator::OpenFile(file, writable, create, truncate);
+    }
+    int flags = (writable ? O_RDWR : O_RDONLY) | (create ? O_CREAT : 0) | (truncate ? O_TRUNC : 0);
+    int fd = open((dir_ / file).c_str(), flags, 0644);
+    if (fd == -1) {
+        return nullptr;
+    }
+
+    return std::make_unique<UringFile>(fd);
+#else
+    return FdFileOperator::OpenFile(file, writable, create, truncate);
+#endif
+}
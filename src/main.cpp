@@ -1,11 +1,18 @@
+#include <algorithm>
+#include <cstdint>
 #include <iostream>
 
 #include "hamarc/HamArchiver.hpp"
+#include "hamarc/DirectFileOperator.hpp"
+#include "hamarc/UringFileOperator.hpp"
 #include "argparser/ArgParser.hpp"
 
 std::string working_dir;
 std::string arcfile;
 std::vector<std::string> files;
+std::string stdin_name;
+std::string range;
+std::string io_engine;
 HamArchiver harchiver{};
 
 bool exec_create = false;
@@ -14,23 +21,71 @@ bool exec_extract = false;
 bool exec_append = false;
 bool exec_delete = false;
 bool exec_merge = false;
+bool exec_vacuum = false;
+bool exec_verify = false;
+bool exec_scrub = false;
+bool idle_io = false;
+bool no_index = false;
+bool print_stats = false;
+bool to_stdout = false;
+int threads_count = -1;
+int inflight_memory_mb = 64;
+int vacuum_threshold = 25;
+int block_size = 0;
+int scrub_rate_mb = 0;
 
 void InitArgs(ArgumentParser::ArgParser& arg_parser) {
     arg_parser.AddStringArgument('D', "directory", "Override working directory").StoreValue(working_dir);
-    arg_parser.AddStringArgument('f', "file", "An archive file").StoreValue(arcfile);
+    arg_parser.AddStringArgument('f', "file", "An archive file ('-' - write a created archive to stdout)").StoreValue(arcfile);
     arg_parser.AddStringArgument(0, "_files", "Files to process").MultiValue(0).Positional().StoreValues(files);
     arg_parser.AddFlag('c', "create", "Create an archive").StoreValue(exec_create);
     arg_parser.AddFlag('l', "list", "List files in archive").StoreValue(exec_list);
     arg_parser.AddFlag('x', "extract", "Extract specified files (all, if no files specified)").StoreValue(exec_extract);
+    arg_parser.AddFlag('O', "to-stdout", "Extract files to standard output").StoreValue(to_stdout);
     arg_parser.AddFlag('a', "append", "Append files to an archive").StoreValue(exec_append);
     arg_parser.AddFlag('d', "delete", "Delete files from an archive").StoreValue(exec_delete);
     arg_parser.AddFlag('A', "concatenate", "Merge archives").StoreValue(exec_merge);
+    arg_parser.AddFlag('V', "vacuum", "Compact an archive, reclaiming space of deleted files").StoreValue(exec_vacuum);
+    arg_parser.AddFlag('t', "test", "Check all blocks of an archive without modifying it").StoreValue(exec_verify);
+    arg_parser.AddFlag('S', "scrub", "Check an archive and specified archives, correcting errors in place").StoreValue(exec_scrub);
+    arg_parser.AddFlag('N', "no-index", "Do not write a table of contents to the archive").StoreValue(no_index);
+    arg_parser.AddFlag("stats", "Print operation metrics as JSON to stderr").StoreValue(print_stats);
+    auto& threads_arg = arg_parser.AddIntArgument('j', "threads", "Worker threads for encoding, extraction and checking (0 - one per CPU core; default: 1, one per core for -t)");
+    threads_arg.Default(-1);
+    threads_arg.StoreValue(threads_count);
+    auto& inflight_arg = arg_parser.AddIntArgument("inflight-mb", "Memory for blocks in flight during parallel encoding, MiB");
+    inflight_arg.Default(64);
+    inflight_arg.StoreValue(inflight_memory_mb);
+    auto& vacuum_threshold_arg = arg_parser.AddIntArgument("vacuum-threshold", "Minimal share of deleted data for vacuum, %");
+    vacuum_threshold_arg.Default(25);
+    vacuum_threshold_arg.StoreValue(vacuum_threshold);
+    auto& scrub_rate_arg = arg_parser.AddIntArgument("scrub-rate", "I/O rate limit for scrub, MiB/s (0 - unlimited)");
+    scrub_rate_arg.Default(0);
+    scrub_rate_arg.StoreValue(scrub_rate_mb);
+    arg_parser.AddFlag("idle-io", "Scrub with idle I/O priority (Linux)").StoreValue(idle_io);
+    auto& io_engine_arg = arg_parser.AddStringArgument("io-engine", "File I/O: 'sync', 'uring' (io_uring on Linux, sync if unsupported) or 'direct' (bypass the page cache)");
+    io_engine_arg.Default("sync");
+    io_engine_arg.StoreValue(io_engine);
+    arg_parser.AddStringArgument("range", "Extract only bytes OFFSET:LENGTH of a single file to stdout").StoreValue(range);
+    auto& block_size_arg = arg_parser.AddIntArgument('b', "block-size", "Encoding block size for all files, bytes (asked for each file if not set)");
+    block_size_arg.Default(0);
+    block_size_arg.StoreValue(block_size);
+    auto& stdin_name_arg = arg_parser.AddStringArgument("stdin-name", "Name in the archive for data read from stdin ('-' file)");
+    stdin_name_arg.Default("stdin");
+    stdin_name_arg.StoreValue(stdin_name);
     arg_parser.AddHelp('h', "help", "Hamming-based archiver");
 }
 
-std::vector<HamArchiver::FileMetadata> BuildFileList() {
+std::vector<HamArchiver::FileMetadata> BuildFileList(std::ostream& log) {
     std::vector<HamArchiver::FileMetadata> file_list(files.size());
-    std::cout << "Enter block sizes for encoding\n";
+    if (block_size > 0) {
+        for (size_t i = 0; i < files.size(); ++i) {
+            file_list[i].path = files[i];
+            file_list[i].encoding_block_size = block_size;
+        }
+        return file_list;
+    }
+    log << "Enter block sizes for encoding\n";
     for (size_t i = 0; i < files.size(); ++i) {
         file_list[i].path = files[i];
         std::cin >> file_list[i].encoding_block_size;
@@ -39,29 +94,71 @@ std::vector<HamArchiver::FileMetadata> BuildFileList() {
     return file_list;
 }
 
+// Данные читаются из stdin, поэтому размер блока не запрашивается
+bool ReadsStdin() {
+    return files.size() == 1 && files[0] == "-";
+}
+
+// Архив выводится в stdout, поэтому сообщения выводятся в stderr
+bool WritesStdout() {
+    return arcfile == "-";
+}
+
+HamArchiver::FileMetadata BuildStdinMetadata() {
+    return HamArchiver::FileMetadata{stdin_name, 0, static_cast<size_t>(block_size)};
+}
+
 void ExecuteCreate() {
-    auto exit_codes = harchiver.Create(arcfile, BuildFileList());
+    std::ostream& log = WritesStdout() ? std::cerr : std::cout;
+    if (ReadsStdin()) {
+        auto exit_code = WritesStdout() 
+            ? harchiver.CreateFromStream(std::cout, BuildStdinMetadata(), std::cin)
+            : harchiver.CreateFromStream(arcfile, BuildStdinMetadata(), std::cin);
+        switch (exit_code) {
+            case HamArchiver::CreationResult::kSuccess:
+                log << "\"" << stdin_name << "\" - added\n";
+                return;
+            case HamArchiver::CreationResult::kArcAlreadyExists:
+                log << "\"" << arcfile << "\" already exists\n";
+                return;
+            case HamArchiver::CreationResult::kWriteError:
+                log << "Failed to write the archive\n";
+                return;
+            default:
+                log << "\"" << stdin_name << "\" - not accessible\n";
+                return;
+        }
+    }
+    auto exit_codes = WritesStdout() 
+        ? harchiver.Create(std::cout, BuildFileList(log))
+        : harchiver.Create(arcfile, BuildFileList(log));
 
     switch (exit_codes[0]) {
         case HamArchiver::CreationResult::kArcAlreadyExists:
-            std::cout << "\"" << arcfile << "\" already exists\n";
+            log << "\"" << arcfile << "\" already exists\n";
             return;
         case HamArchiver::CreationResult::kEmptyFileList:
-            std::cout << "Empty file list\n";
+            log << "Empty file list\n";
+            return;
+        case HamArchiver::CreationResult::kWriteError:
+            log << "Failed to write the archive\n";
             return;
     }
 
     for (size_t i = 0; i < exit_codes.size(); ++i) {
-        std::cout << "\"" << files[i] << "\" - ";
+        log << "\"" << files[i] << "\" - ";
         switch (exit_codes[i]) {
             case HamArchiver::CreationResult::kSuccess:
-                std::cout << "added\n";
+                log << "added\n";
                 continue;
             case HamArchiver::CreationResult::kFileNotFound:
-                std::cout << "not found\n";
+                log << "not found\n";
                 continue;
             case HamArchiver::CreationResult::kFileNotAccessible:
-                std::cout << "not accessible\n";
+                log << "not accessible\n";
+                continue;
+            case HamArchiver::CreationResult::kWriteError:
+                log << "write error\n";
         }
     }
 }
@@ -97,19 +194,104 @@ void BuildExtractionList() {
     }
 }
 
-void ExecuteExtract() {
+// Содержимое файлов выводится подряд в stdout, сообщения - в stderr
+bool ExecuteExtractToStdout() {
+    auto exit_codes = harchiver.ExtractTo(arcfile, files, std::cout);
+    std::cout.flush();
+    switch (exit_codes[0]) {
+        case HamArchiver::ExtractionResult::kArcNotFound:
+            std::cerr << "\"" << arcfile << "\" not found\n";
+            return false;
+        case HamArchiver::ExtractionResult::kEmptyFileList:
+            return true;
+    }
+
+    bool success = std::cout.good();
+    for (size_t i = 0; i < exit_codes.size(); ++i) {
+        switch (exit_codes[i]) {
+            case HamArchiver::ExtractionResult::kFileCorrupted:
+                std::cerr << "\"" << files[i] << "\" - corrupted, output truncated\n";
+                return false;
+            case HamArchiver::ExtractionResult::kFileNotFound:
+                std::cerr << "\"" << files[i] << "\" - not found\n";
+                success = false;
+                continue;
+            case HamArchiver::ExtractionResult::kArcCorrupted:
+                std::cerr << "\"" << files[i] << "\" - not found, archive corrupted\n";
+                success = false;
+                continue;
+        }
+    }
+
+    return success;
+}
+
+// Участок передаётся в stdout по блокам, поэтому память не зависит от его длины
+bool ExecuteReadRange() {
+    size_t separator = range.find(':');
+    std::string offset_str = range.substr(0, separator);
+    std::string length_str = separator == std::string::npos ? "" : range.substr(separator + 1);
+    size_t offset;
+    size_t length;
+    // std::stoull принимает знак минус и молча приводит "-1" к SIZE_MAX
+    bool valid = offset_str.find('-') == std::string::npos && length_str.find('-') == std::string::npos;
+    try {
+        offset = valid ? std::stoull(offset_str) : 0;
+        length = separator == std::string::npos || !valid ? SIZE_MAX : std::stoull(length_str);
+    } catch (const std::exception&) {
+        valid = false;
+    }
+    if (!valid) {
+        std::cerr << "Error: invalid range \"" << range << "\"\n";
+        return false;
+    }
+    auto exit_code = harchiver.ReadRange(arcfile, files[0], offset, length, 
+        [](const uint8_t* data, size_t size) {
+            std::cout.write(reinterpret_cast<const char*>(data), size);
+            return std::cout.good();
+        });
+    std::cout.flush();
+    switch (exit_code) {
+        case HamArchiver::ExtractionResult::kArcNotFound:
+            std::cerr << "\"" << arcfile << "\" not found\n";
+            return false;
+        case HamArchiver::ExtractionResult::kFileCorrupted:
+            std::cerr << "\"" << files[0] << "\" - corrupted, output truncated\n";
+            return false;
+        case HamArchiver::ExtractionResult::kFileNotFound:
+            std::cerr << "\"" << files[0] << "\" - not found\n";
+            return false;
+        case HamArchiver::ExtractionResult::kArcCorrupted:
+            std::cerr << "\"" << files[0] << "\" - not found, archive corrupted\n";
+            return false;
+    }
+
+    return true;
+}
+
+bool ExecuteExtract() {
+    if (!range.empty()) {
+        if (files.size() != 1) {
+            std::cerr << "Error: --range requires exactly one file\n";
+            return false;
+        }
+        return ExecuteReadRange();
+    }
     if (files.empty()) {
         BuildExtractionList();
     }
+    if (to_stdout) {
+        return ExecuteExtractToStdout();
+    }
     auto exit_codes = harchiver.ExtractFiles(arcfile, files);
 
     switch (exit_codes[0]) {
         case HamArchiver::ExtractionResult::kArcNotFound:
             std::cout << "\"" << arcfile << "\" not found\n";
-            return;
+            return true;
         case HamArchiver::ExtractionResult::kEmptyFileList:
             std::cout << "Archive corrupted. No files can be extracted\n";
-            return;
+            return true;
     }
 
     if (exit_codes.back() == HamArchiver::ExtractionResult::kArcCorrupted) {
@@ -128,10 +310,25 @@ void ExecuteExtract() {
                 std::cout << "not found\n";
         } 
     }
+
+    return true;
 }
 
 void ExecuteAppend() {
-    auto exit_codes = harchiver.AppendFiles(arcfile, BuildFileList());
+    if (ReadsStdin()) {
+        switch (harchiver.AppendStream(arcfile, BuildStdinMetadata(), std::cin)) {
+            case HamArchiver::AdditionResult::kSuccess:
+                std::cout << "\"" << stdin_name << "\" - added\n";
+                return;
+            case HamArchiver::AdditionResult::kArcNotFound:
+                std::cout << "\"" << arcfile << "\" not found\n";
+                return;
+            default:
+                std::cout << "\"" << stdin_name << "\" - not accessible\n";
+                return;
+        }
+    }
+    auto exit_codes = harchiver.AppendFiles(arcfile, BuildFileList(std::cout));
 
     switch (exit_codes[0]) {
         case HamArchiver::AdditionResult::kArcNotFound:
@@ -153,6 +350,9 @@ void ExecuteAppend() {
                 continue;
             case HamArchiver::AdditionResult::kFileNotAccessible:
                 std::cout << "not accessible\n";
+                continue;
+            case HamArchiver::AdditionResult::kWriteError:
+                std::cout << "write error\n";
         }
     }
 }
@@ -183,10 +383,118 @@ void ExecuteDelete() {
                 continue;
             case HamArchiver::ExtractionResult::kFileNotFound:
                 std::cout << "not found\n";
+                continue;
+            case HamArchiver::ExtractionResult::kWriteError:
+                std::cout << "write error\n";
         } 
     }
 }
 
+void ExecuteVacuum() {
+    switch (harchiver.Vacuum(arcfile, vacuum_threshold / 100.0)) {
+        case HamArchiver::VacuumResult::kSuccess:
+            std::cout << "\"" << arcfile << "\" compacted\n";
+            return;
+        case HamArchiver::VacuumResult::kArcNotFound:
+            std::cout << "\"" << arcfile << "\" not found\n";
+            return;
+        case HamArchiver::VacuumResult::kArcCorrupted:
+            std::cout << "Archive corrupted\n";
+            return;
+        case HamArchiver::VacuumResult::kBelowThreshold:
+            std::cout << "Deleted data below threshold, nothing to do\n";
+            return;
+        case HamArchiver::VacuumResult::kWriteError:
+            std::cout << "Failed to write the archive, run vacuum again to resume\n";
+            return;
+    }
+}
+
+void PrintBlockCounts(const HamArchiver::BlockCounts& blocks) {
+    std::cout << "blocks: " << blocks.clean << " clean, " << blocks.corrected << " correctable, " 
+        << blocks.corrupted << " corrupted\n";
+}
+
+bool ExecuteVerify() {
+    HamArchiver::VerificationReport report;
+    auto exit_code = harchiver.Verify(arcfile, report);
+    if (exit_code == HamArchiver::VerificationResult::kArcNotFound) {
+        std::cout << "\"" << arcfile << "\" not found\n";
+        return false;
+    }
+
+    for (size_t i = 0; i < report.entries.size(); ++i) {
+        const HamArchiver::BlockCounts& blocks = report.entries[i].blocks;
+        std::cout << report.entries[i].metadata.path << " - ";
+        if (blocks.corrupted != 0) {
+            std::cout << "corrupted, ";
+        } else if (blocks.corrected != 0) {
+            std::cout << "correctable, ";
+        } else {
+            std::cout << "ok, ";
+        }
+        PrintBlockCounts(blocks);
+    }
+    const HamArchiver::BlockCounts& index = report.index;
+    if (index.clean + index.corrected + index.corrupted != 0) {
+        std::cout << "Index - ";
+        PrintBlockCounts(index);
+    }
+    switch (exit_code) {
+        case HamArchiver::VerificationResult::kSuccess:
+            std::cout << "No unrecoverable errors found\n";
+            return true;
+        case HamArchiver::VerificationResult::kArcCorrupted:
+            std::cout << "Archive corrupted. Files found: " << report.entries.size() << "\n";
+            return false;
+        default:
+            std::cout << "Some files are corrupted\n";
+            return false;
+    }
+}
+
+bool ExecuteScrub() {
+    std::vector<std::filesystem::path> arcfiles{arcfile};
+    arcfiles.insert(arcfiles.end(), files.begin(), files.end());
+    HamArchiver::ScrubOptions options;
+    options.max_rate = static_cast<size_t>(scrub_rate_mb) * 1024 * 1024;
+    options.idle_priority = idle_io;
+    std::vector<HamArchiver::ScrubReport> reports;
+    auto exit_codes = harchiver.Scrub(arcfiles, options, reports);
+
+    bool success = true;
+    for (size_t i = 0; i < arcfiles.size(); ++i) {
+        std::cout << arcfiles[i] << " - ";
+        if (exit_codes[i] == HamArchiver::ScrubResult::kArcNotFound) {
+            std::cout << "not found\n";
+            success = false;
+            continue;
+        }
+        switch (exit_codes[i]) {
+            case HamArchiver::ScrubResult::kSuccess:
+                std::cout << "ok, ";
+                break;
+            case HamArchiver::ScrubResult::kArcCorrupted:
+                std::cout << "archive corrupted, ";
+                break;
+            case HamArchiver::ScrubResult::kFileCorrupted:
+                std::cout << "unrecoverable errors, ";
+                break;
+            default:
+                std::cout << "failed to write corrections, ";
+        }
+        success = success && exit_codes[i] == HamArchiver::ScrubResult::kSuccess;
+        if (reports[i].resumed_offset != 0) {
+            std::cout << "resumed at " << reports[i].resumed_offset << ", ";
+        }
+        const HamArchiver::BlockCounts& blocks = reports[i].blocks;
+        std::cout << "blocks: " << blocks.clean << " clean, " << blocks.corrected << " corrected, " 
+            << blocks.corrupted << " corrupted\n";
+    }
+
+    return success;
+}
+
 void ExecuteMerge() {
     auto exit_codes = harchiver.Merge(arcfile, files);
 
@@ -197,6 +505,9 @@ void ExecuteMerge() {
         case HamArchiver::ConcatenationResult::kEmptyFileList:
             std::cout << "Empty file list\n";
             return;
+        case HamArchiver::ConcatenationResult::kWriteError:
+            std::cout << "Failed to write the archive\n";
+            return;
     }
 
     for (size_t i = 0; i < files.size(); ++i) {
@@ -212,15 +523,53 @@ void ExecuteMerge() {
 }
 
 bool ExecuteCommands() {
+    if (io_engine == "uring") {
+        harchiver.SetStorage(std::make_shared<UringFileOperator>(std::filesystem::current_path()));
+    } else if (io_engine == "direct") {
+        harchiver.SetStorage(std::make_shared<DirectFileOperator>(std::filesystem::current_path()));
+    } else if (io_engine != "sync") {
+        std::cerr << "Error: unknown I/O engine\n";
+        return false;
+    }
     if (!working_dir.empty()) {
         harchiver.SetDir(working_dir);
     }
+    harchiver.SetWriteIndex(!no_index);
+    if (threads_count < -1 || inflight_memory_mb <= 0 || scrub_rate_mb < 0) {
+        std::cerr << "Error: invalid encoding parameters\n";
+        return false;
+    }
+    // Проверка только читает архив, поэтому по умолчанию занимает все ядра
+    if (threads_count == -1) {
+        threads_count = exec_verify ? 0 : 1;
+    }
+    harchiver.SetThreads(threads_count);
+    harchiver.SetMaxInflightMemory(static_cast<size_t>(inflight_memory_mb) * 1024 * 1024);
+    harchiver.SetMetricsEnabled(print_stats);
+    if (block_size < 0) {
+        std::cerr << "Error: invalid block size\n";
+        return false;
+    }
+    if ((exec_create || exec_append) && ReadsStdin() && block_size == 0) {
+        std::cerr << "Error: --block-size is required to read from stdin\n";
+        return false;
+    }
+    if ((exec_create || exec_append) && !ReadsStdin() 
+        && std::find(files.begin(), files.end(), "-") != files.end()) {
+        std::cerr << "Error: '-' must be the only file\n";
+        return false;
+    }
 
     if (arcfile.empty()) {
         std::cerr << "Error: arcfile name not set\n";
         return false;
     }
 
+    if (WritesStdout() && !exec_create) {
+        std::cerr << "Error: only a created archive can be written to stdout\n";
+        return false;
+    }
+
     if (exec_create) {
         ExecuteCreate();
         return true;
@@ -230,8 +579,7 @@ bool ExecuteCommands() {
         return true;
     }
     if (exec_extract) {
-        ExecuteExtract();
-        return true;
+        return ExecuteExtract();
     }
     if (exec_append) {
         ExecuteAppend();
@@ -245,6 +593,16 @@ bool ExecuteCommands() {
         ExecuteMerge();
         return true;
     }
+    if (exec_vacuum) {
+        ExecuteVacuum();
+        return true;
+    }
+    if (exec_verify) {
+        return ExecuteVerify();
+    }
+    if (exec_scrub) {
+        return ExecuteScrub();
+    }
 
     std::cerr << "Error: No known command specified\n";
     return false;
@@ -258,7 +616,10 @@ int main(int argc, char** argv) {
         std::cout << arg_parser.HelpDescription();
         return 0;
     }
-    if (!ExecuteCommands()) return 1;
+    bool success = ExecuteCommands();
+    if (print_stats) {
+        std::cerr << harchiver.GetMetrics().ToJson();
+    }
 
-    return 0;
+    return success ? 0 : 1;
 }
@@ -63,3 +63,26 @@ INSTANTIATE_TEST_SUITE_P(
         )
     )
 );
+
+TEST(CopyRangeTest, CopyIntoOffset) {
+    std::filesystem::copy_file(TestingDir / "in_2.txt", TestingDir / "tmp.txt", 
+        std::filesystem::copy_options::overwrite_existing);
+    size_t size = std::filesystem::file_size(TestingDir / "in_3.txt");
+    std::filesystem::resize_file(TestingDir / "tmp.txt", 3 + size);
+
+    ASSERT_EQ(
+        Copydata::CopyRange(TestingDir / "in_3.txt", 0, TestingDir / "tmp.txt", 3, size), 
+        Copydata::CopyingResult::kSuccess
+    );
+
+    std::ifstream src(TestingDir / "in_3.txt", std::ios::binary);
+    std::ifstream dst(TestingDir / "tmp.txt", std::ios::binary);
+    dst.seekg(3);
+    std::string expected(size, '\0');
+    std::string copied(size, '\0');
+    src.read(expected.data(), size);
+    dst.read(copied.data(), size);
+    ASSERT_EQ(expected, copied);
+
+    std::filesystem::remove(TestingDir / "tmp.txt");
+}
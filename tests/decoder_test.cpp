@@ -87,6 +87,76 @@ TEST_P(ValidationTestSuite, ValidationTest) {
     std::filesystem::remove(TestingDir / "tmp.txt");
 }
 
+TEST_P(ValidationTestSuite, BufferValidationTest) {
+    size_t data_size = std::get<2>(GetParam());
+    size_t code_size = (std::get<3>(GetParam()) - 1) / 8 + 1;
+    MakeCopy(std::get<0>(GetParam()), std::get<1>(GetParam()), data_size + code_size);
+
+    size_t err_1 = std::get<4>(GetParam());
+    size_t err_2 = std::get<5>(GetParam());
+    MakeErrors("tmp.txt", err_1, err_2);
+    uint8_t* buf = new uint8_t[data_size + code_size];
+    std::ifstream in(TestingDir / "tmp.txt", std::fstream::binary);
+    in.read(reinterpret_cast<char*>(buf), data_size + code_size);
+    in.close();
+    Decoder::ValidationResult exit_code = Decoder::Validate(buf, data_size, buf + data_size);
+    
+    if (err_1 == -1 && err_2 == -1) {
+        ASSERT_EQ(exit_code, Decoder::ValidationResult::kValid);
+    } else if (err_1 != -1 && err_2 != -1) {
+        ASSERT_EQ(exit_code, Decoder::ValidationResult::kDoubleError);
+    } else {
+        ASSERT_EQ(exit_code, Decoder::ValidationResult::kSingleErrorFixed);
+    }
+
+    if (err_1 == -1 || err_2 == -1) {
+        uint8_t* expected = new uint8_t[data_size];
+        std::ifstream original(TestingDir / std::get<0>(GetParam()), std::fstream::binary);
+        original.seekg(std::get<1>(GetParam()), std::ifstream::beg);
+        original.read(reinterpret_cast<char*>(expected), data_size);
+        for (size_t i = 0; i < data_size; ++i) {
+            ASSERT_EQ(buf[i], expected[i]);
+        }
+        delete [] expected;
+    }
+    delete [] buf;
+    
+    std::filesystem::remove(TestingDir / "tmp.txt");
+}
+
+TEST_P(ValidationTestSuite, ReadOnlyValidationTest) {
+    size_t data_size = std::get<2>(GetParam());
+    size_t code_size = (std::get<3>(GetParam()) - 1) / 8 + 1;
+    MakeCopy(std::get<0>(GetParam()), std::get<1>(GetParam()), data_size + code_size);
+
+    size_t err_1 = std::get<4>(GetParam());
+    size_t err_2 = std::get<5>(GetParam());
+    MakeErrors("tmp.txt", err_1, err_2);
+    uint8_t* buf = new uint8_t[data_size + code_size];
+    std::ifstream in(TestingDir / "tmp.txt", std::fstream::binary);
+    in.read(reinterpret_cast<char*>(buf), data_size + code_size);
+    in.close();
+    size_t error_bit;
+    Decoder::ValidationResult exit_code = Decoder::Validate(
+        const_cast<const uint8_t*>(buf), data_size, buf + data_size, error_bit);
+
+    if (err_1 == -1 && err_2 == -1) {
+        ASSERT_EQ(exit_code, Decoder::ValidationResult::kValid);
+        ASSERT_EQ(error_bit, Decoder::kNoDataError);
+    } else if (err_1 != -1 && err_2 != -1) {
+        ASSERT_EQ(exit_code, Decoder::ValidationResult::kDoubleError);
+        ASSERT_EQ(error_bit, Decoder::kNoDataError);
+    } else {
+        // Ошибочный бит указывается, только если он в информационной части
+        size_t err = err_1 != -1 ? err_1 : err_2;
+        ASSERT_EQ(exit_code, Decoder::ValidationResult::kSingleErrorFixed);
+        ASSERT_EQ(error_bit, err < data_size * 8 ? err : Decoder::kNoDataError);
+    }
+    delete [] buf;
+    
+    std::filesystem::remove(TestingDir / "tmp.txt");
+}
+
 INSTANTIATE_TEST_SUITE_P(
     Group,
     ValidationTestSuite,
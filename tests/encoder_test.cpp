@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 
 #include "hamarc/Encoder.hpp"
+#include "hamarc/HammingKernel.hpp"
 #include "FileComparator.hpp"
 
 static const std::filesystem::path TestingDir{"./tests/data/encoder_test"};
@@ -86,3 +87,162 @@ INSTANTIATE_TEST_SUITE_P(
         )
     )
 );
+
+// Вычисление кода по определению: позиции информационных бит пропускают степени двойки
+static std::vector<uint8_t> GetReferenceCode(const std::vector<uint8_t>& msg) {
+    size_t code_bit_size = Encoder::GetCodeBitSize(msg.size() * 8);
+    std::vector<uint8_t> code(code_bit_size / 8 + 1, 0);
+    size_t syndrome = 0;
+    bool parity_bit = false;
+    size_t pos = 2;
+    for (size_t j = 0; j < msg.size() * 8; ++j) {
+        ++pos;
+        while ((pos & (pos - 1)) == 0) {
+            ++pos;
+        }
+        if (BitOperator::GetBit(msg[j / 8], j % 8)) {
+            syndrome ^= pos;
+            parity_bit ^= true;
+        }
+    }
+    for (size_t i = 0; i < code_bit_size; ++i) {
+        if ((syndrome >> i) & 1) {
+            BitOperator::SetBit(code[i / 8], i % 8);
+            parity_bit ^= true;
+        }
+    }
+    if (parity_bit) {
+        BitOperator::SetBit(code.back(), code_bit_size % 8);
+    }
+
+    return code;
+}
+
+class WordEncodingTestSuite : public testing::TestWithParam<size_t> {};
+
+TEST_P(WordEncodingTestSuite, WordEncodingTest) {
+    size_t msg_size = GetParam();
+    std::vector<uint8_t> msg(msg_size);
+    srand(msg_size);
+    for (size_t i = 0; i < msg_size; ++i) {
+        msg[i] = rand() % 256;
+    }
+
+    std::vector<uint8_t> expected = GetReferenceCode(msg);
+    uint8_t* code = Encoder::GetCode(msg.data(), msg_size);
+    for (size_t i = 0; i < expected.size(); ++i) {
+        ASSERT_EQ(code[i], expected[i]);
+    }
+    delete [] code;
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Group,
+    WordEncodingTestSuite,
+    testing::Values(1, 2, 3, 7, 8, 9, 57, 63, 64, 65, 127, 128, 129, 1000, 4096, 65536)
+);
+
+class KernelTestSuite : public testing::TestWithParam<HammingKernel::Type> {};
+
+TEST_P(KernelTestSuite, KernelTest) {
+    if (!HammingKernel::IsSupported(GetParam())) {
+        GTEST_SKIP();
+    }
+    HammingKernel::Type prev_type = HammingKernel::GetActive();
+    ASSERT_TRUE(HammingKernel::Select(GetParam()));
+
+    const size_t kSizes[] = {1, 16, 65, 130, 1000, 4096, 65537};
+    for (size_t msg_size : kSizes) {
+        std::vector<uint8_t> msg(msg_size);
+        srand(msg_size);
+        for (size_t i = 0; i < msg_size; ++i) {
+            msg[i] = rand() % 256;
+        }
+        uint8_t xor_byte = 0;
+        for (size_t i = 0; i < msg_size; ++i) {
+            xor_byte ^= msg[i];
+        }
+        ASSERT_EQ(HammingKernel::XorBytes(msg.data(), msg_size), xor_byte);
+
+        std::vector<uint8_t> expected = GetReferenceCode(msg);
+        uint8_t* code = Encoder::GetCode(msg.data(), msg_size);
+        for (size_t i = 0; i < expected.size(); ++i) {
+            ASSERT_EQ(code[i], expected[i]);
+        }
+        delete [] code;
+    }
+    HammingKernel::Select(prev_type);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Group,
+    KernelTestSuite,
+    testing::Values(
+        HammingKernel::Type::kScalar,
+        HammingKernel::Type::kSSE42,
+        HammingKernel::Type::kAVX2,
+        HammingKernel::Type::kAVX512
+    )
+);
+
+// Буфер чтения без поддержки перемещения позиции, как у канала
+class PipeBuf : public std::streambuf {
+public:
+    PipeBuf(std::vector<uint8_t>& data) {
+        char* begin = reinterpret_cast<char*>(data.data());
+        setg(begin, begin, begin + data.size());
+    }
+};
+
+TEST(BlockEncodingTest, NonSeekableInput) {
+    const size_t kDataSize = 10000;
+    const size_t kBlockSize = 3000;
+    std::vector<uint8_t> data(kDataSize);
+    srand(kDataSize);
+    for (size_t i = 0; i < kDataSize; ++i) {
+        data[i] = rand() % 256;
+    }
+    PipeBuf pipe_buf(data);
+    std::istream in(&pipe_buf);
+    std::ostringstream out;
+
+    ASSERT_EQ(Encoder::EncodeBlocks(in, out, kDataSize, kBlockSize), 
+        Encoder::EncodingResult::kSuccess);
+
+    std::string expected;
+    for (size_t i = 0; i < kDataSize; i += kBlockSize) {
+        size_t cur_block_size = std::min(kBlockSize, kDataSize - i);
+        std::vector<uint8_t> block(data.begin() + i, data.begin() + i + cur_block_size);
+        std::vector<uint8_t> code = GetReferenceCode(block);
+        expected.append(block.begin(), block.end());
+        expected.append(code.begin(), code.end());
+    }
+    ASSERT_EQ(out.str(), expected);
+}
+
+TEST(BlockEncodingTest, ContextReuse) {
+    EncoderContext context(4096);
+    uint8_t* buffer = context.GetBuffer();
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(buffer) % EncoderContext::kAlignment, 0);
+
+    const size_t kSizes[] = {4096, 100, 1, 4000};
+    for (size_t data_size : kSizes) {
+        std::vector<uint8_t> data(data_size);
+        srand(data_size);
+        for (size_t i = 0; i < data_size; ++i) {
+            data[i] = rand() % 256;
+        }
+        PipeBuf pipe_buf(data);
+        std::istream in(&pipe_buf);
+        std::ostringstream out;
+        ASSERT_EQ(Encoder::EncodeBlocks(in, out, data_size, data_size, context), 
+            Encoder::EncodingResult::kSuccess);
+
+        std::vector<uint8_t> code = GetReferenceCode(data);
+        std::string expected(data.begin(), data.end());
+        expected.append(code.begin(), code.end());
+        ASSERT_EQ(out.str(), expected);
+        // Блоки не больше зарезервированного не приводят к выделению памяти
+        ASSERT_EQ(context.GetBuffer(), buffer);
+    }
+}
@@ -1,14 +1,18 @@
 #include <gtest/gtest.h>
 #include <filesystem>
 #include <cstdint>
+#include <sstream>
 
 #include "hamarc/HamArchiver.hpp"
 #include "hamarc/Copydata.hpp"
-#include "hamarc/FileOperator.hpp"
+#include "hamarc/DiskFileOperator.hpp"
+#include "hamarc/DirectFileOperator.hpp"
+#include "hamarc/MemoryFileOperator.hpp"
+#include "hamarc/UringFileOperator.hpp"
 #include "FileComparator.hpp"
 
 static const std::filesystem::path TestingDir{"./tests/data/hamarchiver_test"};
-static FileOperator fo(TestingDir);
+static StreamFileOperator fo(TestingDir);
 static FileComparator fc(TestingDir);
 
 static void MakeBitError(std::fstream& msg, std::streamoff error_bit_pos) {
@@ -51,7 +55,10 @@ TEST_P(PackingTestSuite, PackingTest) {
     MakeErrors("tmp/testarc.haf", std::get<1>(GetParam()));
 
     harchiver.SetDir(TestingDir / "tmp");
+    std::filesystem::copy_file(TestingDir / "tmp/testarc.haf", TestingDir / "tmp/testarc_copy.haf");
     auto exit_codes = harchiver.ExtractFiles("testarc.haf");
+    // Извлечение не изменяет архив
+    ASSERT_TRUE(fc.Equals("tmp/testarc.haf", "tmp/testarc_copy.haf"));
     const std::vector<HamArchiver::ExtractionResult> expected = std::get<2>(GetParam());
 
     ASSERT_EQ(exit_codes.size(), expected.size());
@@ -64,8 +71,12 @@ TEST_P(PackingTestSuite, PackingTest) {
     }
 
     for (size_t i = 0; i < file_list.size(); ++i) {
-        if (expected[0] == HamArchiver::ExtractionResult::kArcCorrupted 
-        || expected[i] == HamArchiver::ExtractionResult::kFileCorrupted) {
+        if (expected[0] == HamArchiver::ExtractionResult::kArcCorrupted) {
+            continue;
+        }
+        if (expected[i] == HamArchiver::ExtractionResult::kFileCorrupted) {
+            // Частично извлечённый файл не остаётся в директории
+            ASSERT_FALSE(fo.FileExists("tmp" / file_list[i].path));
             continue;
         }
         ASSERT_TRUE(fo.FileExists("tmp" / file_list[i].path));
@@ -121,3 +132,879 @@ INSTANTIATE_TEST_SUITE_P(
         // )
     )
 );
+
+static void ExpectFileList(HamArchiver& harchiver, std::filesystem::path arcfile,
+    const std::vector<std::string>& expected) {
+
+    auto list = harchiver.GetFileList(arcfile);
+    ASSERT_EQ(list.size(), expected.size());
+    for (size_t i = 0; i < list.size(); ++i) {
+        ASSERT_EQ(list[i].path.string(), expected[i]);
+        ASSERT_EQ(list[i].size, fo.GetFileSize(expected[i]));
+    }
+}
+
+TEST(IndexTestSuite, IndexTest) {
+    HamArchiver harchiver(TestingDir);
+    fo.CreateDir("tmp");
+    harchiver.Create("tmp/indexed.haf", {{"file_1.txt", 0, 10}, {"file_2.txt", 0, 37}});
+    harchiver.SetWriteIndex(false);
+    harchiver.Create("tmp/plain.haf", {{"file_1.txt", 0, 10}, {"file_2.txt", 0, 37}});
+    harchiver.SetWriteIndex(true);
+    ASSERT_GT(fo.GetFileSize("tmp/indexed.haf"), fo.GetFileSize("tmp/plain.haf"));
+    ExpectFileList(harchiver, "tmp/indexed.haf", {"file_1.txt", "file_2.txt"});
+    ExpectFileList(harchiver, "tmp/plain.haf", {"file_1.txt", "file_2.txt"});
+
+    harchiver.AppendFiles("tmp/indexed.haf", {{"file_3.txt", 0, 100}});
+    ExpectFileList(harchiver, "tmp/indexed.haf", {"file_1.txt", "file_2.txt", "file_3.txt"});
+    harchiver.DeleteFiles("tmp/indexed.haf", {"file_2.txt"});
+    ExpectFileList(harchiver, "tmp/indexed.haf", {"file_1.txt", "file_3.txt"});
+    harchiver.Merge("tmp/merged.haf", {"tmp/indexed.haf", "tmp/plain.haf"});
+    ExpectFileList(harchiver, "tmp/merged.haf", 
+        {"file_1.txt", "file_3.txt", "file_1.txt", "file_2.txt"});
+    // Добавление в архив без оглавления не обрезает его записи
+    harchiver.AppendFiles("tmp/plain.haf", {{"file_3.txt", 0, 100}});
+    ExpectFileList(harchiver, "tmp/plain.haf", {"file_1.txt", "file_2.txt", "file_3.txt"});
+    HamArchiver::VerificationReport plain_report;
+    ASSERT_EQ(harchiver.Verify("tmp/plain.haf", plain_report), HamArchiver::VerificationResult::kSuccess);
+
+    // Двойная ошибка в оглавлении: список файлов получается просмотром архива
+    size_t arc_size = fo.GetFileSize("tmp/indexed.haf");
+    std::fstream stream(TestingDir / "tmp/indexed.haf", 
+        std::fstream::in | std::fstream::out | std::fstream::binary);
+    MakeBitError(stream, (arc_size - 40) * 8);
+    MakeBitError(stream, (arc_size - 40) * 8 + 1);
+    stream.close();
+    ExpectFileList(harchiver, "tmp/indexed.haf", {"file_1.txt", "file_3.txt"});
+
+    harchiver.SetDir(TestingDir / "tmp");
+    auto exit_codes = harchiver.ExtractFiles("indexed.haf", {"file_3.txt"});
+    ASSERT_EQ(exit_codes.size(), 1);
+    ASSERT_EQ(exit_codes[0], HamArchiver::ExtractionResult::kSuccess);
+    ASSERT_TRUE(fc.Equals("file_3.txt", "tmp/file_3.txt"));
+    fo.DeleteDir("tmp");
+}
+
+TEST(ParallelEncodingTestSuite, ParallelEncodingTest) {
+    const std::vector<HamArchiver::FileMetadata> file_list{
+        {"file_3.txt", 0, 7},
+        {"Лев_Толстой._Война_и_мир._Том_I.txt", 0, 4096},
+        {"file_1.txt", 0, 10}
+    };
+    HamArchiver harchiver(TestingDir);
+    fo.CreateDir("tmp");
+    harchiver.Create("tmp/sequential.haf", file_list);
+    harchiver.SetThreads(4);
+    // Небольшой объём памяти: каждый пакет вмещает лишь несколько блоков
+    harchiver.SetMaxInflightMemory(64 * 1024);
+    harchiver.Create("tmp/parallel.haf", file_list);
+    ASSERT_TRUE(fc.Equals("tmp/sequential.haf", "tmp/parallel.haf"));
+
+    harchiver.SetThreads(0);
+    harchiver.AppendFiles("tmp/parallel.haf", {{"file_2.txt", 0, 3}});
+    harchiver.SetThreads(1);
+    harchiver.AppendFiles("tmp/sequential.haf", {{"file_2.txt", 0, 3}});
+    ASSERT_TRUE(fc.Equals("tmp/sequential.haf", "tmp/parallel.haf"));
+    fo.DeleteDir("tmp");
+}
+
+// Хранилище, сообщающее размер больше настоящего: файл заканчивается раньше ожидаемого
+class ShrunkFileOperator : public MemoryFileOperator {
+public:
+    size_t GetFileSize(std::filesystem::path filename) override {
+        return MemoryFileOperator::GetFileSize(filename) + 1000;
+    }
+};
+
+TEST(ParallelEncodingTestSuite, EncodingFailureTest) {
+    std::shared_ptr<ShrunkFileOperator> storage = std::make_shared<ShrunkFileOperator>();
+    storage->WriteFile("data.bin", std::string(5000, 'd'));
+    storage->WriteFile("next.bin", "next");
+    HamArchiver harchiver(storage);
+    for (size_t threads : {1, 4}) {
+        harchiver.SetThreads(threads);
+        storage->DeleteFile("arc.haf");
+        ASSERT_EQ(harchiver.Create("arc.haf", {{"data.bin", 0, 100}, {"next.bin", 0, 100}}), 
+            std::vector<HamArchiver::CreationResult>(2, HamArchiver::CreationResult::kWriteError));
+    }
+}
+
+// Хранилище, в котором копирование участков не удаётся
+class FailingCopyFileOperator : public MemoryFileOperator {
+public:
+    bool CopyRange(std::filesystem::path, size_t, std::filesystem::path, size_t, size_t) override {
+        return false;
+    }
+};
+
+TEST(MergeTestSuite, CopyFailureTest) {
+    std::shared_ptr<FailingCopyFileOperator> storage = std::make_shared<FailingCopyFileOperator>();
+    storage->WriteFile("data.bin", "data");
+    HamArchiver harchiver(storage);
+    harchiver.Create("first.haf", {{"data.bin", 0, 2}});
+    harchiver.Create("second.haf", {{"data.bin", 0, 3}});
+    harchiver.SetThreads(2);
+    ASSERT_EQ(harchiver.Merge("merged.haf", {"first.haf", "second.haf"}), 
+        std::vector<HamArchiver::ConcatenationResult>{HamArchiver::ConcatenationResult::kWriteError});
+    ASSERT_FALSE(storage->FileExists("merged.haf"));
+}
+
+TEST(MetricsTestSuite, MetricsTest) {
+    HamArchiver harchiver(TestingDir);
+    harchiver.SetWriteIndex(false);
+    fo.CreateDir("tmp");
+    // По умолчанию метрики не собираются
+    harchiver.Create("tmp/testarc.haf", {{"file_3.txt", 0, 7}});
+    ASSERT_EQ(harchiver.GetMetrics().Get(Metrics::Counter::kRawBytes), 0);
+    fo.DeleteFile("tmp/testarc.haf");
+
+    harchiver.SetMetricsEnabled(true);
+    harchiver.Create("tmp/testarc.haf", {{"file_3.txt", 0, 7}});
+    const Metrics& metrics = harchiver.GetMetrics();
+    size_t file_size = fo.GetFileSize("file_3.txt");
+    size_t blocks_count = (file_size + 6) / 7;
+    ASSERT_EQ(metrics.Get(Metrics::Counter::kRawBytes), file_size);
+    ASSERT_EQ(metrics.Get(Metrics::Counter::kBlocksEncoded), blocks_count);
+    ASSERT_EQ(metrics.GetPhaseTime(Metrics::Phase::kEncoding).calls, 1);
+
+    // Код блока из 7 байт занимает 1 байт: предпоследний байт архива - данные последнего блока
+    harchiver.GetMetrics().Reset();
+    MakeErrors("tmp/testarc.haf", {fo.GetFileSize("tmp/testarc.haf") - 2});
+    harchiver.SetDir(TestingDir / "tmp");
+    harchiver.ExtractFiles("testarc.haf");
+    ASSERT_EQ(metrics.Get(Metrics::Counter::kRawBytes), file_size);
+    ASSERT_GE(metrics.Get(Metrics::Counter::kBlocksValidated), blocks_count);
+    ASSERT_EQ(metrics.Get(Metrics::Counter::kSingleErrorsFixed), 1);
+    ASSERT_EQ(metrics.Get(Metrics::Counter::kDoubleErrors), 0);
+    ASSERT_EQ(metrics.GetPhaseTime(Metrics::Phase::kExtraction).calls, 1);
+    ASSERT_NE(metrics.ToJson().find("\"single_errors_fixed\": 1"), std::string::npos);
+    fo.DeleteDir("tmp");
+}
+
+TEST(StreamExtractionTestSuite, StreamExtractionTest) {
+    HamArchiver harchiver(TestingDir);
+    fo.CreateDir("tmp");
+    harchiver.Create("tmp/testarc.haf", {{"file_1.txt", 0, 10}, {"file_3.txt", 0, 7}});
+
+    std::ostringstream out;
+    ASSERT_EQ(harchiver.ExtractTo("tmp/testarc.haf", "file_3.txt", out), 
+        HamArchiver::ExtractionResult::kSuccess);
+    std::ifstream original(TestingDir / "file_3.txt", std::ios::binary);
+    std::string expected{std::istreambuf_iterator<char>(original), std::istreambuf_iterator<char>()};
+    ASSERT_EQ(out.str(), expected);
+    // Извлечение в поток не создаёт файлов
+    ASSERT_FALSE(fo.FileExists("tmp/file_3.txt"));
+
+    size_t received = 0;
+    ASSERT_EQ(harchiver.ExtractTo("tmp/testarc.haf", "file_1.txt", 
+        [&received](const uint8_t*, size_t size) {
+            received += size;
+            return true;
+        }), HamArchiver::ExtractionResult::kSuccess);
+    ASSERT_EQ(received, fo.GetFileSize("file_1.txt"));
+    ASSERT_EQ(harchiver.ExtractTo("tmp/testarc.haf", "file_2.txt", out), 
+        HamArchiver::ExtractionResult::kFileNotFound);
+
+    // Несколько файлов подряд за одно чтение оглавления
+    std::ostringstream joined;
+    std::vector<HamArchiver::ExtractionResult> expected_codes{
+        HamArchiver::ExtractionResult::kSuccess, HamArchiver::ExtractionResult::kFileNotFound, 
+        HamArchiver::ExtractionResult::kSuccess};
+    ASSERT_EQ(harchiver.ExtractTo("tmp/testarc.haf", {"file_3.txt", "file_2.txt", "file_3.txt"}, joined), 
+        expected_codes);
+    ASSERT_EQ(joined.str(), expected + expected);
+    fo.DeleteDir("tmp");
+}
+
+TEST(StreamedEntryTestSuite, StreamedEntryTest) {
+    // Данные неизвестной длины: две порции, вторая неполная
+    std::string data;
+    {
+        std::ifstream source(TestingDir / "Лев_Толстой._Война_и_мир._Том_I.txt", std::ifstream::binary);
+        std::string text{std::istreambuf_iterator<char>(source), std::istreambuf_iterator<char>()};
+        data = text + text;
+    }
+    fo.CreateDir("tmp");
+    HamArchiver harchiver(TestingDir);
+    std::istringstream reader(data);
+    ASSERT_EQ(harchiver.CreateFromStream("tmp/testarc.haf", {"stream.txt", 0, 4096}, reader), 
+        HamArchiver::CreationResult::kSuccess);
+    harchiver.AppendFiles("tmp/testarc.haf", {{"file_3.txt", 0, 7}});
+    MakeErrors("tmp/testarc.haf", {1000, 1024 * 1024 + 5000});
+
+    for (bool write_index : {true, false}) {
+        harchiver.SetWriteIndex(write_index);
+        if (!write_index) {
+            // Без оглавления порции находятся просмотром архива
+            std::istringstream no_index_reader(data);
+            harchiver.CreateFromStream("tmp/noindex.haf", {"stream.txt", 0, 4096}, no_index_reader);
+            harchiver.AppendFiles("tmp/noindex.haf", {{"file_3.txt", 0, 7}});
+        }
+        std::string arcfile = write_index ? "tmp/testarc.haf" : "tmp/noindex.haf";
+        auto list = harchiver.GetFileList(arcfile);
+        ASSERT_EQ(list.size(), 2);
+        ASSERT_EQ(list[0].size, data.size());
+        ASSERT_EQ(list[1].path, "file_3.txt");
+
+        std::ostringstream out;
+        ASSERT_EQ(harchiver.ExtractTo(arcfile, "stream.txt", out), 
+            HamArchiver::ExtractionResult::kSuccess);
+        ASSERT_TRUE(out.str() == data);
+    }
+
+    harchiver.SetWriteIndex(true);
+    harchiver.SetThreads(2);
+    harchiver.SetDir(TestingDir / "tmp");
+    ASSERT_EQ(harchiver.ExtractFiles("testarc.haf")[0], HamArchiver::ExtractionResult::kSuccess);
+    ASSERT_EQ(fo.GetFileSize("tmp/stream.txt"), data.size());
+    ASSERT_TRUE(fc.Equals("file_3.txt", "tmp/file_3.txt"));
+
+    harchiver.DeleteFiles("testarc.haf", {"stream.txt"});
+    ASSERT_EQ(harchiver.Vacuum("testarc.haf", 0.0), HamArchiver::VacuumResult::kSuccess);
+    auto list = harchiver.GetFileList("testarc.haf");
+    ASSERT_EQ(list.size(), 1);
+    ASSERT_EQ(list[0].path, "file_3.txt");
+    fo.DeleteDir("tmp");
+}
+
+TEST(ReadRangeTestSuite, ReadRangeTest) {
+    std::string text;
+    {
+        std::ifstream source(TestingDir / "Лев_Толстой._Война_и_мир._Том_I.txt", std::ifstream::binary);
+        text.assign(std::istreambuf_iterator<char>(source), std::istreambuf_iterator<char>());
+    }
+    fo.CreateDir("tmp");
+    HamArchiver harchiver(TestingDir);
+    harchiver.Create("tmp/testarc.haf", {{"Лев_Толстой._Война_и_мир._Том_I.txt", 0, 1000}});
+    std::string doubled = text + text;
+    std::istringstream reader(doubled);
+    harchiver.AppendStream("tmp/testarc.haf", {"stream.txt", 0, 1000}, reader);
+    harchiver.SetMetricsEnabled(true);
+
+    const std::vector<std::pair<size_t, size_t>> ranges{
+        {0, 10}, {999, 2}, {123456, 4096}, {text.size() - 5, 100}, {700000, 4096}
+    };
+    std::vector<uint8_t> buffer(4096);
+    size_t read_size;
+    harchiver.ReadRange("tmp/testarc.haf", "stream.txt", 0, 0, buffer.data(), read_size);
+    size_t index_blocks = harchiver.GetMetrics().Get(Metrics::Counter::kBlocksValidated);
+    for (const auto& [offset, length] : ranges) {
+        harchiver.GetMetrics().Reset();
+        ASSERT_EQ(harchiver.ReadRange("tmp/testarc.haf", "Лев_Толстой._Война_и_мир._Том_I.txt", 
+            offset, length, buffer.data(), read_size), HamArchiver::ExtractionResult::kSuccess);
+        std::string expected = text.substr(offset, length);
+        ASSERT_EQ(read_size, expected.size());
+        ASSERT_EQ(std::string(buffer.begin(), buffer.begin() + read_size), expected);
+        // Проверяются только блоки, покрывающие участок (и блоки оглавления)
+        size_t covering_blocks = (offset + read_size - 1) / 1000 - offset / 1000 + 1;
+        ASSERT_EQ(harchiver.GetMetrics().Get(Metrics::Counter::kBlocksValidated), 
+            index_blocks + covering_blocks);
+
+        ASSERT_EQ(harchiver.ReadRange("tmp/testarc.haf", "stream.txt", 
+            offset, length, buffer.data(), read_size), HamArchiver::ExtractionResult::kSuccess);
+        ASSERT_EQ(std::string(buffer.begin(), buffer.begin() + read_size), doubled.substr(offset, length));
+    }
+    // Участок потокового файла на границе порций (по 1048 блоков)
+    ASSERT_EQ(harchiver.ReadRange("tmp/testarc.haf", "stream.txt", 
+        1048 * 1000 - 3, 3000, buffer.data(), read_size), HamArchiver::ExtractionResult::kSuccess);
+    ASSERT_EQ(std::string(buffer.begin(), buffer.begin() + read_size), 
+        doubled.substr(1048 * 1000 - 3, 3000));
+    // Участок через несколько порций передаётся получателю по блокам
+    std::string streamed;
+    size_t parts = 0;
+    ASSERT_EQ(harchiver.ReadRange("tmp/testarc.haf", "stream.txt", 500, 1200000, 
+        [&streamed, &parts](const uint8_t* data, size_t size) {
+            streamed.append(reinterpret_cast<const char*>(data), size);
+            ++parts;
+            return true;
+        }), HamArchiver::ExtractionResult::kSuccess);
+    ASSERT_EQ(streamed, doubled.substr(500, 1200000));
+    ASSERT_GT(parts, 1);
+
+    // Двойная ошибка в блоке 200: читаются только данные до него
+    std::string arc;
+    {
+        std::ifstream arc_reader(TestingDir / "tmp/testarc.haf", std::ifstream::binary);
+        arc.assign(std::istreambuf_iterator<char>(arc_reader), std::istreambuf_iterator<char>());
+    }
+    size_t block_pos = arc.find(text.substr(200 * 1000, 64));
+    std::fstream stream(TestingDir / "tmp/testarc.haf", 
+        std::fstream::in | std::fstream::out | std::fstream::binary);
+    MakeBitError(stream, block_pos * 8 + 1);
+    MakeBitError(stream, block_pos * 8 + 10);
+    stream.close();
+    ASSERT_EQ(harchiver.ReadRange("tmp/testarc.haf", "Лев_Толстой._Война_и_мир._Том_I.txt", 
+        199 * 1000 + 500, 2000, buffer.data(), read_size), HamArchiver::ExtractionResult::kFileCorrupted);
+    ASSERT_EQ(read_size, 500);
+    fo.DeleteDir("tmp");
+}
+
+TEST(BlockCacheTestSuite, EvictionTest) {
+    BlockCache cache;
+    uint8_t block[100];
+    uint8_t out[100];
+    cache.Put(1, 0, block, 100);
+    ASSERT_FALSE(cache.Get(1, 0, out, 100));
+
+    // По 1000 байт на каждый из 16 сегментов
+    cache.SetCapacity(16 * 1000);
+    uint64_t id = cache.GetArchiveId("/arc.haf", 100, std::filesystem::file_time_type{});
+    ASSERT_EQ(cache.GetArchiveId("/arc.haf", 100, std::filesystem::file_time_type{}), id);
+    for (size_t i = 0; i < 1000; ++i) {
+        std::fill(block, block + 100, static_cast<uint8_t>(i));
+        cache.Put(id, i * 109, block, 100);
+    }
+    // В кэше остаются лишь последние добавленные блоки: не больше 10 на сегмент
+    size_t cached = 0;
+    for (size_t i = 0; i < 1000; ++i) {
+        if (cache.Get(id, i * 109, out, 100)) {
+            ASSERT_EQ(out[0], static_cast<uint8_t>(i));
+            ++cached;
+        }
+    }
+    ASSERT_LE(cached, 160);
+    ASSERT_GT(cached, 0);
+    ASSERT_TRUE(cache.Get(id, 999 * 109, out, 100));
+
+    // Изменённый архив получает новый идентификатор
+    uint64_t new_id = cache.GetArchiveId("/arc.haf", 200, std::filesystem::file_time_type{});
+    ASSERT_NE(new_id, id);
+    ASSERT_FALSE(cache.Get(new_id, 999 * 109, out, 100));
+    cache.Invalidate("/arc.haf");
+    ASSERT_NE(cache.GetArchiveId("/arc.haf", 200, std::filesystem::file_time_type{}), new_id);
+}
+
+TEST(BlockCacheTestSuite, ArchiverCacheTest) {
+    fo.CreateDir("tmp");
+    HamArchiver harchiver(TestingDir);
+    harchiver.Create("tmp/testarc.haf", {{"Лев_Толстой._Война_и_мир._Том_I.txt", 0, 1000}});
+    harchiver.SetBlockCacheSize(1024 * 1024);
+    harchiver.SetMetricsEnabled(true);
+    std::vector<uint8_t> buffer(10000);
+    size_t read_size;
+    harchiver.ReadRange("tmp/testarc.haf", "Лев_Толстой._Война_и_мир._Том_I.txt", 
+        5000, 10000, buffer.data(), read_size);
+    ASSERT_EQ(harchiver.GetMetrics().Get(Metrics::Counter::kCacheMisses), 10);
+    ASSERT_EQ(harchiver.GetMetrics().Get(Metrics::Counter::kCacheHits), 0);
+
+    // Повторное чтение не проверяет блоки
+    size_t validated = harchiver.GetMetrics().Get(Metrics::Counter::kBlocksValidated);
+    std::vector<uint8_t> cached_buffer(10000);
+    harchiver.ReadRange("tmp/testarc.haf", "Лев_Толстой._Война_и_мир._Том_I.txt", 
+        5000, 10000, cached_buffer.data(), read_size);
+    ASSERT_EQ(harchiver.GetMetrics().Get(Metrics::Counter::kCacheHits), 10);
+    ASSERT_EQ(cached_buffer, buffer);
+    size_t index_blocks = harchiver.GetMetrics().Get(Metrics::Counter::kBlocksValidated) - validated;
+
+    // Извлечение берёт блоки из кэша, остальные блоки проверяются и кэшируются
+    std::ostringstream out;
+    validated = harchiver.GetMetrics().Get(Metrics::Counter::kBlocksValidated);
+    ASSERT_EQ(harchiver.ExtractTo("tmp/testarc.haf", "Лев_Толстой._Война_и_мир._Том_I.txt", out), 
+        HamArchiver::ExtractionResult::kSuccess);
+    size_t blocks_count = (fo.GetFileSize("Лев_Толстой._Война_и_мир._Том_I.txt") + 999) / 1000;
+    ASSERT_EQ(harchiver.GetMetrics().Get(Metrics::Counter::kBlocksValidated) - validated, 
+        index_blocks + blocks_count - 10);
+    std::ifstream original(TestingDir / "Лев_Толстой._Война_и_мир._Том_I.txt", std::ios::binary);
+    ASSERT_TRUE(out.str() == std::string(std::istreambuf_iterator<char>(original), 
+        std::istreambuf_iterator<char>()));
+
+    // После изменения архива блоки проверяются заново
+    harchiver.AppendFiles("tmp/testarc.haf", {{"file_1.txt", 0, 10}});
+    size_t hits = harchiver.GetMetrics().Get(Metrics::Counter::kCacheHits);
+    harchiver.ReadRange("tmp/testarc.haf", "Лев_Толстой._Война_и_мир._Том_I.txt", 
+        5000, 10000, cached_buffer.data(), read_size);
+    ASSERT_EQ(harchiver.GetMetrics().Get(Metrics::Counter::kCacheHits), hits);
+    ASSERT_EQ(cached_buffer, buffer);
+    fo.DeleteDir("tmp");
+}
+
+TEST(VerificationTestSuite, VerificationTest) {
+    fo.CreateDir("tmp");
+    HamArchiver harchiver(TestingDir);
+    harchiver.SetThreads(4);
+    harchiver.Create("tmp/testarc.haf", 
+        {{"Лев_Толстой._Война_и_мир._Том_I.txt", 0, 1000}, {"file_1.txt", 0, 10}});
+    std::string data(3 * 1024 * 1024 + 7, 'a');
+    std::istringstream reader(data);
+    harchiver.AppendStream("tmp/testarc.haf", {"stream.txt", 0, 4096}, reader);
+
+    HamArchiver::VerificationReport report;
+    ASSERT_EQ(harchiver.Verify("tmp/testarc.haf", report), HamArchiver::VerificationResult::kSuccess);
+    ASSERT_EQ(report.entries.size(), 3);
+    // Блоки содержимого и два блока метаданных; у файла из потока - ещё заголовки 4 порций и завершающей
+    size_t text_size = fo.GetFileSize("Лев_Толстой._Война_и_мир._Том_I.txt");
+    ASSERT_EQ(report.entries[0].blocks.clean, (text_size + 999) / 1000 + 2);
+    ASSERT_EQ(report.entries[1].blocks.clean, 6 + 2);
+    ASSERT_EQ(report.entries[2].blocks.clean, (data.size() + 4095) / 4096 + 2 + 5);
+    ASSERT_EQ(report.index.clean, 2);
+
+    // Одиночные ошибки исправимы, двойная ошибка в блоке - нет
+    std::string arc;
+    {
+        std::ifstream arc_reader(TestingDir / "tmp/testarc.haf", std::ifstream::binary);
+        arc.assign(std::istreambuf_iterator<char>(arc_reader), std::istreambuf_iterator<char>());
+    }
+    std::fstream stream(TestingDir / "tmp/testarc.haf", 
+        std::fstream::in | std::fstream::out | std::fstream::binary);
+    MakeBitError(stream, 100 * 8);
+    MakeBitError(stream, 500000 * 8 + 3);
+    MakeBitError(stream, 500000 * 8 + 4);
+    MakeBitError(stream, (arc.size() - 1000) * 8);
+    stream.close();
+    std::ifstream arc_reader(TestingDir / "tmp/testarc.haf", std::ifstream::binary);
+    std::string damaged{std::istreambuf_iterator<char>(arc_reader), std::istreambuf_iterator<char>()};
+    arc_reader.close();
+
+    ASSERT_EQ(harchiver.Verify("tmp/testarc.haf", report), HamArchiver::VerificationResult::kFileCorrupted);
+    ASSERT_EQ(report.entries[0].blocks.corrected, 1);
+    ASSERT_EQ(report.entries[0].blocks.corrupted, 1);
+    ASSERT_EQ(report.entries[2].blocks.corrected, 1);
+    ASSERT_EQ(report.entries[0].blocks.clean + report.entries[0].blocks.corrected 
+        + report.entries[0].blocks.corrupted, (text_size + 999) / 1000 + 2);
+    // Архив не изменяется
+    arc_reader.open(TestingDir / "tmp/testarc.haf", std::ifstream::binary);
+    ASSERT_TRUE(damaged == std::string(std::istreambuf_iterator<char>(arc_reader), 
+        std::istreambuf_iterator<char>()));
+    ASSERT_EQ(harchiver.Verify("tmp/missing.haf", report), HamArchiver::VerificationResult::kArcNotFound);
+    fo.DeleteDir("tmp");
+}
+
+TEST(ScrubTestSuite, ScrubTest) {
+    fo.CreateDir("tmp");
+    HamArchiver harchiver(TestingDir);
+    harchiver.Create("tmp/testarc.haf", 
+        {{"Лев_Толстой._Война_и_мир._Том_I.txt", 0, 1000}, {"file_1.txt", 0, 10}});
+    std::string original;
+    {
+        std::ifstream arc_reader(TestingDir / "tmp/testarc.haf", std::ifstream::binary);
+        original.assign(std::istreambuf_iterator<char>(arc_reader), std::istreambuf_iterator<char>());
+    }
+
+    // Ошибки соседних блоков записываются одной операцией
+    std::fstream stream(TestingDir / "tmp/testarc.haf", 
+        std::fstream::in | std::fstream::out | std::fstream::binary);
+    MakeBitError(stream, 100 * 8);
+    MakeBitError(stream, 200000 * 8 + 1);
+    MakeBitError(stream, 203000 * 8 + 2);
+    MakeBitError(stream, (original.size() - 10) * 8);
+    stream.close();
+
+    HamArchiver::ScrubOptions options;
+    options.idle_priority = true;
+    std::vector<HamArchiver::ScrubReport> reports;
+    std::vector<HamArchiver::ScrubResult> results = harchiver.Scrub(
+        {"tmp/testarc.haf", "tmp/missing.haf"}, options, reports);
+    ASSERT_EQ(results[0], HamArchiver::ScrubResult::kSuccess);
+    ASSERT_EQ(results[1], HamArchiver::ScrubResult::kArcNotFound);
+    ASSERT_EQ(reports[0].blocks.corrected, 4);
+    ASSERT_EQ(reports[0].blocks.corrupted, 0);
+    ASSERT_EQ(reports[0].writes, 3);
+    ASSERT_EQ(reports[0].bytes_read, original.size());
+    ASSERT_FALSE(fo.FileExists("tmp/testarc.haf.scrub"));
+    {
+        std::ifstream arc_reader(TestingDir / "tmp/testarc.haf", std::ifstream::binary);
+        ASSERT_TRUE(original == std::string(std::istreambuf_iterator<char>(arc_reader), 
+            std::istreambuf_iterator<char>()));
+    }
+
+    // Двойная ошибка остаётся, исправленная проверка повторно ничего не пишет
+    stream.open(TestingDir / "tmp/testarc.haf", std::fstream::in | std::fstream::out | std::fstream::binary);
+    MakeBitError(stream, 300000 * 8 + 3);
+    MakeBitError(stream, 300000 * 8 + 4);
+    stream.close();
+    HamArchiver::ScrubReport report;
+    ASSERT_EQ(harchiver.Scrub("tmp/testarc.haf", options, report), 
+        HamArchiver::ScrubResult::kFileCorrupted);
+    ASSERT_EQ(report.blocks.corrupted, 1);
+    ASSERT_EQ(report.writes, 0);
+    fo.DeleteDir("tmp");
+}
+
+enum class StorageBackend {
+    kStream,
+    kFd,
+    kMapped,
+    kUring,
+    kDirect,
+    kMemory
+};
+
+static std::shared_ptr<FileOperator> MakeStorage(StorageBackend backend, std::filesystem::path dir) {
+    switch (backend) {
+        case StorageBackend::kStream:
+            return std::make_shared<StreamFileOperator>(dir);
+        case StorageBackend::kFd:
+            return std::make_shared<FdFileOperator>(dir);
+        case StorageBackend::kMapped:
+            return std::make_shared<MappedFileOperator>(dir);
+        case StorageBackend::kUring:
+            return std::make_shared<UringFileOperator>(dir);
+        case StorageBackend::kDirect:
+            return std::make_shared<DirectFileOperator>(dir);
+        default:
+            return std::make_shared<MemoryFileOperator>(dir);
+    }
+}
+
+static void WriteStorageFile(FileOperator& storage, std::filesystem::path file, const std::string& data) {
+    FileStream writer;
+    ASSERT_TRUE(storage.OpenForWriting(file, writer, std::ios::trunc | std::ios::binary));
+    writer.write(data.data(), data.size());
+}
+
+static std::string ReadStorageFile(FileOperator& storage, std::filesystem::path file) {
+    FileStream reader;
+    storage.OpenForReading(file, reader, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(reader), std::istreambuf_iterator<char>());
+}
+
+class StorageBackendTestSuite : public testing::TestWithParam<StorageBackend> {};
+
+TEST_P(StorageBackendTestSuite, RoundTripTest) {
+    fo.CreateDir("tmp");
+    std::shared_ptr<FileOperator> storage = MakeStorage(GetParam(), TestingDir / "tmp");
+    std::string big(300000, 0);
+    for (size_t i = 0; i < big.size(); ++i) {
+        big[i] = static_cast<char>(i * 7 + i / 1000);
+    }
+    WriteStorageFile(*storage, "big.bin", big);
+    WriteStorageFile(*storage, "small.txt", "hello");
+
+    HamArchiver harchiver(storage);
+    harchiver.SetThreads(2);
+    ASSERT_EQ(harchiver.Create("arc.haf", {{"big.bin", 0, 1000}, {"small.txt", 0, 10}}), 
+        std::vector<HamArchiver::CreationResult>(2, HamArchiver::CreationResult::kSuccess));
+    std::string streamed(2 * 1024 * 1024 + 5, 's');
+    std::istringstream reader(streamed);
+    ASSERT_EQ(harchiver.AppendStream("arc.haf", {"stream.txt", 0, 4096}, reader), 
+        HamArchiver::AdditionResult::kSuccess);
+    harchiver.DeleteFiles("arc.haf", {"small.txt"});
+    ASSERT_EQ(harchiver.Vacuum("arc.haf", 0), HamArchiver::VacuumResult::kSuccess);
+    HamArchiver::VerificationReport report;
+    ASSERT_EQ(harchiver.Verify("arc.haf", report), HamArchiver::VerificationResult::kSuccess);
+    ASSERT_EQ(report.entries.size(), 2);
+
+    storage->DeleteFile("big.bin");
+    storage->DeleteFile("small.txt");
+    ASSERT_EQ(harchiver.ExtractFiles("arc.haf"), 
+        std::vector<HamArchiver::ExtractionResult>(2, HamArchiver::ExtractionResult::kSuccess));
+    ASSERT_TRUE(ReadStorageFile(*storage, "big.bin") == big);
+    ASSERT_TRUE(ReadStorageFile(*storage, "stream.txt") == streamed);
+    ASSERT_FALSE(storage->FileExists("small.txt"));
+    // Файловая система в памяти не обращается к диску
+    ASSERT_EQ(fo.FileExists("tmp/arc.haf"), GetParam() != StorageBackend::kMemory);
+    fo.DeleteDir("tmp");
+}
+
+TEST_P(StorageBackendTestSuite, OverlappingWritesTest) {
+    fo.CreateDir("tmp");
+    std::shared_ptr<FileOperator> storage = MakeStorage(GetParam(), TestingDir / "tmp");
+    std::string expected(1000000, 0);
+    size_t file_size = 0;
+    FileStream file;
+    ASSERT_TRUE(storage->Open("file.bin", file, std::ios::in | std::ios::out | std::ios::trunc | std::ios::binary));
+    // Записи перекрывают друг друга и чередуются с чтением только что записанного
+    for (size_t i = 0; i < 40; ++i) {
+        size_t offset = (i * 389231) % 900000;
+        std::string part(100000 + i * 1000, static_cast<char>('a' + i % 26));
+        expected.replace(offset, part.size(), part);
+        file_size = std::max(file_size, offset + part.size());
+        file.seekp(offset);
+        file.write(part.data(), part.size());
+        std::string read(part.size(), 0);
+        file.seekg(offset);
+        file.read(read.data(), read.size());
+        ASSERT_TRUE(read == part);
+    }
+    file.Close();
+    ASSERT_TRUE(file.good());
+    ASSERT_EQ(storage->GetFileSize("file.bin"), file_size);
+    ASSERT_TRUE(ReadStorageFile(*storage, "file.bin") == expected.substr(0, file_size));
+    fo.DeleteDir("tmp");
+}
+
+TEST_P(StorageBackendTestSuite, ParallelWritesTest) {
+    // Части файла и копируемые архивы не выровнены по блокам диска, 
+    // поэтому потоки дописывают общие крайние блоки
+    fo.CreateDir("tmp");
+    std::shared_ptr<FileOperator> storage = MakeStorage(GetParam(), TestingDir / "tmp");
+    std::string big(6 * 1024 * 1024 + 777, 0);
+    for (size_t i = 0; i < big.size(); ++i) {
+        big[i] = static_cast<char>(i * 13 + i / 4093);
+    }
+    WriteStorageFile(*storage, "big.bin", big);
+    HamArchiver harchiver(storage);
+    harchiver.SetThreads(6);
+    ASSERT_EQ(harchiver.Create("arc.haf", {{"big.bin", 0, 1000}})[0], HamArchiver::CreationResult::kSuccess);
+    for (size_t i = 0; i < 3; ++i) {
+        storage->DeleteFile("big.bin");
+        ASSERT_EQ(harchiver.ExtractFiles("arc.haf"), 
+            std::vector<HamArchiver::ExtractionResult>{HamArchiver::ExtractionResult::kSuccess});
+        ASSERT_TRUE(ReadStorageFile(*storage, "big.bin") == big);
+    }
+
+    std::vector<std::string> arcfiles;
+    for (size_t i = 0; i < 8; ++i) {
+        std::string name = "part_" + std::to_string(i) + ".bin";
+        WriteStorageFile(*storage, name, big.substr(i * 10007, 5000 + i * 3001));
+        arcfiles.push_back("part_" + std::to_string(i) + ".haf");
+        ASSERT_EQ(harchiver.Create(arcfiles.back(), {{name, 0, 100 + i}})[0], 
+            HamArchiver::CreationResult::kSuccess);
+    }
+    ASSERT_EQ(harchiver.Merge("merged.haf", arcfiles), 
+        std::vector<HamArchiver::ConcatenationResult>(8, HamArchiver::ConcatenationResult::kSuccess));
+    HamArchiver::VerificationReport report;
+    ASSERT_EQ(harchiver.Verify("merged.haf", report), HamArchiver::VerificationResult::kSuccess);
+    ASSERT_EQ(report.entries.size(), 8);
+    fo.DeleteDir("tmp");
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Group,
+    StorageBackendTestSuite,
+    testing::Values(StorageBackend::kStream, StorageBackend::kFd, 
+        StorageBackend::kMapped, StorageBackend::kUring, StorageBackend::kDirect, StorageBackend::kMemory)
+);
+
+// Поток вывода без перемещения и позиции, как канал
+class SinkBuf : public std::streambuf {
+public:
+    SinkBuf(std::string& data) : data_(data) {}
+
+protected:
+    int_type overflow(int_type ch) override {
+        if (ch != traits_type::eof()) {
+            data_.push_back(traits_type::to_char_type(ch));
+        }
+        return ch;
+    }
+
+    std::streamsize xsputn(const char* s, std::streamsize count) override {
+        data_.append(s, count);
+        return count;
+    }
+
+private:
+    std::string& data_;
+};
+
+TEST(ForwardOnlyOutputTestSuite, ForwardOnlyOutputTest) {
+    fo.CreateDir("tmp");
+    HamArchiver harchiver(TestingDir);
+    const std::vector<HamArchiver::FileMetadata> files{
+        {"file_1.txt", 0, 10}, {"file_4.txt", 0, 10}, {"file_2.txt", 0, 37}
+    };
+    harchiver.Create("tmp/testarc.haf", files);
+
+    std::string data;
+    SinkBuf sink_buf(data);
+    std::ostream writer(&sink_buf);
+    auto exit_codes = harchiver.Create(writer, files);
+    const std::vector<HamArchiver::CreationResult> expected{
+        HamArchiver::CreationResult::kSuccess,
+        HamArchiver::CreationResult::kFileNotFound,
+        HamArchiver::CreationResult::kSuccess
+    };
+    ASSERT_EQ(exit_codes, expected);
+    // Архив в потоке совпадает с архивом, записанным в файл
+    std::ifstream arc_reader(TestingDir / "tmp/testarc.haf", std::ifstream::binary);
+    std::string arc{std::istreambuf_iterator<char>(arc_reader), std::istreambuf_iterator<char>()};
+    ASSERT_TRUE(data == arc);
+
+    data.clear();
+    std::istringstream reader("streamed data");
+    ASSERT_EQ(harchiver.CreateFromStream(writer, {"stream.txt", 0, 4}, reader), 
+        HamArchiver::CreationResult::kSuccess);
+    {
+        std::ofstream arc_writer(TestingDir / "tmp/streamed.haf", std::ofstream::binary);
+        arc_writer << data;
+    }
+    std::ostringstream out;
+    ASSERT_EQ(harchiver.ExtractTo("tmp/streamed.haf", "stream.txt", out), 
+        HamArchiver::ExtractionResult::kSuccess);
+    ASSERT_EQ(out.str(), "streamed data");
+
+    writer.setstate(std::ios::badbit);
+    ASSERT_EQ(harchiver.Create(writer, files)[0], HamArchiver::CreationResult::kWriteError);
+    fo.DeleteDir("tmp");
+}
+
+TEST(ParallelExtractionTestSuite, ParallelExtractionTest) {
+    // Файл из нескольких частей по kExtractionChunkSize байт
+    fo.CreateDir("tmp/out");
+    {
+        std::ifstream source(TestingDir / "Лев_Толстой._Война_и_мир._Том_I.txt", std::ifstream::binary);
+        std::ofstream big(TestingDir / "tmp/big.txt", std::ofstream::binary);
+        for (size_t i = 0; i < 3; ++i) {
+            source.clear();
+            source.seekg(0, std::ifstream::beg);
+            big << source.rdbuf();
+        }
+    }
+    HamArchiver harchiver(TestingDir);
+    harchiver.Create("tmp/testarc.haf", 
+        {{"file_2.txt", 0, 37}, {"tmp/big.txt", 0, 4096}, {"file_3.txt", 0, 100}});
+    size_t arc_size = fo.GetFileSize("tmp/testarc.haf");
+    // Двойная ошибка в первом блоке file_2.txt и одиночные ошибки в частях big.txt
+    std::fstream stream(TestingDir / "tmp/testarc.haf", 
+        std::fstream::in | std::fstream::out | std::fstream::binary);
+    MakeBitError(stream, 33 * 8 + 3);
+    MakeBitError(stream, 33 * 8 + 5);
+    stream.close();
+    MakeErrors("tmp/testarc.haf", {arc_size / 4, arc_size / 2, arc_size * 3 / 4});
+
+    harchiver.SetDir(TestingDir / "tmp/out");
+    harchiver.SetThreads(4);
+    auto exit_codes = harchiver.ExtractFiles("../testarc.haf", 
+        {"big.txt", "file_2.txt", "file_3.txt", "file_1.txt"});
+    const std::vector<HamArchiver::ExtractionResult> expected{
+        HamArchiver::ExtractionResult::kSuccess,
+        HamArchiver::ExtractionResult::kFileCorrupted,
+        HamArchiver::ExtractionResult::kSuccess,
+        HamArchiver::ExtractionResult::kFileNotFound
+    };
+    ASSERT_EQ(exit_codes, expected);
+    ASSERT_TRUE(fc.Equals("tmp/big.txt", "tmp/out/big.txt"));
+    ASSERT_TRUE(fc.Equals("file_3.txt", "tmp/out/file_3.txt"));
+    ASSERT_FALSE(fo.FileExists("tmp/out/file_2.txt"));
+
+    // Результаты совпадают с последовательным извлечением
+    fo.DeleteDir("tmp/out");
+    fo.CreateDir("tmp/out");
+    harchiver.SetThreads(1);
+    ASSERT_EQ(harchiver.ExtractFiles("../testarc.haf", 
+        {"big.txt", "file_2.txt", "file_3.txt", "file_1.txt"}), expected);
+    ASSERT_TRUE(fc.Equals("tmp/big.txt", "tmp/out/big.txt"));
+    fo.DeleteDir("tmp");
+}
+
+static size_t GetEncodedSize(size_t size, size_t block_size) {
+    size_t res = size + (size / block_size) * (Encoder::GetCodeBitSize(block_size * 8) / 8 + 1);
+    if (size % block_size != 0) {
+        res += Encoder::GetCodeBitSize((size % block_size) * 8) / 8 + 1;
+    }
+    return res;
+}
+
+static size_t GetEntrySize(std::filesystem::path file, size_t block_size) {
+    return GetEncodedSize(20, 20) + GetEncodedSize(file.string().size(), file.string().size()) 
+        + GetEncodedSize(fo.GetFileSize(file), block_size);
+}
+
+TEST(ParallelExtractionTestSuite, CorruptedEntryKeepsExistingFileTest) {
+    fo.CreateDir("tmp");
+    {
+        std::ofstream data(TestingDir / "tmp/data.bin", std::ofstream::binary);
+        data << std::string(1000, 'x');
+        std::ofstream user_data(TestingDir / "tmp/user_data.bin", std::ofstream::binary);
+        user_data << "user data";
+    }
+    HamArchiver harchiver(TestingDir / "tmp");
+    harchiver.SetWriteIndex(false);
+    harchiver.Create("arc.haf", {{"data.bin", 0, 100}});
+    // Двойная ошибка в данных последнего блока
+    size_t arc_size = fo.GetFileSize("tmp/arc.haf");
+    std::fstream stream(TestingDir / "tmp/arc.haf", 
+        std::fstream::in | std::fstream::out | std::fstream::binary);
+    MakeBitError(stream, (arc_size - 60) * 8);
+    MakeBitError(stream, (arc_size - 60) * 8 + 1);
+    stream.close();
+
+    for (size_t threads : {1, 4}) {
+        std::filesystem::copy_file(TestingDir / "tmp/user_data.bin", TestingDir / "tmp/data.bin", 
+            std::filesystem::copy_options::overwrite_existing);
+        harchiver.SetThreads(threads);
+        ASSERT_EQ(harchiver.ExtractFiles("arc.haf"), 
+            std::vector<HamArchiver::ExtractionResult>{HamArchiver::ExtractionResult::kFileCorrupted});
+        ASSERT_TRUE(fc.Equals("tmp/data.bin", "tmp/user_data.bin"));
+        ASSERT_FALSE(fo.FileExists("tmp/data.bin.hamarc-part"));
+    }
+    fo.DeleteDir("tmp");
+}
+
+TEST(VacuumTestSuite, VacuumTest) {
+    HamArchiver harchiver(TestingDir);
+    fo.CreateDir("tmp");
+    const std::vector<HamArchiver::FileMetadata> file_list{
+        {"file_1.txt", 0, 10}, {"file_2.txt", 0, 37}, {"file_3.txt", 0, 100}
+    };
+    harchiver.Create("tmp/testarc.haf", file_list);
+    harchiver.Create("tmp/expected.haf", {{"file_2.txt", 0, 37}, {"file_3.txt", 0, 100}});
+    size_t arc_size = fo.GetFileSize("tmp/testarc.haf");
+
+    // Удаление не меняет размер архива
+    auto exit_codes = harchiver.DeleteFiles("tmp/testarc.haf", {"file_1.txt", "file_4.txt"});
+    ASSERT_EQ(exit_codes[0], HamArchiver::ExtractionResult::kSuccess);
+    ASSERT_EQ(exit_codes[1], HamArchiver::ExtractionResult::kFileNotFound);
+    ASSERT_EQ(fo.GetFileSize("tmp/testarc.haf"), arc_size);
+    ExpectFileList(harchiver, "tmp/testarc.haf", {"file_2.txt", "file_3.txt"});
+    exit_codes = harchiver.DeleteFiles("tmp/testarc.haf", {"file_1.txt"});
+    ASSERT_EQ(exit_codes[0], HamArchiver::ExtractionResult::kFileNotFound);
+    std::filesystem::copy_file(TestingDir / "tmp/testarc.haf", TestingDir / "tmp/interrupted.haf");
+
+    ASSERT_EQ(harchiver.Vacuum("tmp/testarc.haf", 0.99), HamArchiver::VacuumResult::kBelowThreshold);
+    ASSERT_EQ(harchiver.Vacuum("tmp/testarc.haf", 0.1), HamArchiver::VacuumResult::kSuccess);
+    ASSERT_TRUE(fc.Equals("tmp/testarc.haf", "tmp/expected.haf"));
+    ASSERT_FALSE(fo.FileExists("tmp/testarc.haf.vacuum"));
+
+    // Сбой во время переноса file_2.txt и file_3.txt, перекрывающих свой источник:
+    // порция сохранена в контрольной точке, а архив частично перезаписан
+    size_t dst = 0;
+    size_t src = GetEntrySize("file_1.txt", 10);
+    size_t pending_size = GetEntrySize("file_2.txt", 37) + GetEntrySize("file_3.txt", 100);
+    size_t entries_end = src + pending_size;
+    ASSERT_GT(dst + pending_size, src);
+    uint8_t* pending = new uint8_t[pending_size];
+    {
+        std::fstream stream(TestingDir / "tmp/interrupted.haf", 
+            std::fstream::in | std::fstream::out | std::fstream::binary);
+        stream.seekg(src, std::fstream::beg);
+        stream.read(reinterpret_cast<char*>(pending), pending_size);
+        stream.seekp(dst, std::fstream::beg);
+        stream.write(std::string(pending_size / 2, '\0').data(), pending_size / 2);
+    }
+    uint8_t header[32];
+    const size_t values[4]{entries_end, src, dst, pending_size};
+    for (size_t i = 0; i < 32; ++i) {
+        header[i] = (values[i / 8] >> (8 * (i % 8))) & 0b11111111;
+    }
+    {
+        std::ofstream checkpoint(TestingDir / "tmp/interrupted.haf.vacuum", std::ofstream::binary);
+        checkpoint.write(reinterpret_cast<char*>(header), 32);
+        Encoder::EncodeAndWrite(header, checkpoint, 32);
+        checkpoint.write(reinterpret_cast<char*>(pending), pending_size);
+    }
+    delete [] pending;
+
+    // Прерванное уплотнение продолжается независимо от порога
+    ASSERT_EQ(harchiver.Vacuum("tmp/interrupted.haf", 0.99), HamArchiver::VacuumResult::kSuccess);
+    ASSERT_TRUE(fc.Equals("tmp/interrupted.haf", "tmp/expected.haf"));
+    ASSERT_FALSE(fo.FileExists("tmp/interrupted.haf.vacuum"));
+
+    // Архив без оставшихся файлов удаляется
+    harchiver.DeleteFiles("tmp/testarc.haf", {"file_2.txt", "file_3.txt"});
+    ASSERT_EQ(harchiver.Vacuum("tmp/testarc.haf", 0), HamArchiver::VacuumResult::kSuccess);
+    ASSERT_FALSE(fo.FileExists("tmp/testarc.haf"));
+    fo.DeleteDir("tmp");
+}
+
+TEST(VacuumTestSuite, CheckpointWriteFailureTest) {
+    HamArchiver harchiver(TestingDir);
+    fo.CreateDir("tmp");
+    harchiver.Create("tmp/testarc.haf", {{"file_1.txt", 0, 10}, {"file_2.txt", 0, 37}, {"file_3.txt", 0, 100}});
+    harchiver.Create("tmp/expected.haf", {{"file_2.txt", 0, 37}, {"file_3.txt", 0, 100}});
+    harchiver.DeleteFiles("tmp/testarc.haf", {"file_1.txt"});
+    std::filesystem::copy_file(TestingDir / "tmp/testarc.haf", TestingDir / "tmp/deleted.haf");
+
+    // Директория на месте временного файла контрольной точки: запись не удаётся, 
+    // и архив не изменяется
+    fo.CreateDir("tmp/testarc.haf.vacuum.tmp");
+    ASSERT_EQ(harchiver.Vacuum("tmp/testarc.haf", 0), HamArchiver::VacuumResult::kWriteError);
+    ASSERT_TRUE(fc.Equals("tmp/testarc.haf", "tmp/deleted.haf"));
+    ASSERT_FALSE(fo.FileExists("tmp/testarc.haf.vacuum"));
+
+    fo.DeleteDir("tmp/testarc.haf.vacuum.tmp");
+    ASSERT_EQ(harchiver.Vacuum("tmp/testarc.haf", 0), HamArchiver::VacuumResult::kSuccess);
+    ASSERT_TRUE(fc.Equals("tmp/testarc.haf", "tmp/expected.haf"));
+    fo.DeleteDir("tmp");
+}